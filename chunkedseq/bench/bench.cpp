@@ -13,9 +13,16 @@
 
 #include <functional>
 #include <random>
+#include <type_traits>
 #include <algorithm>
 #include <assert.h>
 #include <unordered_map>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 #include "cmdline.hpp"
 #include "atomic.hpp"
@@ -26,7 +33,10 @@
 #include "fixedcapacity.hpp"
 #include "chunkedseq.hpp"
 #include "chunkedbag.hpp"
+#include "persistentseq.hpp"
 #include "map.hpp"
+#include "orderedmap.hpp"
+#include "smallseq.hpp"
 
 #ifdef USE_MALLOC_COUNT
 #include "malloc_count.h"
@@ -51,6 +61,55 @@ void failwith(std::string s) {
 result_t res = 0;
 double exec_time;
 
+/*---------------------------------------------------------------------*/
+// hardware counters
+
+/* With -dtlb_misses 1, the scenarios that report it count the misses
+ * of the data TLB over the same span as exec_time; the count is
+ * printed only where the kernel grants access to the counter.
+ */
+
+long long dtlb_misses = -1;
+
+class dtlb_counter {
+private:
+  int fd = -1;
+public:
+  void start() {
+    #ifdef __linux__
+    if (! cmdline::parse_or_default_bool("dtlb_misses", false, false))
+      return;
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB
+      | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+      | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd < 0)
+      return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    #endif
+  }
+  void stop() {
+    #ifdef __linux__
+    if (fd < 0)
+      return;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    long long count;
+    if (read(fd, &count, sizeof(count)) == sizeof(count))
+      dtlb_misses = count;
+    close(fd);
+    fd = -1;
+    #endif
+  }
+};
+
 /*---------------------------------------------------------------------*/
 
 /*
@@ -156,6 +215,144 @@ void shuffle(Datastruct& d) {
     std::swap(d[i], d[rand() % sz]);
 }
 
+/*---------------------------------------------------------------------*/
+/* Operations that the containers offer under different forms
+ *
+ * The generic versions apply to the chunked sequences; the overloads
+ * give the closest equivalent for the STL containers.
+ */
+
+template <class Datastruct, class Body>
+void for_each_item(Datastruct& d, const Body& f) {
+  d.for_each(f);
+}
+
+/* applies `f` to each range `[lo, hi)` of items that are contiguous
+ * in memory
+ */
+template <class Datastruct, class Body>
+void for_each_segment(Datastruct& d, const Body& f) {
+  d.for_each_segment(f);
+}
+
+template <class Item, class Body>
+void for_each_segment(data::stl::vector_seq<Item>& d, const Body& f) {
+  f(d.vec.data(), d.vec.data() + d.size());
+}
+
+// std::deque does not expose its blocks: each item makes a segment
+template <class Item, class Body>
+void for_each_segment(data::stl::deque_seq<Item>& d, const Body& f) {
+  for (auto it = d.deque.begin(); it != d.deque.end(); it++)
+    f(&*it, &*it + 1);
+}
+
+#ifdef HAVE_ROPE
+// the for_each of the rope passes the index along with the item
+template <class Item, class Body>
+void for_each_item(data::stl::rope_seq<Item>& d, const Body& f) {
+  for (auto it = d.v.begin(); it != d.v.end(); it++)
+    f(*it);
+}
+
+template <class Item, class Body>
+void for_each_segment(data::stl::rope_seq<Item>& d, const Body& f) {
+  for_each_item(d, [&] (const Item& x) {
+    f(&x, &x + 1);
+  });
+}
+#endif
+
+template <class Datastruct>
+void insert_at(Datastruct& d, size_t i, const typename Datastruct::value_type& x) {
+  d.insert(d.begin() + i, x);
+}
+
+template <class Datastruct>
+void erase_at(Datastruct& d, size_t i) {
+  auto it = d.begin() + i;
+  d.erase(it, it + 1);
+}
+
+// the bag has no erase: the item is taken out by a split
+template <class Configuration, template <class, class> class Iterator>
+void erase_at(chunkedseq::chunkedbagbase<Configuration, Iterator>& d, size_t i) {
+  chunkedseq::chunkedbagbase<Configuration, Iterator> other;
+  d.split(i, other);
+  other.pop_front();
+  d.concat(other);
+}
+
+/* The scenarios that move iterators around apply to the containers
+ * that have iterators.
+ */
+template <class Datastruct>
+struct has_iterators : std::true_type { };
+
+template <class Item, int Chunk_capacity, class Cache,
+          template <class, int, class> class Chunk_struct, class Item_alloc>
+struct has_iterators<chunkedseq::persistent::deque<Item, Chunk_capacity, Cache, Chunk_struct, Item_alloc>>
+  : std::false_type { };
+
+template <class Seq, int Nb_inline>
+struct has_iterators<chunkedseq::small::sequence<Seq, Nb_inline>> : std::false_type { };
+
+/* Weights of the items, for the weighted splits: the items that hold
+ * an odd value weigh one, and the others zero.
+ */
+using weight_type = long;
+
+template <class Item>
+class item_weight {
+public:
+  weight_type operator()(const Item& x) const {
+    return weight_type(x.get()) & 1;
+  }
+};
+
+template <class Item>
+using weight_cache = data::cachedmeasure::weight<Item, weight_type, size_t, item_weight<Item>>;
+
+/* the chunked sequences whose cached measure is the weight find the
+ * split position by a search; the other containers by a scan
+ */
+template <class Datastruct, class = void>
+struct has_weight_cache : std::false_type { };
+
+template <class Datastruct>
+struct has_weight_cache<Datastruct,
+  typename std::enable_if<std::is_same<typename Datastruct::measured_type, weight_type>::value>::type>
+  : std::true_type { };
+
+/* moves to `other` the items of `d` starting from the one at which the
+ * running weight reaches `w`
+ */
+template <class Datastruct>
+void split_by_weight(Datastruct& d, weight_type w, Datastruct& other, std::true_type) {
+  d.split([w] (weight_type m) { return m >= w; }, other);
+}
+
+template <class Datastruct>
+void split_by_weight(Datastruct& d, weight_type w, Datastruct& other, std::false_type) {
+  using value_type = typename Datastruct::value_type;
+  item_weight<value_type> weight;
+  weight_type acc = 0;
+  size_t pos = 0;
+  for_each_item(d, [&] (const value_type& x) {
+    if (acc < w) {
+      acc += weight(x);
+      pos += (acc < w);
+    }
+  });
+  if (pos < d.size())
+    d.split(pos, other);
+}
+
+template <class Datastruct>
+void split_by_weight(Datastruct& d, weight_type w, Datastruct& other) {
+  split_by_weight(d, w, other, has_weight_cache<Datastruct>());
+}
+
 /*---------------------------------------------------------------------*/
 /* Scenarios */
 
@@ -332,6 +529,42 @@ thunk_t scenario_split_merge() {
   };
 }
 
+/* keeps the last `k` versions of a container that receives `h` pushes
+ * and `h` pops between two consecutive versions
+ */
+template <class Datastruct>
+thunk_t scenario_snapshot() {
+  typedef typename Datastruct::value_type value_type;
+  size_t n = (size_t) cmdline::parse_or_default_int64("n", 1000000);
+  size_t r = (size_t) cmdline::parse_or_default_int64("r", 10000);
+  size_t h = (size_t) cmdline::parse_or_default_int64("h", 16);
+  size_t k = (size_t) cmdline::parse_or_default_int64("k", 16);
+  return [=] {
+    printf("length %lld\n",(long long)n);
+    Datastruct d;
+    for (size_t i = 0; i < n; i++)
+      d.push_back(value_type(i));
+    std::vector<Datastruct*> versions(std::max(k, (size_t)1), nullptr);
+    res = 0;
+    uint64_t start_time = microtime::now();
+    for (size_t j = 0; j < r; j++) {
+      Datastruct*& v = versions[j % versions.size()];
+      delete v;
+      v = new Datastruct(d);
+      for (size_t i = 0; i < h; i++) {
+        d.push_back(value_type(i));
+        res += d.pop_front().get();
+      }
+    }
+    exec_time = microtime::seconds_since(start_time);
+    for (size_t j = 0; j < versions.size(); j++) {
+      if (versions[j] != nullptr)
+        res += versions[j]->size();
+      delete versions[j];
+    }
+  };
+}
+
 template <class Datastruct, class Filter>
 void filter(Datastruct& dst, Datastruct& src, const Filter& filt, int cutoff) {
   typedef typename Datastruct::value_type value_type;
@@ -381,6 +614,235 @@ thunk_t scenario_filter() {
   };
 }
 
+/* constructs `nb_seqs` empty containers, then pushes `k` items in
+ * each of them and pops them back; reports the time taken by the
+ * construction and the memory footprint of an empty container
+ */
+template <class Datastruct>
+thunk_t scenario_small_sequences() {
+  typedef typename Datastruct::value_type value_type;
+  size_t nb_seqs = (size_t) cmdline::parse_or_default_int64("nb_seqs", 1000000);
+  size_t k = (size_t) cmdline::parse_or_default_int64("k", 4);
+  return [=] {
+    printf("length %lld\n",(long long)k);
+#ifdef USE_MALLOC_COUNT
+    size_t mem_before = malloc_count_current();
+#endif
+    uint64_t start_time = microtime::now();
+    Datastruct* ds = new Datastruct[nb_seqs];
+    double construct_time = microtime::seconds_since(start_time);
+#ifdef USE_MALLOC_COUNT
+    size_t mem_per_seq = (malloc_count_current() - mem_before) / nb_seqs;
+#endif
+    res = 0;
+    for (size_t i = 0; i < nb_seqs; i++)
+      for (size_t j = 0; j < k; j++)
+        ds[i].push_back(value_type(j));
+    for (size_t i = 0; i < nb_seqs; i++)
+      while (! ds[i].empty())
+        res += ds[i].pop_back().get();
+    delete [] ds;
+    exec_time = microtime::seconds_since(start_time);
+    printf("construct_time %lf\n", construct_time);
+    printf("sizeof_sequence %lld\n", (long long)sizeof(Datastruct));
+#ifdef USE_MALLOC_COUNT
+    printf("bytes_per_empty_sequence %lld\n", (long long)mem_per_seq);
+#endif
+  };
+}
+
+/* fills a container with `n` items, then reads `r` items at random
+ * positions by indexing
+ */
+template <class Datastruct>
+thunk_t scenario_random_access() {
+  typedef typename Datastruct::value_type value_type;
+  size_t n = (size_t) cmdline::parse_or_default_int64("n", 10000000);
+  size_t r = (size_t) cmdline::parse_or_default_int64("r", 10000000);
+  return [=] {
+    printf("length %lld\n",(long long)n);
+    Datastruct d;
+    for (size_t i = 0; i < n; i++)
+      d.push_back(value_type(i));
+    size_t x = 1;
+    res = 0;
+    dtlb_counter counter;
+    counter.start();
+    uint64_t start_time = microtime::now();
+    for (size_t i = 0; i < r; i++) {
+      x = x * 6364136223846793005ull + 1442695040888963407ull;
+      res += d[(x >> 16) % n].get();
+    }
+    exec_time = microtime::seconds_since(start_time);
+    counter.stop();
+  };
+}
+
+/* fills a container with `n` items, then visits all of them `r` times
+ */
+template <class Datastruct>
+thunk_t scenario_iterate() {
+  typedef typename Datastruct::value_type value_type;
+  size_t n = (size_t) cmdline::parse_or_default_int64("n", 10000000);
+  size_t r = (size_t) cmdline::parse_or_default_int64("r", 10);
+  return [=] {
+    printf("length %lld\n",(long long)n);
+    Datastruct d;
+    for (size_t i = 0; i < n; i++)
+      d.push_back(value_type(i));
+    size_t sum = 0;
+    dtlb_counter counter;
+    counter.start();
+    uint64_t start_time = microtime::now();
+    for (size_t i = 0; i < r; i++)
+      for_each_item(d, [&] (const value_type& v) { sum += v.get(); });
+    exec_time = microtime::seconds_since(start_time);
+    counter.stop();
+    res = sum;
+  };
+}
+
+/* same as above, but the visits go by iterator
+ */
+template <class Datastruct>
+thunk_t scenario_iterate_iterator() {
+  typedef typename Datastruct::value_type value_type;
+  size_t n = (size_t) cmdline::parse_or_default_int64("n", 10000000);
+  size_t r = (size_t) cmdline::parse_or_default_int64("r", 10);
+  return [=] {
+    printf("length %lld\n",(long long)n);
+    Datastruct d;
+    for (size_t i = 0; i < n; i++)
+      d.push_back(value_type(i));
+    size_t sum = 0;
+    uint64_t start_time = microtime::now();
+    for (size_t i = 0; i < r; i++) {
+      auto end = d.end();
+      for (auto it = d.begin(); it != end; ++it) {
+        const value_type& v = *it;
+        sum += v.get();
+      }
+    }
+    exec_time = microtime::seconds_since(start_time);
+    res = sum;
+  };
+}
+
+/* same as above, but the visits go by segments of contiguous items
+ */
+template <class Datastruct>
+thunk_t scenario_iterate_segments() {
+  typedef typename Datastruct::value_type value_type;
+  size_t n = (size_t) cmdline::parse_or_default_int64("n", 10000000);
+  size_t r = (size_t) cmdline::parse_or_default_int64("r", 10);
+  return [=] {
+    printf("length %lld\n",(long long)n);
+    Datastruct d;
+    for (size_t i = 0; i < n; i++)
+      d.push_back(value_type(i));
+    size_t sum = 0;
+    size_t nb_segments = 0;
+    uint64_t start_time = microtime::now();
+    for (size_t i = 0; i < r; i++)
+      for_each_segment(d, [&] (const value_type* lo, const value_type* hi) {
+        nb_segments++;
+        for (; lo != hi; lo++)
+          sum += lo->get();
+      });
+    exec_time = microtime::seconds_since(start_time);
+    res = sum;
+    printf("nb_segments %lld\n", (long long)(nb_segments / std::max(r, (size_t)1)));
+  };
+}
+
+/* fills a container with `n` items, then `r` times inserts an item at
+ * a random position and erases the item at another random position
+ */
+template <class Datastruct>
+thunk_t scenario_insert_erase() {
+  typedef typename Datastruct::value_type value_type;
+  size_t n = (size_t) cmdline::parse_or_default_int64("n", 1000000);
+  size_t r = (size_t) cmdline::parse_or_default_int64("r", 100000);
+  return [=] {
+    printf("length %lld\n",(long long)n);
+    Datastruct d;
+    for (size_t i = 0; i < n; i++)
+      d.push_back(value_type(i));
+    size_t x = 1;
+    uint64_t start_time = microtime::now();
+    for (size_t i = 0; i < r; i++) {
+      x = x * 6364136223846793005ull + 1442695040888963407ull;
+      insert_at(d, (x >> 16) % (d.size() + 1), value_type(i));
+      x = x * 6364136223846793005ull + 1442695040888963407ull;
+      erase_at(d, (x >> 16) % d.size());
+    }
+    exec_time = microtime::seconds_since(start_time);
+    res = d.size();
+  };
+}
+
+/* fills a container with `n` items (see item_weight), then `r` times
+ * splits it where the running weight reaches a random target, and
+ * concatenates the two pieces back
+ */
+template <class Datastruct>
+thunk_t scenario_weighted_split() {
+  typedef typename Datastruct::value_type value_type;
+  size_t n = (size_t) cmdline::parse_or_default_int64("n", 1000000);
+  size_t r = (size_t) cmdline::parse_or_default_int64("r", 1000);
+  return [=] {
+    printf("length %lld\n",(long long)n);
+    Datastruct d;
+    item_weight<value_type> weight;
+    weight_type total = 0;
+    for (size_t i = 0; i < n; i++) {
+      d.push_back(value_type(i));
+      total += weight(value_type(i));
+    }
+    size_t x = 1;
+    res = 0;
+    uint64_t start_time = microtime::now();
+    for (size_t i = 0; i < r; i++) {
+      x = x * 6364136223846793005ull + 1442695040888963407ull;
+      weight_type w = 1 + weight_type((x >> 16) % std::max(total, (weight_type)1));
+      Datastruct other;
+      split_by_weight(d, w, other);
+      res += other.size();
+      d.concat(other);
+    }
+    exec_time = microtime::seconds_since(start_time);
+  };
+}
+
+/* fills a container with `n` items and reports the number of bytes it
+ * takes per item, once filled and at the peak of the filling; the
+ * counts require malloc_count (see the mct modes in the Makefile)
+ */
+template <class Datastruct>
+thunk_t scenario_memory() {
+  typedef typename Datastruct::value_type value_type;
+  size_t n = (size_t) cmdline::parse_or_default_int64("n", 10000000);
+  return [=] {
+    printf("length %lld\n",(long long)n);
+#ifdef USE_MALLOC_COUNT
+    size_t mem_before = malloc_count_current();
+    malloc_count_reset_peak();
+#endif
+    uint64_t start_time = microtime::now();
+    Datastruct d;
+    for (size_t i = 0; i < n; i++)
+      d.push_back(value_type(i));
+    exec_time = microtime::seconds_since(start_time);
+    res = d.size();
+    printf("item_szb %lld\n", (long long)sizeof(value_type));
+#ifdef USE_MALLOC_COUNT
+    double nb = (double)std::max(n, (size_t)1);
+    printf("bytes_per_item %lf\n", (malloc_count_current() - mem_before) / nb);
+    printf("peak_bytes_per_item %lf\n", (malloc_count_peak() - mem_before) / nb);
+#endif
+  };
+}
+
 #ifndef SKIP_MAP
 
 /* All of these dictionary benchmarks are taken from:
@@ -388,6 +850,22 @@ thunk_t scenario_filter() {
  */
 #define PAYLOAD 16 // Size of the object
 
+// baseline union: inserts the items of src missing from dst one by one
+template <class Map>
+void map_union(Map& dst, Map& src) {
+  for (auto it = src.begin(); it != src.end(); it++) {
+    auto key = (*it).first;
+    if (dst.find(key) == dst.end())
+      dst[key] = (*it).second;
+  }
+}
+
+template <class Key, class Item, class Compare, int Chunk_capacity, class Fork2>
+void map_union(chunkedseq::ordered::map<Key, Item, Compare, Chunk_capacity, Fork2>& dst,
+               chunkedseq::ordered::map<Key, Item, Compare, Chunk_capacity, Fork2>& src) {
+  dst.union_with(src);
+}
+
 template <class Map,class Obj>
 thunk_t scenario_map() {
   using map_type = Map;
@@ -506,17 +984,31 @@ thunk_t scenario_map() {
       if (j == bag.end())
         abort();
       
-      // Remove it
-      bag.erase(j);
-      
       // Ensure that it's the correct element.
       auto element = (*j).second;
-      /*      if (element->value != key)
-	      abort(); */
+      if (element->value != key)
+        abort();
+
+      // Remove it
+      bag.erase(j);
     }
     exec_time = microtime::seconds_since(start_time);
     res = bag.size();
   });
+  c.add("union", [=] {
+    map_type bag;
+    init(bag);
+    // every other key is already present in bag
+    map_type other;
+    for(size_t i=0;i<n;++i) {
+      key_type key = INSERT[i] + (i % 2);
+      other[key] = &OBJ[i];
+    }
+    uint64_t start_time = microtime::now();
+    map_union(bag, other);
+    exec_time = microtime::seconds_since(start_time);
+    res = bag.size();
+  });
 
   return c.find_by_arg("map_benchmark");
 }
@@ -526,7 +1018,16 @@ thunk_t scenario_map() {
 // dispatch tests
 
 template <class Sequence>
-void dispatch_by_scenario() {
+void add_iterator_scenarios(cmdline::argmap_dispatch& c, std::true_type) {
+  c.add("iterate_iterator", scenario_iterate_iterator<Sequence>());
+  c.add("insert_erase", scenario_insert_erase<Sequence>());
+}
+
+template <class Sequence>
+void add_iterator_scenarios(cmdline::argmap_dispatch& c, std::false_type) { }
+
+template <class Sequence>
+cmdline::argmap_dispatch scenarios() {
   cmdline::argmap_dispatch c;
   c.add("test", scenario_test<Sequence>());
   c.add("fifo", scenario_fifo<Sequence>());
@@ -534,6 +1035,20 @@ void dispatch_by_scenario() {
   c.add("fill_back", scenario_fill_back<Sequence>());
   c.add("split_merge", scenario_split_merge<Sequence>());
   c.add("filter", scenario_filter<Sequence>());
+  c.add("snapshot", scenario_snapshot<Sequence>());
+  c.add("small_sequences", scenario_small_sequences<Sequence>());
+  c.add("random_access", scenario_random_access<Sequence>());
+  c.add("iterate", scenario_iterate<Sequence>());
+  c.add("iterate_segments", scenario_iterate_segments<Sequence>());
+  c.add("weighted_split", scenario_weighted_split<Sequence>());
+  c.add("memory", scenario_memory<Sequence>());
+  add_iterator_scenarios<Sequence>(c, has_iterators<Sequence>());
+  return c;
+}
+
+template <class Sequence>
+void dispatch_by_scenario() {
+  cmdline::argmap_dispatch c = scenarios<Sequence>();
   cmdline::dispatch_by_argmap(c, "scenario");
 }
 
@@ -598,6 +1113,34 @@ template<class Chunk_item, int Cap, class Item_alloc2=std::allocator<Item>> clas
 class Item_alloc=std::allocator<Item> >
 using myfftreebag = chunkedseq::ftree::bagopt<Item, Chunk_capacity, Cache>;
 
+template <class Item,
+int Chunk_capacity=512,
+class Cache=data::cachedmeasure::trivial<Item, size_t>,
+template<class Chunk_item, int Cap, class Item_alloc2=std::allocator<Item>> class Chunk_struct=data::fixedcapacity::heap_allocated::ringbuffer_ptr,
+class Item_alloc=std::allocator<Item> >
+using mysmalldeque = chunkedseq::small::deque<Item, 8, Chunk_capacity, Cache>;
+
+template <class Item,
+int Chunk_capacity=512,
+class Cache=data::cachedmeasure::trivial<Item, size_t>,
+template<class Chunk_item, int Cap, class Item_alloc2=std::allocator<Item>> class Chunk_struct=data::fixedcapacity::heap_allocated::ringbuffer_ptr,
+class Item_alloc=std::allocator<Item> >
+using mysmallbag = chunkedseq::small::bagopt<Item, 8, Chunk_capacity, Cache>;
+
+template <class Item,
+int Chunk_capacity=512,
+class Cache=data::cachedmeasure::trivial<Item, size_t>,
+template<class Chunk_item, int Cap, class Item_alloc2=std::allocator<Item>> class Chunk_struct=data::fixedcapacity::heap_allocated::ringbuffer_ptr,
+class Item_alloc=std::allocator<Item> >
+using mybtreebag = chunkedseq::btree::bagopt<Item, Chunk_capacity, Cache>;
+
+template <class Item,
+int Chunk_capacity=512,
+class Cache=data::cachedmeasure::trivial<Item, size_t>,
+template<class Chunk_item, int Cap, class Item_alloc2=std::allocator<Item>> class Chunk_struct=data::fixedcapacity::heap_allocated::ringbuffer_ptr,
+class Item_alloc=std::allocator<Item> >
+using myweighteddeque = chunkedseq::bootstrapped::deque<Item, Chunk_capacity, weight_cache<Item>, Chunk_struct>;
+
 template <class Item>
 void dispatch_by_sequence() {
   util::cmdline::argmap_dispatch c;
@@ -607,6 +1150,24 @@ void dispatch_by_sequence() {
       dispatch_by_scenario<seq_type>();
     });
   #endif
+  #ifndef SKIP_VECTOR
+    // flat-array baseline, which supports only the scenarios that
+    // do not work at the front
+    c.add("stl_vector", [] {
+      using seq_type = pasl::data::stl::vector_seq<Item>;
+      cmdline::argmap_dispatch c;
+      c.add("lifo", scenario_lifo<seq_type>());
+      c.add("fill_back", scenario_fill_back<seq_type>());
+      c.add("random_access", scenario_random_access<seq_type>());
+      c.add("iterate", scenario_iterate<seq_type>());
+      c.add("iterate_iterator", scenario_iterate_iterator<seq_type>());
+      c.add("iterate_segments", scenario_iterate_segments<seq_type>());
+      c.add("insert_erase", scenario_insert_erase<seq_type>());
+      c.add("weighted_split", scenario_weighted_split<seq_type>());
+      c.add("memory", scenario_memory<seq_type>());
+      cmdline::dispatch_by_argmap(c, "scenario");
+    });
+  #endif
   #ifndef SKIP_ROPE
   #ifdef HAVE_ROPE
     c.add("stl_rope", [] {
@@ -620,6 +1181,12 @@ void dispatch_by_sequence() {
       dispatch_for_chunkedseq<chunkedseq::bootstrapped::deque, Item, data::fixedcapacity::heap_allocated::ringbuffer_ptr>();
     });
   #endif
+  #ifndef SKIP_CHUNKEDSEQ
+    // caches the weights of the items (see item_weight)
+    c.add("chunkedseq_weighted", [] {
+      dispatch_for_chunkedseq<myweighteddeque, Item, data::fixedcapacity::heap_allocated::ringbuffer_ptr>();
+    });
+  #endif
   #ifndef SKIP_CHUNKEDSEQ_OPT
     c.add("chunkedseq_stack", [] {
       dispatch_for_chunkedseq<mystack, Item, data::fixedcapacity::heap_allocated::stack>();
@@ -629,6 +1196,29 @@ void dispatch_by_sequence() {
     });
  #endif
   
+#ifndef SKIP_CHUNKEDSEQ
+  // the chunk capacity is given by -chunk_size, or else by the
+  // entry for the scenario in the file given by -chunk_capacity_config
+  c.add("chunkedseq_small", [] {
+    dispatch_for_chunkedseq<mysmalldeque, Item, data::fixedcapacity::heap_allocated::ringbuffer_ptr>();
+  });
+  c.add("chunkedseq_smallbag", [] {
+    dispatch_for_chunkedseq<mysmallbag, Item, data::fixedcapacity::heap_allocated::stack>();
+  });
+  c.add("chunkedseq_tunable", [] {
+    namespace chunkcapacity = chunkedseq::chunkcapacity;
+    std::string config = cmdline::parse_or_default_string("chunk_capacity_config", "", false);
+    if (config != "") {
+      std::string scenario = cmdline::parse_or_default_string("scenario", "");
+      if (! chunkcapacity::load(config, scenario))
+        failwith("cannot read " + config);
+    } else {
+      int chunk_size = cmdline::parse_or_default_int("chunk_size", chunkcapacity::default_capacity);
+      chunkcapacity::set_capacity(sizeof(Item), chunk_size);
+    }
+    dispatch_by_scenario<chunkedseq::bootstrapped::tunable_deque<Item>>();
+  });
+#endif
 #ifndef SKIP_FTREE
   c.add("chunkedftree", [] {
     dispatch_for_chunkedseq<chunkedseq::ftree::deque, Item, data::fixedcapacity::heap_allocated::ringbuffer_ptr>();
@@ -641,6 +1231,42 @@ void dispatch_by_sequence() {
   c.add("chunkedftree_bag", [] {
     dispatch_for_chunkedseq<myfftreebag, Item, data::fixedcapacity::heap_allocated::stack>();
   });
+#endif
+#ifndef SKIP_BTREE
+  c.add("chunkedbtree", [] {
+    dispatch_for_chunkedseq<chunkedseq::btree::deque, Item, data::fixedcapacity::heap_allocated::ringbuffer_ptr>();
+  });
+  c.add("chunkedbtree_bag", [] {
+    dispatch_for_chunkedseq<mybtreebag, Item, data::fixedcapacity::heap_allocated::stack>();
+  });
+#endif
+#ifndef SKIP_HUGEPAGE
+  // chunk buffers carved out of huge pages; -hugepage_mode is one of
+  // none, transparent and explicit, and the buffers go to the node
+  // -numa_node, or are interleaved over all nodes with -numa_interleave 1
+  c.add("chunkedseq_hugepage", [] {
+    namespace hugepage = data::hugepage;
+    cmdline::argmap<hugepage::page_mode_type> modes;
+    modes.add("none", hugepage::pages_default);
+    modes.add("transparent", hugepage::pages_transparent);
+    modes.add("explicit", hugepage::pages_explicit);
+    hugepage::set_page_mode(modes.find_by_arg_or_default_key("hugepage_mode", "transparent"));
+    int node = cmdline::parse_or_default_int("numa_node", -1, false);
+    if (cmdline::parse_or_default_bool("numa_interleave", false, false))
+      hugepage::set_interleave();
+    else if (node >= 0)
+      hugepage::set_node(node);
+    dispatch_for_chunkedseq<chunkedseq::bootstrapped::deque, Item, data::fixedcapacity::hugepage_allocated::ringbuffer_ptr>();
+    hugepage::stats_type stats = hugepage::get_stats();
+    printf("hugepage_regions %lld\n", (long long)stats.nb_regions);
+    printf("hugepage_explicit_fallbacks %lld\n", (long long)stats.nb_explicit_fallbacks);
+    printf("hugepage_placement_failures %lld\n", (long long)stats.nb_placement_failures);
+  });
+#endif
+#ifndef SKIP_PERSISTENT
+  c.add("persistent_chunkedseq", [] {
+    dispatch_for_chunkedseq<chunkedseq::persistent::deque, Item, data::fixedcapacity::heap_allocated::ringbuffer_ptr>();
+  });
 #endif
   util::cmdline::dispatch_by_argmap(c, "sequence");
 }
@@ -659,6 +1285,79 @@ void dispatch_by_itemsize() {
   util::cmdline::dispatch_by_argmap(c, "itemsize", std::to_string(default_itemsize));
 }
 
+/*---------------------------------------------------------------------*/
+// autotuning of the chunk capacity
+
+/* For each access pattern in -patterns and each item size, runs the
+ * scenario of the same name on chunked sequences whose chunks have
+ * capacities -min_chunk_size, 2 * -min_chunk_size, ..., -max_chunk_size,
+ * and records the capacity that gives the best running time (the
+ * minimum over -nb_runs runs) in the file -output.
+ */
+
+std::vector<std::string> split_list(const std::string& s) {
+  std::vector<std::string> res;
+  size_t i = 0;
+  while (i <= s.size()) {
+    size_t j = s.find(',', i);
+    if (j == std::string::npos)
+      j = s.size();
+    if (j > i)
+      res.push_back(s.substr(i, j - i));
+    i = j + 1;
+  }
+  return res;
+}
+
+template <class Item>
+void autotune_for_item(const std::vector<std::string>& patterns,
+                       std::vector<chunkedseq::chunkcapacity::entry_type>& entries) {
+  namespace chunkcapacity = chunkedseq::chunkcapacity;
+  using seq_type = chunkedseq::bootstrapped::tunable_deque<Item>;
+  int min_cap = cmdline::parse_or_default_int("min_chunk_size", 64);
+  int max_cap = cmdline::parse_or_default_int("max_chunk_size", 8192);
+  int nb_runs = cmdline::parse_or_default_int("nb_runs", 1);
+  cmdline::argmap_dispatch c = scenarios<seq_type>();
+  for (const std::string& pattern : patterns) {
+    int best_cap = 0;
+    double best_time = 0.0;
+    for (int cap = min_cap; cap <= max_cap; cap *= 2) {
+      chunkcapacity::set_capacity(sizeof(Item), cap);
+      seq_type::config_type::chunk_pool_type::flush();
+      double time = 0.0;
+      for (int r = 0; r < nb_runs; r++) {
+        c.find("patterns", pattern)();
+        time = (r == 0) ? exec_time : std::min(time, exec_time);
+      }
+      printf("autotune %s %d %d %lf\n", pattern.c_str(), (int)sizeof(Item), cap, time);
+      if (best_cap == 0 || time < best_time) {
+        best_cap = cap;
+        best_time = time;
+      }
+    }
+    chunkcapacity::entry_type e;
+    e.pattern = pattern;
+    e.item_szb = sizeof(Item);
+    e.capacity = best_cap;
+    entries.push_back(e);
+  }
+  chunkcapacity::reset();
+}
+
+void autotune() {
+  std::string patterns = cmdline::parse_or_default_string("patterns", "fifo,lifo,split_merge");
+  std::string output = cmdline::parse_or_default_string("output", "chunk_capacity.txt");
+  std::vector<std::string> ps = split_list(patterns);
+  std::vector<chunkedseq::chunkcapacity::entry_type> entries;
+  autotune_for_item<bytes_8>(ps, entries);
+  #ifndef SKIP_ITEMSIZE
+  autotune_for_item<bytes_1>(ps, entries);
+  autotune_for_item<bytes_64>(ps, entries);
+  #endif
+  if (! chunkedseq::chunkcapacity::write(output, entries))
+    failwith("cannot write " + output);
+}
+
 /*---------------------------------------------------------------------*/
 // dispatch maps
 
@@ -676,6 +1375,8 @@ void dispatch_by_map() {
   using unordered_map_type = std::unordered_map<key_type, value_type>;
   c.add("stl_map", scenario_map<stl_map_type,obj_type>());
   c.add("chunkedseq_map", scenario_map<chunkedseq_map_type,obj_type>());
+  using ordered_map_type = chunkedseq::ordered::map<key_type, value_type>;
+  c.add("ordered_map", scenario_map<ordered_map_type,obj_type>());
   c.add("stl_unordered_set", scenario_map<unordered_map_type,obj_type>());
   cmdline::dispatch_by_argmap(c, "map");
 }
@@ -692,6 +1393,7 @@ void dispatch_by_benchmark_mode() {
   cmdline::argmap_dispatch c;
   c.add("sequence", [] { dispatch_by_itemsize(); });
   c.add("map",      [] { dispatch_by_map(); });
+  c.add("autotune", [] { autotune(); });
   cmdline::dispatch_by_argmap(c, "mode", "sequence");
 }
 
@@ -699,11 +1401,22 @@ int main(int argc, char** argv) {
   pasl::util::cmdline::set(argc, argv);
   mysrand(233432432);
   res = 0;
+  int chunk_pool_size = cmdline::parse_or_default_int("chunk_pool_size",
+                          chunkedseq::chunkpool::default_max_nb_chunks, false);
+  chunkedseq::chunkpool::set_max_nb_chunks(chunk_pool_size);
+  int prefetch_distance = cmdline::parse_or_default_int("prefetch_distance",
+                            chunkedseq::prefetch::default_distance, false);
+  chunkedseq::prefetch::set_distance(prefetch_distance);
   
   dispatch_by_benchmark_mode();
   
   printf ("exectime %lf\n", exec_time);
   printf("result %lld\n", (long long)res);
+  if (dtlb_misses >= 0)
+    printf("dtlb_misses %lld\n", dtlb_misses);
+  chunkedseq::chunkpool::stats_type pool_stats = chunkedseq::chunkpool::get_stats();
+  printf("chunk_pool_hits %lld\n", (long long)pool_stats.nb_hits);
+  printf("chunk_pool_misses %lld\n", (long long)pool_stats.nb_misses);
 
   #ifdef USE_MALLOC_COUNT
   malloc_pasl_report();
@@ -0,0 +1,123 @@
+/*!
+ * \author Umut A. Acar
+ * \author Arthur Chargueraud
+ * \author Mike Rainey
+ * \date 2013-2018
+ * \copyright 2014 Umut A. Acar, Arthur Chargueraud, Mike Rainey
+ *
+ * \brief Throughput benchmark for multi-producer multi-consumer queues
+ * \file concurrent_fifo.cpp
+ *
+ */
+
+#include <assert.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cmdline.hpp"
+#include "atomic.hpp"
+#include "microtime.hpp"
+
+#include "concurrentfifo.hpp"
+
+using namespace pasl;
+using namespace pasl::util;
+namespace chunkedseq = pasl::data::chunkedseq;
+
+/***********************************************************************/
+
+using value_type = uint64_t;
+
+/*---------------------------------------------------------------------*/
+/* Baseline: STL deque protected by a mutex */
+
+class mutex_deque {
+public:
+
+  std::mutex lock;
+  std::deque<value_type> items;
+
+  void push_back(const value_type& x) {
+    std::lock_guard<std::mutex> guard(lock);
+    items.push_back(x);
+  }
+
+  bool try_pop_front(value_type& dst) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (items.empty())
+      return false;
+    dst = items.front();
+    items.pop_front();
+    return true;
+  }
+
+};
+
+/*---------------------------------------------------------------------*/
+/* Scenario */
+
+/* `nb_producers` threads push `n` items in total, while `nb_consumers`
+ * threads pop items until all of them have been popped.
+ */
+template <class Queue>
+void scenario_producers_consumers() {
+  int nb_producers = cmdline::parse_or_default_int("producers", 1);
+  int nb_consumers = cmdline::parse_or_default_int("consumers", 1);
+  uint64_t n = (uint64_t) cmdline::parse_or_default_int64("n", 10000000);
+  if (nb_producers < 1 || nb_consumers < 1)
+    atomic::die("at least one producer and one consumer are needed\n");
+  Queue q;
+  std::atomic<uint64_t> nb_popped(0);
+  std::atomic<uint64_t> sum(0);
+  std::atomic<bool> start(false);
+  std::vector<std::thread> threads;
+  for (int p = 0; p < nb_producers; p++) {
+    threads.push_back(std::thread([&, p] {
+      while (! start.load()) { }
+      for (uint64_t i = p; i < n; i += nb_producers)
+        q.push_back(i);
+    }));
+  }
+  for (int c = 0; c < nb_consumers; c++) {
+    threads.push_back(std::thread([&] {
+      while (! start.load()) { }
+      uint64_t s = 0;
+      value_type x;
+      while (nb_popped.load() < n) {
+        if (q.try_pop_front(x)) {
+          s += x;
+          nb_popped++;
+        }
+      }
+      sum += s;
+    }));
+  }
+  uint64_t start_time = microtime::now();
+  start.store(true);
+  for (std::thread& t : threads)
+    t.join();
+  double exec_time = microtime::seconds_since(start_time);
+  printf("exectime %lf\n", exec_time);
+  printf("throughput %lf\n", (double)n / exec_time);
+  printf("result %llu\n", (unsigned long long)sum.load());
+}
+
+/*---------------------------------------------------------------------*/
+
+int main(int argc, char** argv) {
+  pasl::util::cmdline::set(argc, argv);
+  cmdline::argmap_dispatch c;
+  c.add("chunked_fifo", [] {
+    scenario_producers_consumers<chunkedseq::concurrent::fifo<value_type>>();
+  });
+  c.add("mutex_deque", [] {
+    scenario_producers_consumers<mutex_deque>();
+  });
+  cmdline::dispatch_by_argmap(c, "queue", "chunked_fifo");
+  return 0;
+}
+
+/***********************************************************************/
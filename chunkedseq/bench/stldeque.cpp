@@ -0,0 +1,106 @@
+/*!
+ * \author Umut A. Acar
+ * \author Arthur Chargueraud
+ * \author Mike Rainey
+ * \date 2013-2018
+ * \copyright 2014 Umut A. Acar, Arthur Chargueraud, Mike Rainey
+ *
+ * \brief Benchmark for pasl::deque against std::deque
+ * \file stldeque.cpp
+ *
+ */
+
+#include <deque>
+#include <random>
+#include <string>
+
+#include "cmdline.hpp"
+#include "atomic.hpp"
+#include "microtime.hpp"
+
+#include "stldeque.hpp"
+
+using namespace pasl;
+using namespace pasl::util;
+
+/***********************************************************************/
+
+using value_type = int64_t;
+
+/*---------------------------------------------------------------------*/
+/* Scenarios */
+
+template <class Deque>
+void scenario() {
+  size_t n = (size_t)cmdline::parse_or_default_int64("n", 10000000);
+  size_t nb_ops = (size_t)cmdline::parse_or_default_int64("nb_ops", 10000);
+  std::string op = cmdline::parse_or_default_string("scenario", "push_pop");
+  std::mt19937_64 gen(1);
+  Deque d;
+  uint64_t result = 0;
+  auto fill = [&] {
+    for (size_t i = 0; i < n; i++)
+      d.push_back(value_type(i));
+  };
+  uint64_t start_time;
+  if (op == "push_pop") {
+    // fills the deque at the back, then empties it at the front
+    start_time = microtime::now();
+    fill();
+    while (! d.empty()) {
+      result += d.front();
+      d.pop_front();
+    }
+  } else if (op == "lifo") {
+    // pushes and pops at the back of a deque of `n` items
+    fill();
+    start_time = microtime::now();
+    for (size_t i = 0; i < nb_ops; i++) {
+      d.push_back(value_type(i));
+      result += d.back();
+      d.pop_back();
+    }
+  } else if (op == "random_access") {
+    // reads items at random indices
+    fill();
+    start_time = microtime::now();
+    for (size_t i = 0; i < nb_ops; i++)
+      result += d[gen() % n];
+  } else if (op == "iterate") {
+    fill();
+    start_time = microtime::now();
+    for (auto it = d.begin(); it != d.end(); it++)
+      result += *it;
+  } else if (op == "middle_insert") {
+    // inserts and erases single items at random positions
+    fill();
+    start_time = microtime::now();
+    for (size_t i = 0; i < nb_ops; i++) {
+      d.insert(d.begin() + gen() % (d.size() + 1), value_type(i));
+      d.erase(d.begin() + gen() % d.size());
+    }
+    result = d.size();
+  } else {
+    atomic::die("bogus scenario %s\n", op.c_str());
+  }
+  double exec_time = microtime::seconds_since(start_time);
+  printf("exectime %lf\n", exec_time);
+  printf("result %llu\n", (unsigned long long)result);
+}
+
+/*---------------------------------------------------------------------*/
+
+int main(int argc, char** argv) {
+  pasl::util::cmdline::set(argc, argv);
+  cmdline::argmap_dispatch c;
+  c.add("pasl_deque", [] {
+    scenario<pasl::deque<value_type>>();
+  });
+  c.add("stl_deque", [] {
+    scenario<std::deque<value_type>>();
+  });
+  cmdline::dispatch_by_argmap(c, "sequence", "pasl_deque");
+  return 0;
+}
+
+/***********************************************************************/
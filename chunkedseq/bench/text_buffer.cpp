@@ -0,0 +1,189 @@
+/*!
+ * \author Umut A. Acar
+ * \author Arthur Chargueraud
+ * \author Mike Rainey
+ * \date 2013-2018
+ * \copyright 2014 Umut A. Acar, Arthur Chargueraud, Mike Rainey
+ *
+ * \brief Benchmark for text buffers
+ * \file text_buffer.cpp
+ *
+ */
+
+#include <assert.h>
+#include <random>
+#include <string>
+
+#include "cmdline.hpp"
+#include "atomic.hpp"
+#include "microtime.hpp"
+
+#include "container.hpp"
+#include "rope.hpp"
+
+using namespace pasl;
+using namespace pasl::util;
+namespace chunkedseq = pasl::data::chunkedseq;
+
+/***********************************************************************/
+
+/*---------------------------------------------------------------------*/
+/* Text buffers */
+
+class chunkedseq_buffer {
+public:
+
+  chunkedseq::rope<> r;
+
+  void load(const char* s, size_t nb) {
+    r.append(s, nb);
+  }
+
+  size_t size() const {
+    return r.size();
+  }
+
+  size_t nb_newlines() const {
+    return r.nb_newlines();
+  }
+
+  std::string get_line(size_t line) const {
+    return r.get_line(line);
+  }
+
+  void insert(size_t offset, const std::string& s) {
+    r.insert(offset, s);
+  }
+
+  void erase(size_t offset, size_t nb) {
+    r.erase(offset, nb);
+  }
+
+};
+
+#ifdef HAVE_ROPE
+// The STL rope has no line index: lines are found by a scan from the
+// beginning of the text.
+class stl_rope_buffer {
+public:
+
+  data::stl::rope_seq<char> r;
+
+  void load(const char* s, size_t nb) {
+    r.v.append(s, nb);
+  }
+
+  size_t size() const {
+    return r.size();
+  }
+
+  size_t nb_newlines() const {
+    size_t nb = 0;
+    for (auto it = r.v.begin(); it != r.v.end(); it++)
+      nb += (*it == '\n');
+    return nb;
+  }
+
+  std::string get_line(size_t line) const {
+    auto it = r.v.begin();
+    for (size_t k = 0; k < line && it != r.v.end(); it++)
+      k += (*it == '\n');
+    std::string s;
+    for (; it != r.v.end() && *it != '\n'; it++)
+      s.push_back(*it);
+    return s;
+  }
+
+  void insert(size_t offset, const std::string& s) {
+    r.v.insert(offset, s.data(), s.size());
+  }
+
+  void erase(size_t offset, size_t nb) {
+    r.v.erase(offset, nb);
+  }
+
+};
+#endif
+
+/*---------------------------------------------------------------------*/
+/* Scenarios */
+
+// a log of `n` bytes, made of lines of random lengths
+std::string generate_text(size_t n) {
+  std::mt19937 gen(1);
+  std::string s;
+  s.reserve(n);
+  size_t line = 0;
+  while (s.size() < n) {
+    s += "[" + std::to_string(line++) + "] event";
+    size_t len = gen() % 120;
+    for (size_t i = 0; i < len; i++)
+      s.push_back(char('a' + gen() % 26));
+    s.push_back('\n');
+  }
+  s.resize(n);
+  return s;
+}
+
+template <class Buffer>
+void scenario() {
+  size_t n = (size_t)cmdline::parse_or_default_int64("n", 10000000);
+  int nb_ops = cmdline::parse_or_default_int("nb_ops", 100);
+  size_t block_szb = (size_t)cmdline::parse_or_default_int("block", 1 << 16);
+  std::string op = cmdline::parse_or_default_string("scenario", "load");
+  std::string text = generate_text(n);
+  std::mt19937 gen(2);
+  Buffer buf;
+  uint64_t result = 0;
+  auto load = [&] {
+    for (size_t i = 0; i < n; i += block_szb)
+      buf.load(text.data() + i, std::min(block_szb, n - i));
+  };
+  uint64_t start_time;
+  if (op == "load") {
+    start_time = microtime::now();
+    load();
+    result = buf.size();
+  } else if (op == "line_jump") {
+    // reads lines picked at random
+    load();
+    size_t nb_lines = buf.nb_newlines();
+    start_time = microtime::now();
+    for (int i = 0; i < nb_ops; i++)
+      result += buf.get_line(gen() % nb_lines).size();
+  } else if (op == "edit") {
+    // inserts and erases short pieces of text at random offsets
+    load();
+    std::string piece = "inserted line\n";
+    start_time = microtime::now();
+    for (int i = 0; i < nb_ops; i++) {
+      buf.insert(gen() % buf.size(), piece);
+      buf.erase(gen() % (buf.size() - piece.size()), piece.size());
+    }
+    result = buf.size();
+  } else {
+    atomic::die("bogus scenario %s\n", op.c_str());
+  }
+  double exec_time = microtime::seconds_since(start_time);
+  printf("exectime %lf\n", exec_time);
+  printf("result %llu\n", (unsigned long long)result);
+}
+
+/*---------------------------------------------------------------------*/
+
+int main(int argc, char** argv) {
+  pasl::util::cmdline::set(argc, argv);
+  cmdline::argmap_dispatch c;
+  c.add("chunkedseq_rope", [] {
+    scenario<chunkedseq_buffer>();
+  });
+#ifdef HAVE_ROPE
+  c.add("stl_rope", [] {
+    scenario<stl_rope_buffer>();
+  });
+#endif
+  cmdline::dispatch_by_argmap(c, "buffer", "chunkedseq_rope");
+  return 0;
+}
+
+/***********************************************************************/
@@ -253,7 +253,7 @@ public:
     if (it == seq.end())
       return;
     if (it == seq.end()-1) {
-      seq.pop_front();
+      seq.pop_back();
       return;
     }
     seq.erase(it, it+1);
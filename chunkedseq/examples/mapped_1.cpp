@@ -0,0 +1,73 @@
+/*!
+ * \author Umut A. Acar
+ * \author Arthur Chargueraud
+ * \author Mike Rainey
+ * \date 2013-2018
+ * \copyright 2014 Umut A. Acar, Arthur Chargueraud, Mike Rainey
+ *
+ * \brief Example use of the on-disk format for chunked sequences
+ * \file mapped_1.cpp
+ * \example mapped_1.cpp
+ * \ingroup chunkedseq
+ *
+ */
+
+//! [mapped_example1]
+#include <iostream>
+
+#include "chunkedseq.hpp"
+#include "mappedseq.hpp"
+
+namespace chunkedseq = pasl::data::chunkedseq;
+
+using cache_type = pasl::data::cachedmeasure::size<long, size_t>;
+using cbdeque = chunkedseq::bootstrapped::deque<long, 512, cache_type>;
+using mseq = chunkedseq::mapped::sequence<long, cache_type>;
+
+int main(int argc, const char * argv[]) {
+
+  const char* path = "mapped_1.dat";
+  const long n = 1000000;
+
+  cbdeque src;
+  for (long i = 0; i < n; i++)
+    src.push_back(i);
+  if (! chunkedseq::mapped::write(src, path)) {
+    std::cerr << "cannot write " << path << std::endl;
+    return 1;
+  }
+
+  // the items are read in place, from the pages of the file
+  mseq m;
+  if (! m.open(path)) {
+    std::cerr << "cannot open " << path << std::endl;
+    return 1;
+  }
+  assert(m.size() == n);
+  assert(m.get_cached() == n);
+  assert(m[n/2] == n/2);
+  long sum = 0;
+  m.for_each([&] (long x) { sum += x; });
+  std::cout << "sum = " << sum << std::endl;
+
+  // modifications in copy-on-write mode stay private to the process
+  mseq w;
+  w.open(path, mseq::copy_on_write);
+  w.for_each_segment_mutable([&] (long* lo, long* hi) {
+    for (long* p = lo; p < hi; p++)
+      *p = -*p;
+  });
+  assert(w[1] == -1);
+  assert(m[1] == 1);
+
+  // bulk conversion back to a chunked sequence
+  cbdeque dst;
+  w.copy_to(dst);
+  assert(dst.size() == n);
+  assert(dst.back() == -(n-1));
+
+  unlink(path);
+  return 0;
+
+}
+//! [mapped_example1]
@@ -21,6 +21,7 @@
 #include "cachedmeasure.hpp"
 #include "itemsearch.hpp"
 #include "annotation.hpp"
+#include "prefetch.hpp"
 
 #ifndef _PASL_DATA_BOOTCHUNKEDSEQNEW_H_
 #define _PASL_DATA_BOOTCHUNKEDSEQNEW_H_
@@ -203,6 +204,18 @@ private:
       }
     }
 
+    // recursively frees the items of the layer and of its middle
+    // layers, leaving the chunks in an unstable state; only use this
+    // function to implement the destructor
+    void rec_free(int depth) {
+      chunk_deep_free(depth, front_outer);
+      chunk_deep_free(depth, front_inner);
+      chunk_deep_free(depth, back_inner);
+      chunk_deep_free(depth, back_outer);
+      if (middle != NULL)
+        middle->rec_free(depth+1);
+    }
+
     void swap(self_type& other) {
       std::swap(cached, other.cached);
       std::swap(middle, other.middle);
@@ -1052,6 +1065,21 @@ private:
   // apply a given function f to the top items of the tree rooted at node c
   template <class Body>
   static void chunk_for_each(int depth, const Body& f, const chunk_type& c) {
+    if (depth > 0 && prefetch::get_distance() > 0) {
+      // the children are visited one step behind, so that the next
+      // child is fetched while the current one is traversed
+      const_chunk_pointer pending = nullptr;
+      c.for_each([&] (const cached_item_type& v) {
+        const_chunk_pointer c = const_chunk_pointer_of_cached_item(v);
+        prefetch::read(c);
+        if (pending != nullptr)
+          chunk_for_each(depth-1, f, *pending);
+        pending = c;
+      });
+      if (pending != nullptr)
+        chunk_for_each(depth-1, f, *pending);
+      return;
+    }
     c.for_each([&] (const cached_item_type& v) {
       if (depth == 0) {
         top_item_type item = top_item_of_cached_item(v);
@@ -1177,7 +1205,9 @@ public:
 
   cdeque() {}
 
-  ~cdeque() {}
+  ~cdeque() {
+    top_layer.rec_free(depth0);
+  }
 
   cdeque(const self_type& other) {
     top_layer.rec_copy(depth0, other.top_layer);
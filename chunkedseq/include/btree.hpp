@@ -0,0 +1,626 @@
+/*!
+ * \author Umut A. Acar
+ * \author Arthur Chargueraud
+ * \author Mike Rainey
+ * \date 2013-2018
+ * \copyright 2014 Umut A. Acar, Arthur Chargueraud, Mike Rainey
+ *
+ * \brief B+-tree with prefix-measure arrays, for use as middle sequence
+ * \file btree.hpp
+ *
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "cachedmeasure.hpp"
+#include "chunk.hpp"
+#include "fixedcapacity.hpp"
+#include "itemsearch.hpp"
+#include "prefetch.hpp"
+
+#ifndef _PASL_DATA_BTREE_H_
+#define _PASL_DATA_BTREE_H_
+
+namespace pasl {
+namespace data {
+namespace chunkedseq {
+namespace btree {
+
+/***********************************************************************/
+
+/*---------------------------------------------------------------------*/
+/*!
+ * \class bplustree
+ * \brief Sequence of pointers, represented as a B+-tree whose nodes
+ * store the prefix measures of their entries
+ * \tparam Top_item_base use `foo` to obtain a sequence of `foo*` items
+ * \tparam Fanout maximal number of entries of a node
+ *
+ * All the leaves are at the same depth. Each node stores, next to
+ * its entries (items in the leaves, pointers to nodes elsewhere), an
+ * array whose `i`-th cell holds the combined measurement of the
+ * entries `0` to `i`. A search for the position where a predicate
+ * starts to hold thus scans one contiguous array per level, without
+ * touching the entries it skips; with a fanout of 32, the arrays of
+ * a sequence of millions of chunks are at most five levels deep.
+ *
+ * Every node but the root has at least `Fanout / 2` entries. Split
+ * and concatenation are implemented by joining trees of different
+ * heights, along the spine of the taller one.
+ *
+ * The signature of the class matches the `Middle_sequence` parameter
+ * of the chunked sequence; the `Chunk_struct` and `Size_access`
+ * parameters are not used.
+ *
+ * #### Complexity ####
+ * - push and pop at either end: logarithmic time (in base `Fanout`)
+ * - `search_for_chunk`: logarithmic time
+ * - `split`, `concat`: squared logarithmic time
+ */
+template <
+  class Top_item_base,
+  int Fanout = 32,
+  class Cached_measure = cachedmeasure::trivial<Top_item_base*, size_t>,
+  class Top_item_deleter = Pointer_deleter, // provides: static void dealloc(foo* x)
+  class Top_item_copier = Pointer_deep_copier, // provides: static void copy(foo* x)
+  template <
+    class Item,
+    int Capacity,
+    class Item_alloc
+  >
+  class Chunk_struct = fixedcapacity::heap_allocated::ringbuffer_ptr,
+  class Size_access = itemsearch::no_size_access
+>
+class bplustree {
+public:
+
+  using self_type = bplustree<Top_item_base, Fanout, Cached_measure,
+                              Top_item_deleter, Top_item_copier, Chunk_struct, Size_access>;
+
+  using cache_type = Cached_measure;
+  using measured_type = typename cache_type::measured_type;
+  using algebra_type = typename cache_type::algebra_type;
+  using measure_type = typename cache_type::measure_type;
+
+  using leaf_item_type = Top_item_base*;
+
+private:
+
+  static_assert(Fanout >= 4, "fanout too small");
+
+  static constexpr int max_nb = Fanout;
+  static constexpr int min_nb = Fanout / 2;
+  static constexpr size_t node_alignment = 64;
+
+  class node;
+
+  union entry_type {
+    node* child;
+    leaf_item_type item;
+  };
+
+  // The arrays have one spare cell, so that an insertion can be
+  // performed before the node is split.
+  class node {
+  public:
+    int nb;
+    measured_type prefix[max_nb + 1];
+    entry_type entries[max_nb + 1];
+  };
+
+  // a tree of height zero is a single leaf
+  class tree_type {
+  public:
+    node* root;
+    int height;
+    tree_type() : root(nullptr), height(0) { }
+    tree_type(node* root, int height) : root(root), height(height) { }
+  };
+
+  tree_type t;
+
+  /*---------------------------------------------------------------------*/
+  /* Nodes */
+
+  static node* alloc_node() {
+    void* p = nullptr;
+    if (posix_memalign(&p, node_alignment, sizeof(node)) != 0)
+      throw std::bad_alloc();
+    node* n = new (p) node();
+    n->nb = 0;
+    return n;
+  }
+
+  static void free_node(node* n) {
+    n->~node();
+    free(n);
+  }
+
+  static measured_type total(const node* n) {
+    return (n->nb == 0) ? algebra_type::identity() : n->prefix[n->nb - 1];
+  }
+
+  // Trivially-copyable measures are stored by `memcpy`: GCC 12 at -O2
+  // miscompiles the assignment in the loops of `recompute` when the
+  // measure has tail padding (e.g., a pair whose second component is
+  // empty), and then drops the calls to `recompute` altogether.
+  static void store_prefix(measured_type& dst, const measured_type& m, std::true_type) {
+    memcpy(&dst, &m, sizeof(measured_type));
+  }
+
+  static void store_prefix(measured_type& dst, const measured_type& m, std::false_type) {
+    dst = m;
+  }
+
+  static void store_prefix(measured_type& dst, const measured_type& m) {
+    store_prefix(dst, m, std::is_trivially_copyable<measured_type>());
+  }
+
+  // recomputes the prefix measures of the entries at positions `lo` and above
+  static void recompute(node* n, int height, int lo = 0) {
+    measured_type m = (lo == 0) ? algebra_type::identity() : n->prefix[lo - 1];
+    if (height == 0) {
+      measure_type meas;
+      for (int i = lo; i < n->nb; i++) {
+        m = algebra_type::combine(m, meas(n->entries[i].item));
+        store_prefix(n->prefix[i], m);
+      }
+    } else {
+      for (int i = lo; i < n->nb; i++) {
+        m = algebra_type::combine(m, total(n->entries[i].child));
+        store_prefix(n->prefix[i], m);
+      }
+    }
+  }
+
+  static void insert_entry(node* n, int height, int i, entry_type e) {
+    assert(n->nb <= max_nb);
+    for (int k = n->nb; k > i; k--)
+      n->entries[k] = n->entries[k - 1];
+    n->entries[i] = e;
+    n->nb++;
+    recompute(n, height, i);
+  }
+
+  static void remove_entry(node* n, int height, int i) {
+    for (int k = i; k + 1 < n->nb; k++)
+      n->entries[k] = n->entries[k + 1];
+    n->nb--;
+    recompute(n, height, i);
+  }
+
+  // moves the entries of `src` to the back of `dst`
+  static void append_entries(node* dst, node* src, int height) {
+    int lo = dst->nb;
+    for (int k = 0; k < src->nb; k++)
+      dst->entries[lo + k] = src->entries[k];
+    dst->nb += src->nb;
+    src->nb = 0;
+    recompute(dst, height, lo);
+  }
+
+  // moves the entries at positions `i` and above from `src` to the front of `dst`
+  static void move_suffix_to_front(node* src, int i, node* dst, int height) {
+    int nb = src->nb - i;
+    for (int k = dst->nb - 1; k >= 0; k--)
+      dst->entries[k + nb] = dst->entries[k];
+    for (int k = 0; k < nb; k++)
+      dst->entries[k] = src->entries[i + k];
+    dst->nb += nb;
+    src->nb = i;
+    recompute(dst, height);
+  }
+
+  // splits a node that has one entry too many; returns the new right half
+  static node* split_overfull(node* n, int height) {
+    assert(n->nb == max_nb + 1);
+    node* r = alloc_node();
+    move_suffix_to_front(n, n->nb / 2, r, height);
+    return r;
+  }
+
+  /* Restores the occupancy of the child at position `i` of `n`, if
+   * the child has fewer than `min_nb` entries, by merging it with a
+   * neighbour or by taking entries from that neighbour.
+   */
+  static void fix_child(node* n, int height, int i) {
+    node* c = n->entries[i].child;
+    if (c->nb >= min_nb || n->nb < 2)
+      return;
+    int l = (i > 0) ? i - 1 : i;
+    node* left = n->entries[l].child;
+    node* right = n->entries[l + 1].child;
+    int h = height - 1;
+    if (left->nb + right->nb <= max_nb) {
+      append_entries(left, right, h);
+      free_node(right);
+      remove_entry(n, height, l + 1);
+    } else if (left->nb < right->nb) {
+      int nb = (right->nb - left->nb) / 2;
+      int lo = left->nb;
+      for (int k = 0; k < nb; k++)
+        left->entries[lo + k] = right->entries[k];
+      left->nb += nb;
+      for (int k = nb; k < right->nb; k++)
+        right->entries[k - nb] = right->entries[k];
+      right->nb -= nb;
+      recompute(left, h, lo);
+      recompute(right, h);
+    } else {
+      int nb = (left->nb - right->nb) / 2;
+      move_suffix_to_front(left, left->nb - nb, right, h);
+    }
+    recompute(n, height, l);
+  }
+
+  static tree_type normalize(tree_type r) {
+    if (r.root == nullptr)
+      return r;
+    if (r.root->nb == 0) {
+      free_node(r.root);
+      return tree_type();
+    }
+    while (r.height > 0 && r.root->nb == 1) {
+      node* c = r.root->entries[0].child;
+      free_node(r.root);
+      r = tree_type(c, r.height - 1);
+    }
+    return r;
+  }
+
+  static tree_type new_root(node* left, node* right, int height) {
+    node* n = alloc_node();
+    n->entries[0].child = left;
+    n->entries[1].child = right;
+    n->nb = 2;
+    recompute(n, height + 1);
+    fix_child(n, height + 1, 0);
+    fix_child(n, height + 1, n->nb - 1);
+    return normalize(tree_type(n, height + 1));
+  }
+
+  /*---------------------------------------------------------------------*/
+  /* Join */
+
+  // adds the tree `s`, which is lower than `n`, to the right spine of `n`
+  static node* join_right(node* n, int height, node* s, int s_height) {
+    entry_type e;
+    if (height == s_height + 1) {
+      e.child = s;
+      insert_entry(n, height, n->nb, e);
+      fix_child(n, height, n->nb - 1);
+    } else {
+      node* x = join_right(n->entries[n->nb - 1].child, height - 1, s, s_height);
+      recompute(n, height, n->nb - 1);
+      if (x != nullptr) {
+        e.child = x;
+        insert_entry(n, height, n->nb, e);
+      }
+    }
+    return (n->nb > max_nb) ? split_overfull(n, height) : nullptr;
+  }
+
+  // symmetric to join_right
+  static node* join_left(node* n, int height, node* s, int s_height) {
+    entry_type e;
+    if (height == s_height + 1) {
+      e.child = s;
+      insert_entry(n, height, 0, e);
+      fix_child(n, height, 0);
+    } else {
+      node* x = join_left(n->entries[0].child, height - 1, s, s_height);
+      recompute(n, height);
+      if (x != nullptr) {
+        e.child = x;
+        insert_entry(n, height, 1, e);
+      }
+    }
+    return (n->nb > max_nb) ? split_overfull(n, height) : nullptr;
+  }
+
+  static tree_type join(tree_type a, tree_type b) {
+    if (a.root == nullptr)
+      return b;
+    if (b.root == nullptr)
+      return a;
+    if (a.height == b.height) {
+      if (a.root->nb + b.root->nb <= max_nb) {
+        append_entries(a.root, b.root, a.height);
+        free_node(b.root);
+        return normalize(a);
+      }
+      return new_root(a.root, b.root, a.height);
+    } else if (a.height > b.height) {
+      node* x = join_right(a.root, a.height, b.root, b.height);
+      if (x == nullptr)
+        return normalize(a);
+      return new_root(a.root, x, a.height);
+    } else {
+      node* x = join_left(b.root, b.height, a.root, a.height);
+      if (x == nullptr)
+        return normalize(b);
+      return new_root(b.root, x, b.height);
+    }
+  }
+
+  static tree_type singleton(leaf_item_type x) {
+    node* n = alloc_node();
+    n->entries[0].item = x;
+    n->nb = 1;
+    recompute(n, 0);
+    return tree_type(n, 0);
+  }
+
+  /*---------------------------------------------------------------------*/
+  /* Search and split */
+
+  // index of the first entry of `n` at which `p` holds; `prefix` is
+  // updated to the measurement of the entries before that one
+  template <class Pred>
+  static int find(const node* n, const Pred& p, measured_type& prefix) {
+    int i = 0;
+    while (i + 1 < n->nb && ! p(algebra_type::combine(prefix, n->prefix[i])))
+      i++;
+    if (i > 0)
+      prefix = algebra_type::combine(prefix, n->prefix[i - 1]);
+    return i;
+  }
+
+  template <class Pred>
+  static std::pair<tree_type, tree_type> split_rec(node* n, int height, const Pred& p,
+                                                   measured_type& prefix, leaf_item_type& item) {
+    int i = find(n, p, prefix);
+    entry_type e = n->entries[i];
+    node* r = alloc_node();
+    move_suffix_to_front(n, i + 1, r, height);
+    n->nb = i;
+    tree_type left = normalize(tree_type(n, height));
+    tree_type right = normalize(tree_type(r, height));
+    if (height == 0) {
+      item = e.item;
+      return std::make_pair(left, right);
+    }
+    std::pair<tree_type, tree_type> c = split_rec(e.child, height - 1, p, prefix, item);
+    return std::make_pair(join(left, c.first), join(c.second, right));
+  }
+
+  /*---------------------------------------------------------------------*/
+  /* Removal at the ends */
+
+  static leaf_item_type pop_back_rec(node* n, int height) {
+    if (height == 0)
+      return n->entries[--n->nb].item;
+    int i = n->nb - 1;
+    node* c = n->entries[i].child;
+    leaf_item_type x = pop_back_rec(c, height - 1);
+    if (c->nb == 0) {
+      free_node(c);
+      n->nb--;
+    } else {
+      recompute(n, height, i);
+      fix_child(n, height, i);
+    }
+    return x;
+  }
+
+  static leaf_item_type pop_front_rec(node* n, int height) {
+    if (height == 0) {
+      leaf_item_type x = n->entries[0].item;
+      remove_entry(n, height, 0);
+      return x;
+    }
+    node* c = n->entries[0].child;
+    leaf_item_type x = pop_front_rec(c, height - 1);
+    if (c->nb == 0) {
+      free_node(c);
+      remove_entry(n, height, 0);
+    } else {
+      recompute(n, height);
+      fix_child(n, height, 0);
+    }
+    return x;
+  }
+
+  /*---------------------------------------------------------------------*/
+  /* Whole trees */
+
+  template <class Body>
+  static void for_each_rec(node* n, int height, const Body& body) {
+    bool prefetching = (height > 0) && (prefetch::get_distance() > 0);
+    for (int i = 0; i < n->nb; i++) {
+      if (height == 0) {
+        body(n->entries[i].item);
+      } else {
+        // the next child is fetched while the current one is traversed
+        if (prefetching && i + 1 < n->nb)
+          prefetch::read(n->entries[i + 1].child);
+        for_each_rec(n->entries[i].child, height - 1, body);
+      }
+    }
+  }
+
+  static void free_rec(node* n, int height) {
+    for (int i = 0; i < n->nb; i++) {
+      if (height == 0)
+        Top_item_deleter::dealloc(n->entries[i].item);
+      else
+        free_rec(n->entries[i].child, height - 1);
+    }
+    free_node(n);
+  }
+
+  static node* copy_rec(const node* n, int height) {
+    node* c = alloc_node();
+    for (int i = 0; i < n->nb; i++) {
+      if (height == 0)
+        c->entries[i].item = Top_item_copier::copy(n->entries[i].item);
+      else
+        c->entries[i].child = copy_rec(n->entries[i].child, height - 1);
+    }
+    c->nb = n->nb;
+    recompute(c, height);
+    return c;
+  }
+
+  static leaf_item_type extremity(const node* n, int height, bool back) {
+    while (height > 0) {
+      n = n->entries[back ? n->nb - 1 : 0].child;
+      height--;
+    }
+    return n->entries[back ? n->nb - 1 : 0].item;
+  }
+
+public:
+
+  /*---------------------------------------------------------------------*/
+  /** @name Constructors and destructors
+   */
+  ///@{
+
+  bplustree() { }
+
+  bplustree(const self_type& other) {
+    if (other.t.root != nullptr)
+      t = tree_type(copy_rec(other.t.root, other.t.height), other.t.height);
+  }
+
+  ~bplustree() {
+    if (t.root != nullptr)
+      free_rec(t.root, t.height);
+  }
+
+  ///@}
+
+  bool empty() const {
+    return t.root == nullptr;
+  }
+
+  measured_type get_cached() const {
+    return (t.root == nullptr) ? algebra_type::identity() : total(t.root);
+  }
+
+  leaf_item_type front() const {
+    assert(! empty());
+    return extremity(t.root, t.height, false);
+  }
+
+  leaf_item_type back() const {
+    assert(! empty());
+    return extremity(t.root, t.height, true);
+  }
+
+  leaf_item_type cback() const {
+    return back();
+  }
+
+  template <class M>
+  void push_back(M, leaf_item_type x) {
+    if (t.root != nullptr && t.height == 0 && t.root->nb < max_nb) {
+      entry_type e;
+      e.item = x;
+      insert_entry(t.root, 0, t.root->nb, e);
+      return;
+    }
+    t = join(t, singleton(x));
+  }
+
+  template <class M>
+  void push_front(M, leaf_item_type x) {
+    if (t.root != nullptr && t.height == 0 && t.root->nb < max_nb) {
+      entry_type e;
+      e.item = x;
+      insert_entry(t.root, 0, 0, e);
+      return;
+    }
+    t = join(singleton(x), t);
+  }
+
+  template <class M>
+  leaf_item_type pop_back(M) {
+    assert(! empty());
+    leaf_item_type x = pop_back_rec(t.root, t.height);
+    t = normalize(t);
+    return x;
+  }
+
+  template <class M>
+  leaf_item_type pop_front(M) {
+    assert(! empty());
+    leaf_item_type x = pop_front_rec(t.root, t.height);
+    t = normalize(t);
+    return x;
+  }
+
+  template <class Body>
+  void for_each(const Body& body) const {
+    if (t.root != nullptr)
+      for_each_rec(t.root, t.height, body);
+  }
+
+  void swap(self_type& other) {
+    std::swap(t, other.t);
+  }
+
+  /*!
+   * \brief Finds the first item at which `p` holds, when `p` is
+   * applied to the combination of `prefix` and of the measurements of
+   * the items up to and including that item; returns the combination
+   * of `prefix` and of the measurements of the items before it
+   *
+   * If there is no such item, the last item is taken.
+   */
+  template <class Pred>
+  measured_type search_for_chunk(const Pred& p, measured_type prefix,
+                                 const Top_item_base*& item) const {
+    assert(! empty());
+    const node* n = t.root;
+    for (int h = t.height; h > 0; h--)
+      n = n->entries[find(n, p, prefix)].child;
+    item = n->entries[find(n, p, prefix)].item;
+    return prefix;
+  }
+
+  /*!
+   * \brief Removes the item found as by `search_for_chunk`, writes it
+   * in `item`, and moves the items after it to `other`
+   *
+   * \pre The `other` container is empty.
+   */
+  template <class M, class Pred>
+  measured_type split(M, const Pred& p, measured_type prefix,
+                      leaf_item_type& item, self_type& other) {
+    assert(other.empty());
+    if (empty())
+      return prefix;
+    std::pair<tree_type, tree_type> r = split_rec(t.root, t.height, p, prefix, item);
+    t = r.first;
+    other.t = r.second;
+    return prefix;
+  }
+
+  template <class M>
+  void concat(M, self_type& other) {
+    t = join(t, other.t);
+    other.t = tree_type();
+  }
+
+  //! Height of the tree; zero for a sequence that fits in one leaf
+  int get_height() const {
+    return t.height;
+  }
+
+};
+
+/***********************************************************************/
+
+} // end namespace
+} // end namespace
+} // end namespace
+} // end namespace
+
+#endif /*! _PASL_DATA_BTREE_H_ */
@@ -38,7 +38,7 @@ class Dummy_pointer_deleter { // does nothing
 public:
   static constexpr bool should_use = false;
   template <class Item>
-  static void dealloc(Item x) {
+  static void dealloc(Item&) {
     assert(false);
   }
 };
@@ -59,7 +59,7 @@ class Dummy_pointer_deep_copier {  // does nothing
 public:
   static constexpr bool should_use = false;
   template <class Item>
-  static Item copy(Item x) {
+  static Item& copy(Item& x) {
     assert(false);
     return x;
   };
@@ -233,6 +233,11 @@ public:
   bool full() const {
     return items.full();
   }
+
+  //! capacity of this particular chunk, which is at most `capacity`
+  int get_capacity() const {
+    return items.get_capacity();
+  }
   
   bool empty() const {
     return items.empty();
@@ -319,8 +324,32 @@ public:
     incr_back(meas(x));
   }
   
+  void push_front(const measure_type& meas, value_type&& x) {
+    measured_type m = meas(x);
+    items.push_front(std::move(x));
+    incr_front(m);
+  }
+  
+  void push_back(const measure_type& meas, value_type&& x) {
+    measured_type m = meas(x);
+    items.push_back(std::move(x));
+    incr_back(m);
+  }
+  
+  template <class... Args>
+  void emplace_front(const measure_type& meas, Args&&... args) {
+    items.emplace_front(std::forward<Args>(args)...);
+    incr_front(meas(front()));
+  }
+  
+  template <class... Args>
+  void emplace_back(const measure_type& meas, Args&&... args) {
+    items.emplace_back(std::forward<Args>(args)...);
+    incr_back(meas(back()));
+  }
+  
   value_type pop_front(const measure_type& meas) {
-    value_type v = front();
+    value_type v = std::move(front());
     if (algebra_type::has_inverse)
       decr_front(meas(v));
     items.pop_front();
@@ -330,7 +359,7 @@ public:
   }
   
   value_type pop_back(const measure_type& meas) {
-    value_type v = back();
+    value_type v = std::move(back());
     if (algebra_type::has_inverse)
       decr_back(meas(v));
     items.pop_back();
@@ -537,7 +566,7 @@ public:
                                        self_type& other) {
     value_type x;
     prefix = split(meas, p, search, search_meas, prefix, x, other);
-    other.push_front(meas, x);
+    other.emplace_front(meas, std::move(x));
     return prefix;
   }
   
@@ -0,0 +1,184 @@
+/*!
+ * \author Umut A. Acar
+ * \author Arthur Chargueraud
+ * \author Mike Rainey
+ * \date 2013-2018
+ * \copyright 2014 Umut A. Acar, Arthur Chargueraud, Mike Rainey
+ *
+ * \brief Chunk capacities chosen at run time
+ * \file chunkcapacity.hpp
+ *
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "fixedcapacity.hpp"
+
+#ifndef _PASL_DATA_CHUNKCAPACITY_H_
+#define _PASL_DATA_CHUNKCAPACITY_H_
+
+namespace pasl {
+namespace data {
+namespace chunkedseq {
+namespace chunkcapacity {
+
+/***********************************************************************/
+
+/*---------------------------------------------------------------------*/
+/* Settings
+ *
+ * The capacity of the chunks of a tunable container is read from the
+ * settings below when the chunk is constructed. Settings are per
+ * class of item size, where class `k` holds the items whose size in
+ * bytes is in (2^(k-1), 2^k]; a class that has no setting uses the
+ * default capacity.
+ *
+ * The settings are global to the process, as chunks move between
+ * threads. They are meant to be set at startup: containers that exist
+ * at the time of a change, as well as the empty chunks kept by the
+ * chunk pools, keep their former capacity. Containers created before
+ * and after a change shall not be combined (by concat, split or swap),
+ * and the pools shall be flushed after a change
+ * (`config_type::chunk_pool_type::flush()`).
+ */
+
+static constexpr int max_capacity = 1 << 14;
+static constexpr int default_capacity = 512;
+static constexpr int nb_size_classes = 32;
+
+template <class Dummy=void>
+class settings {
+public:
+  static int default_capacity;
+  static int by_size_class[nb_size_classes]; // 0 when unset
+};
+
+template <class Dummy>
+int settings<Dummy>::default_capacity = chunkcapacity::default_capacity;
+
+template <class Dummy>
+int settings<Dummy>::by_size_class[nb_size_classes];
+
+static inline int size_class_of(size_t item_szb) {
+  int k = 0;
+  while (k + 1 < nb_size_classes && (size_t(1) << k) < item_szb)
+    k++;
+  return k;
+}
+
+//! Capacity of the chunks that are created from now on for items of `item_szb` bytes
+static inline int get_capacity(size_t item_szb) {
+  int cap = settings<>::by_size_class[size_class_of(item_szb)];
+  return (cap == 0) ? settings<>::default_capacity : cap;
+}
+
+static inline void set_capacity(size_t item_szb, int capacity) {
+  assert(capacity >= 0);
+  settings<>::by_size_class[size_class_of(item_szb)] = capacity;
+}
+
+static inline void set_default_capacity(int capacity) {
+  assert(capacity > 0);
+  settings<>::default_capacity = capacity;
+}
+
+static inline void reset() {
+  settings<>::default_capacity = default_capacity;
+  for (int k = 0; k < nb_size_classes; k++)
+    settings<>::by_size_class[k] = 0;
+}
+
+/*---------------------------------------------------------------------*/
+/* Configuration files
+ *
+ * A configuration file, as written by the autotuning mode of the
+ * chunkedseq benchmark, has one line
+ *
+ *     <pattern> <item size in bytes> <capacity>
+ *
+ * for each access pattern and item size that was measured, where
+ * patterns are the names of the benchmark scenarios (e.g., `fifo`,
+ * `lifo`, `split_merge`). Lines starting with `#` are comments.
+ */
+
+class entry_type {
+public:
+  std::string pattern;
+  size_t item_szb;
+  int capacity;
+};
+
+static inline bool write(const std::string& path, const std::vector<entry_type>& entries) {
+  FILE* f = fopen(path.c_str(), "w");
+  if (f == NULL)
+    return false;
+  fprintf(f, "# pattern item_szb capacity\n");
+  for (const entry_type& e : entries)
+    fprintf(f, "%s %zu %d\n", e.pattern.c_str(), e.item_szb, e.capacity);
+  return fclose(f) == 0;
+}
+
+static inline bool read(const std::string& path, std::vector<entry_type>& entries) {
+  FILE* f = fopen(path.c_str(), "r");
+  if (f == NULL)
+    return false;
+  char line[256];
+  char pattern[128];
+  while (fgets(line, sizeof(line), f) != NULL) {
+    entry_type e;
+    if (line[0] == '#' || sscanf(line, "%127s %zu %d", pattern, &e.item_szb, &e.capacity) != 3)
+      continue;
+    e.pattern = pattern;
+    entries.push_back(e);
+  }
+  fclose(f);
+  return true;
+}
+
+/*! \brief Applies the entries of the configuration file at `path`
+ *  that were measured for the access pattern `pattern`
+ *
+ * Returns `false` if the file cannot be read.
+ */
+static inline bool load(const std::string& path, const std::string& pattern) {
+  std::vector<entry_type> entries;
+  if (! read(path, entries))
+    return false;
+  for (const entry_type& e : entries)
+    if (e.pattern == pattern)
+      set_capacity(e.item_szb, e.capacity);
+  return true;
+}
+
+/*---------------------------------------------------------------------*/
+/* Chunk structure */
+
+template <class Item>
+class capacity_of_item {
+public:
+  static int get() {
+    return get_capacity(sizeof(Item));
+  }
+};
+
+/*!
+ * \brief Ring buffer whose capacity is given by the settings for the
+ * size of `Item`, at the time the buffer is constructed
+ *
+ * Its signature matches the `Chunk_struct` parameter of the chunked
+ * sequence, where `Max_capacity` takes the place of the capacity.
+ */
+template <class Item, int Max_capacity, class Item_alloc = std::allocator<Item>>
+using ringbuffer = fixedcapacity::base::ringbuffer_pow2<Item, Max_capacity, capacity_of_item<Item>, Item_alloc>;
+
+/***********************************************************************/
+
+} // end namespace
+} // end namespace
+} // end namespace
+} // end namespace
+
+#endif /*! _PASL_DATA_CHUNKCAPACITY_H_ */
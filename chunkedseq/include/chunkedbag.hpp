@@ -15,9 +15,11 @@
 
 #include "fixedcapacity.hpp"
 #include "chunk.hpp"
+#include "chunkpool.hpp"
 #include "cachedmeasure.hpp"
 #include "bootchunkedseq.hpp"
 #include "ftree.hpp"
+#include "btree.hpp"
 #include "iterator.hpp"
 #include "chunkedseqextras.hpp"
 
@@ -55,6 +57,7 @@ protected:
   using chunk_algebra_type = typename chunk_cache_type::algebra_type;
   using chunk_measure_type = typename chunk_cache_type::measure_type;
   using chunk_pointer = chunk_type*;
+  using chunk_pool_type = typename Configuration::chunk_pool_type;
   
   using middle_type = typename Configuration::middle_type;
   using middle_cache_type = typename Configuration::middle_cache_type;
@@ -118,13 +121,13 @@ protected:
   /*---------------------------------------------------------------------*/
 
   static inline chunk_pointer chunk_alloc() {
-    return new chunk_type();
-  } 
+    return chunk_pool_type::alloc();
+  }
 
   // only to free empty chunks
   static inline void chunk_free(chunk_pointer c) {
     assert(c->empty());
-    delete c;
+    chunk_pool_type::free(c);
   }
   
   template <class Pred>
@@ -852,6 +855,11 @@ public:
 
 //  using annotation_type = annotation::annotation_builder<annotation::with_measured<middle_measured_type>>;
   using chunk_type = chunk<item_queue_type, chunk_cache_type, annotation_type>;
+#ifdef DISABLE_CHUNK_POOL
+  using chunk_pool_type = chunkpool::without_pool<chunk_type>;
+#else
+  using chunk_pool_type = chunkpool::thread_local_pool<chunk_type>;
+#endif
   
   class middle_cache_type {
   public:
@@ -991,6 +999,20 @@ using bagopt = chunkedbagbase<basic_bag_configuration<Item, Chunk_capacity, Cach
   
 } // end namespace
 
+/*---------------------------------------------------------------------*/
+/* Instantiation for the B+-tree */
+
+namespace btree {
+
+template <
+  class Item,
+  int Chunk_capacity = 512,
+  class Cache = cachedmeasure::trivial<Item, size_t>,
+  class Item_alloc = std::allocator<Item>>
+using bagopt = chunkedbagbase<basic_bag_configuration<Item, Chunk_capacity, Cache, fixedcapacity::heap_allocated::stack, bplustree, Item_alloc>>;
+
+} // end namespace
+
 /***********************************************************************/
 
 } // end namespace
@@ -14,10 +14,13 @@
 
 #include "fixedcapacity.hpp"
 #include "chunk.hpp"
+#include "chunkpool.hpp"
+#include "chunkcapacity.hpp"
 #include "cachedmeasure.hpp"
 #include "chunkedseqbase.hpp"
 #include "bootchunkedseq.hpp"
 #include "ftree.hpp"
+#include "btree.hpp"
 
 #ifndef _PASL_DATA_CHUNKEDSEQ_H_
 #define _PASL_DATA_CHUNKEDSEQ_H_
@@ -96,6 +99,11 @@ public:
 #endif
   using annotation_type = annotation::annotation_builder<cached_prefix_type, parent_pointer_type>;
   using chunk_type = chunk<item_queue_type, chunk_cache_type, annotation_type>;
+#ifdef DISABLE_CHUNK_POOL
+  using chunk_pool_type = chunkpool::without_pool<chunk_type>;
+#else
+  using chunk_pool_type = chunkpool::thread_local_pool<chunk_type>;
+#endif
 
   class middle_cache_type {
   public:
@@ -237,6 +245,16 @@ template <
 >
 using stack = deque<Item, Chunk_capacity, Cache, fixedcapacity::heap_allocated::stack, Item_alloc>;
 
+// Application of chunked deque to a configuration where the capacity
+// of the chunks is chosen at run time (see chunkcapacity.hpp)
+
+template <
+  class Item,
+  class Cache = cachedmeasure::trivial<Item, size_t>,
+  class Item_alloc = std::allocator<Item>
+>
+using tunable_deque = deque<Item, chunkcapacity::max_capacity, Cache, chunkcapacity::ringbuffer, Item_alloc>;
+
 } // end namespace bootstrapped
 
 /*---------------------------------------------------------------------*/
@@ -273,6 +291,56 @@ using stack = deque<Item, Chunk_capacity, Cache, fixedcapacity::heap_allocated::
 
 } // end namespace ftree
 
+/*---------------------------------------------------------------------*/
+/* Instantiations for the B+-tree */
+
+namespace btree {
+
+// Application of a chunked B+-tree to a configuration
+
+template <
+  class Item,
+  int Chunk_capacity = 512,
+  class Cache = cachedmeasure::trivial<Item, size_t>,
+  template <
+    class Chunk_item,
+    int Capacity,
+    class Chunk_item_alloc = std::allocator<Item>
+  >
+  class Chunk_struct = fixedcapacity::heap_allocated::ringbuffer_ptrx,
+  class Item_alloc = std::allocator<Item>
+>
+using deque = chunkedseqbase<basic_deque_configuration<Item, Chunk_capacity, Cache, Chunk_struct, bplustree, Item_alloc>>;
+
+template <
+  class Item,
+  int Chunk_capacity = 512,
+  class Cache = cachedmeasure::trivial<Item, size_t>,
+  class Item_alloc = std::allocator<Item>
+>
+using stack = deque<Item, Chunk_capacity, Cache, fixedcapacity::heap_allocated::stack, Item_alloc>;
+
+} // end namespace btree
+
+/*---------------------------------------------------------------------*/
+/* Fork policies for divide-and-conquer bulk operations
+ *
+ * Containers built on the chunked sequence that offer bulk
+ * operations take as template parameter a policy that runs the two
+ * branches of each division. The policy below runs them one after
+ * the other; parallel policies are provided along with the
+ * scheduler (see pcontainer.hpp).
+ */
+
+class sequential_fork2 {
+public:
+  template <class Body1, class Body2>
+  static void fork2(const Body1& b1, const Body2& b2) {
+    b1();
+    b2();
+  }
+};
+
 /***********************************************************************/
 
 } // end namespace
@@ -18,6 +18,7 @@
 
 #include "iterator.hpp"
 #include "chunkedseqextras.hpp"
+#include "prefetch.hpp"
 
 #ifndef _PASL_DATA_CHUNKEDSEQBASE_H_
 #define _PASL_DATA_CHUNKEDSEQBASE_H_
@@ -66,6 +67,7 @@ protected:
   using chunk_algebra_type = typename chunk_cache_type::algebra_type;
   using chunk_measure_type = typename chunk_cache_type::measure_type;
   using chunk_pointer = chunk_type*;
+  using chunk_pool_type = typename Configuration::chunk_pool_type;
 
   using middle_type = typename Configuration::middle_type;
   using middle_cache_type = typename Configuration::middle_cache_type;
@@ -129,16 +131,19 @@ private:
   chunk_measure_type chunk_meas;
   middle_measure_type middle_meas;
 
+  // whether concat fills the chunk at the seam (see set_compact_on_concat)
+  bool compact_on_concat;
+
   /*---------------------------------------------------------------------*/
 
   static inline chunk_pointer chunk_alloc() {
-    return new chunk_type();
+    return chunk_pool_type::alloc();
   }
 
   // only to free empty chunks
   static inline void chunk_free(chunk_pointer c) {
     assert(c->empty());
-    delete c;
+    chunk_pool_type::free(c);
   }
 
   template <class Pred>
@@ -347,6 +352,22 @@ private:
     return prefix;
   }
 
+  // applies f to the chunks of the middle sequence, from left to right,
+  // prefetching the chunks ahead of f (see prefetch.hpp)
+  template <class Body>
+  void middle_for_each_prefetching(const Body& f) const {
+    int distance = prefetch::get_distance();
+    if (distance == 0) {
+      middle->for_each(f);
+      return;
+    }
+    prefetch::window<chunk_pointer> w(distance);
+    middle->for_each([&] (chunk_pointer p) {
+      w.push(p, f);
+    });
+    w.flush(f);
+  }
+
   // precondition: other is empty
   template <class Pred>
   middle_measured_type split_aux(const Pred& p, middle_measured_type prefix, reference x, self_type& other) {
@@ -400,7 +421,7 @@ private:
     value_type x;
     prefix = split_aux(p, prefix, x, other);
     if (size_access::csize(prefix) < sz_orig)
-      other.push_front(x);
+      other.emplace_front(std::move(x));
     return prefix;
   }
 
@@ -422,8 +443,9 @@ private:
   }
 
   // take a chunk "c" and concatenate its content into the back of the middle sequence
-  // leaving "c" empty.
-  void push_buffer_back(chunk_type& c) {
+  // leaving "c" empty; if "fill" is set and "c" does not fit in the last chunk of the
+  // middle sequence, that chunk is first filled from the front of "c".
+  void push_buffer_back(chunk_type& c, bool fill = false) {
     size_t csize = c.size();
     if (csize == 0) {
       // do nothing
@@ -432,7 +454,12 @@ private:
     } else {
       chunk_pointer b = middle->back();
       size_t bsize = b->size();
-      if (bsize + csize > chunk_capacity) {
+      if (bsize + csize > b->get_capacity()) {
+        if (fill && bsize < b->get_capacity()) {
+          middle->pop_back(middle_meas);
+          c.transfer_from_front_to_back(chunk_meas, *b, b->get_capacity() - bsize);
+          middle->push_back(middle_meas, b);
+        }
         push_buffer_back_force(c);
       } else {
         middle->pop_back(middle_meas);
@@ -443,7 +470,7 @@ private:
   }
 
   // symmetric to push_buffer_back
-  void push_buffer_front(chunk_type& c) {
+  void push_buffer_front(chunk_type& c, bool fill = false) {
     size_t csize = c.size();
     if (csize == 0) {
       // do nothing
@@ -452,7 +479,12 @@ private:
     } else {
       chunk_pointer b = middle->front();
       size_t bsize = b->size();
-      if (bsize + csize > chunk_capacity) {
+      if (bsize + csize > b->get_capacity()) {
+        if (fill && bsize < b->get_capacity()) {
+          middle->pop_front(middle_meas);
+          c.transfer_from_back_to_front(chunk_meas, *b, b->get_capacity() - bsize);
+          middle->push_front(middle_meas, b);
+        }
         push_buffer_front_force(c);
       } else {
         middle->pop_front(middle_meas);
@@ -464,6 +496,7 @@ private:
 
   void init() {
     middle.reset(new middle_type());
+    compact_on_concat = false;
   }
 
 public:
@@ -501,7 +534,7 @@ public:
    */
   chunkedseqbase(size_type n, const value_type& val) {
     init();
-    std::vector<value_type> vals(chunk_capacity, val);
+    std::vector<value_type> vals(back_outer.get_capacity(), val);
     const value_type* p = vals.data();
     auto prod = [&] (size_type, size_type nb) {
       return std::make_pair(p, p + nb);
@@ -527,7 +560,8 @@ public:
     back_inner(other.back_inner),
     back_outer(other.back_outer),
     chunk_meas(other.chunk_meas),
-    middle_meas(other.middle_meas) {
+    middle_meas(other.middle_meas),
+    compact_on_concat(other.compact_on_concat) {
     middle.reset(new middle_type(*other.middle));
     check();
   }
@@ -601,11 +635,13 @@ public:
    * container.
    *
    */
-  value_type front() const {
+  reference front() const {
     assert(! front_outer.empty() || front_inner.empty());
-    value_type v;
     if (! front_outer.empty()) {
       return front_outer.front();
+    } else if (! middle->empty()) {
+      // a split may leave front_outer empty while middle is not
+      return middle->front()->front();
     } else if (! back_inner.empty()) {
       return back_inner.front();
     } else {
@@ -629,10 +665,13 @@ public:
    * container.
    *
    */
-  value_type back() const {
+  reference back() const {
     assert(! back_outer.empty() || back_inner.empty());
     if (! back_outer.empty()) {
       return back_outer.back();
+    } else if (! middle->empty()) {
+      // a split may leave back_outer empty while middle is not
+      return middle->cback()->back();
     } else if (! front_inner.empty()) {
       return front_inner.back();
     } else {
@@ -743,7 +782,10 @@ public:
   value_type operator[](size_type n) const {
     assert(n >= 0);
     assert(n < size());
-    auto it = begin() + n;
+    // the end iterator is obtained without a search, so that only the
+    // decrement searches, and only if the item is not in the last chunk
+    auto it = end();
+    it -= size() - n;
     assert(it.size() == n + 1);
     return *it;
   }
@@ -768,7 +810,10 @@ public:
   reference operator[](size_type n) {
     assert(n >= 0);
     assert(n < size());
-    auto it = begin() + n;
+    // the end iterator is obtained without a search, so that only the
+    // decrement searches, and only if the item is not in the last chunk
+    auto it = end();
+    it -= size() - n;
     assert(it.size() == n + 1);
     return *it;
   }
@@ -802,6 +847,16 @@ public:
     front_outer.push_front(chunk_meas, x);
   }
 
+  void push_front(value_type&& x) {
+    if (front_outer.full()) {
+      if (front_inner.full())
+        push_buffer_front_force(front_inner);
+      front_outer.swap(front_inner);
+      assert(front_outer.empty());
+    }
+    front_outer.push_front(chunk_meas, std::move(x));
+  }
+
   /*!
    * \brief Adds item at the end
    *
@@ -825,6 +880,58 @@ public:
     back_outer.push_back(chunk_meas, x);
   }
 
+  void push_back(value_type&& x) {
+    if (back_outer.full()) {
+      if (back_inner.full())
+        push_buffer_back_force(back_inner);
+      back_outer.swap(back_inner);
+      assert(back_outer.empty());
+    }
+    back_outer.push_back(chunk_meas, std::move(x));
+  }
+
+  /*!
+   * \brief Constructs item at the beginning
+   *
+   * Adds a new item to the front of the container, which is
+   * constructed in place from the arguments `args`.
+   *
+   * #### Complexity ####
+   * Amortized constant (worst case logarithmic).
+   *
+   */
+  template <class... Args>
+  void emplace_front(Args&&... args) {
+    if (front_outer.full()) {
+      if (front_inner.full())
+        push_buffer_front_force(front_inner);
+      front_outer.swap(front_inner);
+      assert(front_outer.empty());
+    }
+    front_outer.emplace_front(chunk_meas, std::forward<Args>(args)...);
+  }
+
+  /*!
+   * \brief Constructs item at the end
+   *
+   * Adds a new item to the back of the container, which is
+   * constructed in place from the arguments `args`.
+   *
+   * #### Complexity ####
+   * Amortized constant (worst case logarithmic).
+   *
+   */
+  template <class... Args>
+  void emplace_back(Args&&... args) {
+    if (back_outer.full()) {
+      if (back_inner.full())
+        push_buffer_back_force(back_inner);
+      back_outer.swap(back_inner);
+      assert(back_outer.empty());
+    }
+    back_outer.emplace_back(chunk_meas, std::forward<Args>(args)...);
+  }
+
   /*!
    * \brief Deletes first item
    *
@@ -1055,7 +1162,7 @@ public:
     c.swap(back_outer);
     size_type i = 0;
     while (i < nb) {
-      size_type cap = (size_type)chunk_capacity;
+      size_type cap = (size_type)c.get_capacity();
       size_type m = std::min(cap, nb - i);
       m = std::min(m, cap - c.size());
       std::pair<const_pointer,const_pointer> rng = prod(i, m);
@@ -1101,7 +1208,7 @@ public:
     c.swap(front_outer);
     size_type n = nb;
     while (n > 0) {
-      size_type cap = (size_type)chunk_capacity;
+      size_type cap = (size_type)c.get_capacity();
       size_type m = std::min(cap, n);
       m = std::min(m, cap - c.size());
       n -= m;
@@ -1215,23 +1322,39 @@ public:
     if (size() == 0)
       swap(other);
     // push buffers into the middle sequences
-    push_buffer_back(back_inner);
-    push_buffer_back(back_outer);
-    other.push_buffer_front(other.front_inner);
-    other.push_buffer_front(other.front_outer);
+    push_buffer_back(back_inner, compact_on_concat);
+    push_buffer_back(back_outer, compact_on_concat);
+    other.push_buffer_front(other.front_inner, compact_on_concat);
+    other.push_buffer_front(other.front_outer, compact_on_concat);
     // fuse front and back, if needed
     if (! middle->empty() && ! other.middle->empty()) {
       chunk_pointer c1 = middle->back();
       chunk_pointer c2 = other.middle->front();
       size_type nb1 = c1->size();
       size_type nb2 = c2->size();
-      if (nb1 + nb2 <= chunk_capacity) {
+      if (nb1 + nb2 <= c1->get_capacity()) {
         middle->pop_back(middle_meas);
         other.middle->pop_front(middle_meas);
         c2->transfer_from_front_to_back(chunk_meas, *c1, nb2);
         chunk_free(c2);
         middle->push_back(middle_meas, c1);
         // note: push might be factorized with earlier operations
+      } else if (compact_on_concat && nb1 < c1->get_capacity()) {
+        // fill c1 from the front of c2, then fuse what is left of c2
+        // with its successor if they fit in one chunk
+        middle->pop_back(middle_meas);
+        other.middle->pop_front(middle_meas);
+        c2->transfer_from_front_to_back(chunk_meas, *c1, c1->get_capacity() - nb1);
+        middle->push_back(middle_meas, c1);
+        chunk_pointer c3 = other.middle->empty() ? nullptr : other.middle->front();
+        if (c3 != nullptr && c2->size() + c3->size() <= c3->get_capacity()) {
+          other.middle->pop_front(middle_meas);
+          c2->transfer_from_back_to_front(chunk_meas, *c3, c2->size());
+          chunk_free(c2);
+          other.middle->push_front(middle_meas, c3);
+        } else {
+          other.middle->push_front(middle_meas, c2);
+        }
       }
     }
     // migrate back chunks of the other and update the weight
@@ -1401,6 +1524,157 @@ public:
 
   friend void extras::split_by_index<self_type,size_type>(self_type& c, size_type i, self_type& other);
 
+  /*---------------------------------------------------------------------*/
+  /** @name Compaction
+   */
+  ///@{
+
+  /*!
+   * \brief Occupancy of the chunks of a container
+   *
+   * Counts the chunks of the middle sequence, plus the nonempty
+   * buffers. The bytes are those of the item arrays of these chunks
+   * and of the descriptors of the chunks of the middle sequence; the
+   * nodes of the middle sequence itself are not counted.
+   */
+  class density_type {
+  public:
+    size_type nb_items;
+    size_type nb_chunks;
+    size_type nb_slots; // combined capacity of the chunks
+    size_t nb_bytes;
+
+    //! Fraction of the slots that hold an item
+    double items_per_slot() const {
+      return (nb_slots == 0) ? 1.0 : double(nb_items) / double(nb_slots);
+    }
+
+    double bytes_per_item() const {
+      return (nb_items == 0) ? 0.0 : double(nb_bytes) / double(nb_items);
+    }
+  };
+
+  /*!
+   * \brief Measures the occupancy of the chunks
+   *
+   * #### Complexity ####
+   * Linear in the number of chunks.
+   *
+   */
+  density_type get_density() const {
+    density_type d;
+    d.nb_items = size();
+    d.nb_chunks = 0;
+    d.nb_slots = 0;
+    d.nb_bytes = 0;
+    auto add = [&] (const chunk_type& c) {
+      d.nb_chunks++;
+      d.nb_slots += c.get_capacity();
+      d.nb_bytes += c.get_capacity() * sizeof(value_type);
+    };
+    for (const chunk_type* c : { &front_outer, &front_inner, &back_inner, &back_outer })
+      if (! c->empty())
+        add(*c);
+    middle->for_each([&] (chunk_pointer c) {
+      add(*c);
+      d.nb_bytes += sizeof(chunk_type);
+    });
+    return d;
+  }
+
+  /*!
+   * \brief Repacks the items into full chunks
+   *
+   * Moves the items of the inner buffers and of the middle sequence
+   * so that every chunk of the middle sequence but the last one is
+   * full, and frees the chunks left empty. The order of the items
+   * and the cached measurements are preserved. The outer buffers,
+   * which serve the pushes and pops at the two ends, are left as
+   * they are.
+   *
+   * Every item moves at most once.
+   *
+   * #### Complexity ####
+   * Linear in the size of the container.
+   *
+   */
+  void compact() {
+    push_buffer_front(front_inner);
+    push_buffer_back(back_inner);
+    std::unique_ptr<middle_type> packed(new middle_type());
+    chunk_pointer cur = nullptr;
+    while (! middle->empty()) {
+      chunk_pointer c = middle->front();
+      middle->pop_front(middle_meas);
+      if (cur == nullptr) {
+        cur = c;
+        continue;
+      }
+      size_type nb = std::min(c->size(), size_type(cur->get_capacity() - cur->size()));
+      c->transfer_from_front_to_back(chunk_meas, *cur, nb);
+      if (c->empty()) {
+        chunk_free(c);
+      } else {
+        // cur is full; the items of c stay where they are
+        packed->push_back(middle_meas, cur);
+        cur = c;
+      }
+    }
+    if (cur != nullptr)
+      packed->push_back(middle_meas, cur);
+    middle.swap(packed);
+  }
+
+  static constexpr size_type default_compact_cutoff = size_type(1) << 16;
+
+  /*!
+   * \brief Repacks the items into full chunks, in parallel
+   *
+   * Splits the container in two halves, compacts the two halves by
+   * the two branches of `Fork2::fork2` and concatenates the results,
+   * down to containers of `cutoff` items, which are compacted
+   * sequentially. The result has at most one partially filled chunk
+   * in the middle sequence for every `cutoff` items.
+   *
+   * #### Complexity ####
+   * Linear work in the size of the container.
+   *
+   */
+  template <class Fork2>
+  void compact(size_type cutoff = default_compact_cutoff) {
+    size_type n = size();
+    if (n <= std::max(cutoff, size_type(4 * chunk_capacity))) {
+      compact();
+      return;
+    }
+    self_type other;
+    copy_measure_to(other);
+    split(n / 2, other);
+    Fork2::fork2([&] { compact<Fork2>(cutoff); },
+                 [&] { other.template compact<Fork2>(cutoff); });
+    concat(other);
+  }
+
+  /*!
+   * \brief Amortized compaction
+   *
+   * When set, `concat` fills the partially filled chunks that it
+   * would otherwise leave side by side where the two containers
+   * meet: a buffer that is moved into the middle sequence first
+   * fills the chunk it is appended to, and the last chunk of the
+   * middle sequence of this container is filled with items from the
+   * first chunk of the other, what remains of which is fused with its
+   * successor if they fit in one chunk. The extra cost is a constant
+   * number of chunks of item moves per `concat`.
+   *
+   * The setting is not exchanged by `swap`. It is off by default.
+   */
+  void set_compact_on_concat(bool b) {
+    compact_on_concat = b;
+  }
+
+  ///@}
+
   /*---------------------------------------------------------------------*/
   /** @name Iterators
    */
@@ -1451,7 +1725,7 @@ public:
    * \return An iterator to the element past the end of the container.
    *
    * #### Complexity ####
-   * Logarithmic time.
+   * Constant time.
    *
    */
   iterator end() const {
@@ -1475,7 +1749,7 @@ public:
   void for_each(const Body& f) const {
     front_outer.for_each(f);
     front_inner.for_each(f);
-    middle->for_each([&] (chunk_pointer p) {
+    middle_for_each_prefetching([&] (chunk_pointer p) {
       p->for_each(f);
     });
     back_inner.for_each(f);
@@ -1523,7 +1797,7 @@ public:
   void for_each_segment(const Body& f) const {
     front_outer.for_each_segment(f);
     front_inner.for_each_segment(f);
-    middle->for_each([&] (chunk_pointer p) {
+    middle_for_each_prefetching([&] (chunk_pointer p) {
       p->for_each_segment(f);
     });
     back_inner.for_each_segment(f);
@@ -1679,7 +1953,7 @@ public:
       size_t scur = c->size();
       assert(scur > 0);
       if (sprev != -1)
-        assert(sprev + scur > chunk_capacity);
+        assert(sprev + scur > c->get_capacity());
       sprev = scur;
     });
     check_size();
@@ -104,7 +104,7 @@ iterator erase(Container& c, iterator first, iterator last) {
   items_to_erase.swap(tmp);
   c.concat(items_to_erase);
   assert(c.size() + nb_to_erase == sz_orig);
-  return c.begin() + sz_first;
+  return c.begin() + (sz_first - 1);
 }
   
 /*---------------------------------------------------------------------*/
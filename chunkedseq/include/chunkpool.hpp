@@ -0,0 +1,223 @@
+/*!
+ * \author Umut A. Acar
+ * \author Arthur Chargueraud
+ * \author Mike Rainey
+ * \date 2013-2018
+ * \copyright 2014 Umut A. Acar, Arthur Chargueraud, Mike Rainey
+ *
+ * \brief Recycling of empty chunks
+ * \file chunkpool.hpp
+ *
+ */
+
+#include <assert.h>
+#include <cstdint>
+
+#ifndef _PASL_DATA_CHUNKPOOL_H_
+#define _PASL_DATA_CHUNKPOOL_H_
+
+namespace pasl {
+namespace data {
+namespace chunkedseq {
+namespace chunkpool {
+
+/***********************************************************************/
+
+/*---------------------------------------------------------------------*/
+/* Statistics and settings */
+
+//! Counters of the pools of the calling thread, for all chunk types
+class stats_type {
+public:
+  uint64_t nb_hits = 0;       //! allocations served by a pool
+  uint64_t nb_misses = 0;     //! allocations served by the allocator
+  uint64_t nb_recycled = 0;   //! frees that returned a chunk to a pool
+  uint64_t nb_released = 0;   //! frees that returned a chunk to the allocator
+};
+
+static constexpr int default_max_nb_chunks = 8;
+
+/*! \class settings
+ *  \brief Per-thread state shared by the pools of all chunk types
+ */
+template <class Dummy=void>
+class settings {
+public:
+  static thread_local stats_type stats;
+  static thread_local int max_nb_chunks;
+};
+
+template <class Dummy>
+thread_local stats_type settings<Dummy>::stats;
+
+template <class Dummy>
+thread_local int settings<Dummy>::max_nb_chunks = default_max_nb_chunks;
+
+static inline stats_type get_stats() {
+  return settings<>::stats;
+}
+
+static inline void reset_stats() {
+  settings<>::stats = stats_type();
+}
+
+/*! \brief Sets the maximal number of chunks that each pool of the
+ *  calling thread may keep; 0 disables recycling for this thread.
+ *
+ * Values larger than the capacity of a pool are capped by that capacity.
+ */
+static inline void set_max_nb_chunks(int nb) {
+  settings<>::max_nb_chunks = nb;
+}
+
+/*---------------------------------------------------------------------*/
+/*!
+ * \class without_pool
+ * \brief Chunk allocation policy that uses plain new and delete
+ * \tparam Chunk type of the chunk
+ */
+template <class Chunk>
+class without_pool {
+public:
+
+  using chunk_type = Chunk;
+
+  static chunk_type* alloc() {
+    return new chunk_type();
+  }
+
+  static void free(chunk_type* c) {
+    delete c;
+  }
+
+  static void flush() { }
+
+};
+
+/*---------------------------------------------------------------------*/
+/*!
+ * \class reset_cache_and_annotation
+ * \brief Prepares an empty chunk of a chunked sequence for reuse
+ * \tparam Chunk type of the chunk
+ */
+template <class Chunk>
+class reset_cache_and_annotation {
+public:
+
+  static void reset(Chunk* c) {
+    c->cached = Chunk::algebra_type::identity();
+    c->annotation = typename Chunk::annotation_type();
+  }
+
+};
+
+/*---------------------------------------------------------------------*/
+/*!
+ * \class thread_local_pool
+ * \brief Chunk allocation policy that keeps, for each thread, a bounded
+ * stack of empty chunks ready for reuse
+ * \tparam Chunk type of the chunk
+ * \tparam Capacity maximal number of chunks kept by a thread
+ * \tparam Reset provides `static void reset(Chunk* c)`, which prepares
+ * an empty chunk for reuse
+ *
+ * A recycled chunk keeps its item buffer, so that a chunk obtained
+ * from the pool costs no allocation at all. The pool is shared by all
+ * containers whose chunks have the same type. A chunk may be freed
+ * by a thread other than the one that allocated it.
+ *
+ * The chunks left in the pool of a thread are freed when the thread
+ * exits; chunks freed after this point go back to the allocator.
+ */
+template <
+  class Chunk,
+  int Capacity=default_max_nb_chunks,
+  class Reset=reset_cache_and_annotation<Chunk>
+>
+class thread_local_pool {
+public:
+
+  using chunk_type = Chunk;
+
+private:
+
+  // trivially destructible, so that the pool can still be queried
+  // during the destruction of the objects of static storage duration
+  class pool_type {
+  public:
+    int nb = 0;
+    bool closed = false;
+    chunk_type* chunks[Capacity];
+  };
+
+  class closer_type {
+  public:
+    ~closer_type() {
+      pool_type& p = pool;
+      while (p.nb > 0)
+        delete p.chunks[--p.nb];
+      p.closed = true;
+    }
+  };
+
+  static thread_local pool_type pool;
+  static thread_local closer_type closer;
+
+  static int max_nb() {
+    int m = settings<>::max_nb_chunks;
+    return (m < Capacity) ? m : Capacity;
+  }
+
+public:
+
+  static chunk_type* alloc() {
+    pool_type& p = pool;
+    if (p.nb > 0) {
+      settings<>::stats.nb_hits++;
+      return p.chunks[--p.nb];
+    }
+    settings<>::stats.nb_misses++;
+    return new chunk_type();
+  }
+
+  // only to free empty chunks
+  static void free(chunk_type* c) {
+    assert(c->empty());
+    pool_type& p = pool;
+    if (p.closed || p.nb >= max_nb()) {
+      settings<>::stats.nb_released++;
+      delete c;
+      return;
+    }
+    if (p.nb == 0)
+      (void)&closer; // registers the destructor of the pool
+    Reset::reset(c);
+    p.chunks[p.nb++] = c;
+    settings<>::stats.nb_recycled++;
+  }
+
+  //! Frees the chunks kept by the pool of the calling thread
+  static void flush() {
+    pool_type& p = pool;
+    while (p.nb > 0)
+      delete p.chunks[--p.nb];
+  }
+
+};
+
+template <class Chunk, int Capacity, class Reset>
+thread_local typename thread_local_pool<Chunk,Capacity,Reset>::pool_type
+thread_local_pool<Chunk,Capacity,Reset>::pool;
+
+template <class Chunk, int Capacity, class Reset>
+thread_local typename thread_local_pool<Chunk,Capacity,Reset>::closer_type
+thread_local_pool<Chunk,Capacity,Reset>::closer;
+
+/***********************************************************************/
+
+} // end namespace
+} // end namespace
+} // end namespace
+} // end namespace
+
+#endif /*! _PASL_DATA_CHUNKPOOL_H_ */
@@ -0,0 +1,595 @@
+/*!
+ * \author Umut A. Acar
+ * \author Arthur Chargueraud
+ * \author Mike Rainey
+ * \date 2013-2018
+ * \copyright 2014 Umut A. Acar, Arthur Chargueraud, Mike Rainey
+ *
+ * \brief Chunked sequences of integers whose inner chunks are compressed
+ * \file compressedseq.hpp
+ *
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <type_traits>
+
+#include "fixedcapacity.hpp"
+#include "chunkedseq.hpp"
+
+#ifndef _PASL_DATA_COMPRESSEDSEQ_H_
+#define _PASL_DATA_COMPRESSEDSEQ_H_
+
+namespace pasl {
+namespace data {
+namespace chunkedseq {
+namespace compressed {
+
+/***********************************************************************/
+
+/*---------------------------------------------------------------------*/
+/* Codecs
+ *
+ * A codec encodes an array of at most `Chunk_capacity` integers into
+ * bytes, and decodes it back. Its interface is
+ *
+ *   // upper bound on the size in bytes of the encoding of `nb` items
+ *   static size_t max_szb(int nb);
+ *   // writes the encoding at `dst`; returns its size in bytes
+ *   static size_t encode(const Int* src, int nb, unsigned char* dst);
+ *   static void decode(const unsigned char* src, int nb, Int* dst);
+ */
+
+/*!
+ * \class delta_varint
+ * \brief Stores the differences between consecutive items, in zigzag
+ * order, as variable-length integers of seven bits per byte
+ *
+ * Suited to items that are sorted or clustered: a difference smaller
+ * than 64 in absolute value takes one byte. In the worst case, an
+ * item takes one byte more than its fixed-size representation.
+ */
+template <class Int>
+class delta_varint {
+private:
+
+  static_assert(std::is_integral<Int>::value, "codec requires integral items");
+
+  using unsigned_type = typename std::make_unsigned<Int>::type;
+  using signed_type = typename std::make_signed<Int>::type;
+
+  static constexpr int nb_bits = 8 * sizeof(Int);
+
+public:
+
+  static size_t max_szb(int nb) {
+    return size_t(nb) * ((nb_bits + 6) / 7);
+  }
+
+  static size_t encode(const Int* src, int nb, unsigned char* dst) {
+    unsigned char* p = dst;
+    unsigned_type prev = 0;
+    for (int i = 0; i < nb; i++) {
+      unsigned_type x = unsigned_type(src[i]);
+      signed_type d = signed_type(unsigned_type(x - prev));
+      unsigned_type z = unsigned_type((unsigned_type(d) << 1) ^ unsigned_type(d >> (nb_bits - 1)));
+      while (z >= 0x80) {
+        *p++ = (unsigned char)(z | 0x80);
+        z = unsigned_type(z >> 7);
+      }
+      *p++ = (unsigned char)z;
+      prev = x;
+    }
+    return size_t(p - dst);
+  }
+
+  static void decode(const unsigned char* src, int nb, Int* dst) {
+    unsigned_type prev = 0;
+    for (int i = 0; i < nb; i++) {
+      unsigned_type z = 0;
+      int shift = 0;
+      unsigned char b;
+      do {
+        b = *src++;
+        z = unsigned_type(z | (unsigned_type(b & 0x7f) << shift));
+        shift += 7;
+      } while (b & 0x80);
+      unsigned_type d = unsigned_type((z >> 1) ^ (unsigned_type(0) - unsigned_type(z & 1)));
+      prev = unsigned_type(prev + d);
+      dst[i] = Int(prev);
+    }
+  }
+
+};
+
+/*!
+ * \class bitpacked
+ * \brief Stores the smallest item, then the differences between the
+ * items and the smallest one, packed with as many bits each as the
+ * largest difference requires
+ *
+ * Suited to items that fall within a narrow range, in any order.
+ * Decoding takes the same time for every item, with no branch per
+ * byte. The items are packed in 64-bit words.
+ */
+template <class Int>
+class bitpacked {
+private:
+
+  static_assert(std::is_integral<Int>::value, "codec requires integral items");
+
+  using unsigned_type = typename std::make_unsigned<Int>::type;
+
+  static constexpr int nb_bits = 8 * sizeof(Int);
+  static constexpr size_t header_szb = sizeof(Int) + 1;
+
+  static uint64_t load_word(const unsigned char* words, size_t k) {
+    uint64_t w;
+    memcpy(&w, words + 8 * k, 8);
+    return w;
+  }
+
+public:
+
+  static size_t max_szb(int nb) {
+    return header_szb + 8 * ((size_t(nb) * nb_bits + 63) / 64);
+  }
+
+  static size_t encode(const Int* src, int nb, unsigned char* dst) {
+    Int lo = src[0];
+    Int hi = src[0];
+    for (int i = 1; i < nb; i++) {
+      lo = std::min(lo, src[i]);
+      hi = std::max(hi, src[i]);
+    }
+    uint64_t range = uint64_t(unsigned_type(unsigned_type(hi) - unsigned_type(lo)));
+    int width = 0;
+    while (width < 64 && (range >> width) != 0)
+      width++;
+    memcpy(dst, &lo, sizeof(Int));
+    dst[sizeof(Int)] = (unsigned char)width;
+    unsigned char* words = dst + header_szb;
+    size_t nb_words = 0;
+    uint64_t acc = 0;
+    int fill = 0;
+    for (int i = 0; i < nb && width > 0; i++) {
+      uint64_t v = uint64_t(unsigned_type(unsigned_type(src[i]) - unsigned_type(lo)));
+      acc |= v << fill;
+      fill += width;
+      if (fill >= 64) {
+        memcpy(words + 8 * nb_words++, &acc, 8);
+        fill -= 64;
+        acc = (fill == 0) ? 0 : v >> (width - fill);
+      }
+    }
+    if (fill > 0)
+      memcpy(words + 8 * nb_words++, &acc, 8);
+    return header_szb + 8 * nb_words;
+  }
+
+  static void decode(const unsigned char* src, int nb, Int* dst) {
+    Int lo;
+    memcpy(&lo, src, sizeof(Int));
+    int width = src[sizeof(Int)];
+    const unsigned char* words = src + header_szb;
+    uint64_t mask = (width == 64) ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+    size_t pos = 0;
+    for (int i = 0; i < nb; i++, pos += width) {
+      if (width == 0) {
+        dst[i] = lo;
+        continue;
+      }
+      size_t k = pos / 64;
+      int off = int(pos % 64);
+      uint64_t v = load_word(words, k) >> off;
+      if (off + width > 64)
+        v |= load_word(words, k + 1) << (64 - off);
+      dst[i] = Int(unsigned_type(unsigned_type(lo) + unsigned_type(v & mask)));
+    }
+  }
+
+};
+
+/*---------------------------------------------------------------------*/
+/* Compressed chunks */
+
+class block {
+public:
+
+  int nb;       // number of items
+  int nb_bytes; // size of the encoding
+
+  unsigned char* bytes() {
+    return reinterpret_cast<unsigned char*>(this + 1);
+  }
+
+  const unsigned char* bytes() const {
+    return reinterpret_cast<const unsigned char*>(this + 1);
+  }
+
+};
+
+template <class Codec, class Int>
+block* encode_block(const Int* src, int nb) {
+  assert(nb > 0);
+  block* b = (block*)malloc(sizeof(block) + Codec::max_szb(nb));
+  b->nb = nb;
+  b->nb_bytes = int(Codec::encode(src, nb, b->bytes()));
+  // shrinking in place is cheap with the usual allocators
+  return (block*)realloc(b, sizeof(block) + b->nb_bytes);
+}
+
+static inline block* copy_block(const block* b) {
+  size_t szb = sizeof(block) + b->nb_bytes;
+  block* c = (block*)malloc(szb);
+  memcpy(c, b, szb);
+  return c;
+}
+
+template <class Size>
+class block_measure {
+public:
+
+  using value_type = block*;
+  using measured_type = Size;
+
+  measured_type operator()(const value_type& b) const {
+    return measured_type(b->nb);
+  }
+
+  measured_type operator()(const value_type* lo, const value_type* hi) const {
+    measured_type m = 0;
+    for (const value_type* p = lo; p < hi; p++)
+      m += measured_type((*p)->nb);
+    return m;
+  }
+
+};
+
+template <class Size>
+class block_cache {
+public:
+
+  using size_type = Size;
+  using value_type = block*;
+  using algebra_type = algebra::int_group_under_addition_and_negation<size_type>;
+  using measured_type = typename algebra_type::value_type;
+  using measure_type = block_measure<measured_type>;
+
+  static void swap(measured_type& x, measured_type& y) {
+    std::swap(x, y);
+  }
+
+};
+
+/*---------------------------------------------------------------------*/
+/*!
+ * \class deque
+ * \brief Double-ended queue of integers that keeps its inner chunks
+ * compressed
+ * \tparam Int type of the items; an integral type
+ * \tparam Chunk_capacity capacity of the chunks
+ * \tparam Codec encoding of the inner chunks (see above)
+ *
+ * The container has the layout of a chunked sequence: a front chunk,
+ * a back chunk, and a middle sequence of chunks, except that the
+ * chunks of the middle sequence are sealed, that is, encoded by
+ * `Codec` into a single block of bytes each. The front and back
+ * chunks stay uncompressed, so that pushes and pops at either end
+ * take constant time, plus the time to seal a full chunk or to decode
+ * a sealed one every `Chunk_capacity` operations. The middle sequence
+ * caches the number of items of its chunks, so that `split` takes
+ * logarithmic time plus the time to decode one chunk.
+ *
+ * Iteration decodes the sealed chunks one by one in a buffer: the
+ * bodies given to `for_each` and `for_each_segment` receive items in
+ * that buffer, hence shall not modify them.
+ */
+template <class Int, int Chunk_capacity = 512, class Codec = delta_varint<Int>>
+class deque {
+public:
+
+  using self_type = deque<Int, Chunk_capacity, Codec>;
+  using value_type = Int;
+  using size_type = size_t;
+  using codec_type = Codec;
+
+  static constexpr int chunk_capacity = Chunk_capacity;
+
+private:
+
+  using chunk_type = fixedcapacity::heap_allocated::ringbuffer_ptr<value_type, Chunk_capacity>;
+  using middle_type = bootstrapped::deque<block*, 32, block_cache<size_type>>;
+
+  chunk_type front_chunk;
+  middle_type middle;
+  chunk_type back_chunk;
+
+  void seal_back() {
+    int nb = back_chunk.size();
+    if (nb == 0)
+      return;
+    value_type items[Chunk_capacity];
+    back_chunk.popn_front(items, nb);
+    middle.push_back(encode_block<Codec>(items, nb));
+  }
+
+  void seal_front() {
+    int nb = front_chunk.size();
+    if (nb == 0)
+      return;
+    value_type items[Chunk_capacity];
+    front_chunk.popn_front(items, nb);
+    middle.push_front(encode_block<Codec>(items, nb));
+  }
+
+  void unseal_back() {
+    assert(back_chunk.empty());
+    block* b = middle.pop_back();
+    value_type items[Chunk_capacity];
+    Codec::decode(b->bytes(), b->nb, items);
+    back_chunk.pushn_back(static_cast<const value_type*>(items), b->nb);
+    free(b);
+  }
+
+  void unseal_front() {
+    assert(front_chunk.empty());
+    block* b = middle.pop_front();
+    value_type items[Chunk_capacity];
+    Codec::decode(b->bytes(), b->nb, items);
+    front_chunk.pushn_back(static_cast<const value_type*>(items), b->nb);
+    free(b);
+  }
+
+  // the middle sequence reads the items it removes, to update its
+  // cached measurement: blocks are freed only once removed
+  void free_blocks() {
+    while (! middle.empty())
+      free(middle.pop_back());
+  }
+
+public:
+
+  /*---------------------------------------------------------------------*/
+  /** @name Constructors and destructors
+   */
+  ///@{
+
+  deque() { }
+
+  deque(const self_type& other)
+  : front_chunk(other.front_chunk), back_chunk(other.back_chunk) {
+    other.middle.for_each([&] (block* b) {
+      middle.push_back(copy_block(b));
+    });
+  }
+
+  self_type& operator=(const self_type& other) = delete;
+
+  ~deque() {
+    free_blocks();
+  }
+
+  ///@}
+
+  /*---------------------------------------------------------------------*/
+  /** @name Capacity
+   */
+  ///@{
+
+  size_type size() const {
+    return size_type(front_chunk.size()) + middle.get_cached() + size_type(back_chunk.size());
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  //! Number of bytes taken by the encodings of the sealed chunks
+  size_type nb_sealed_bytes() const {
+    size_type nb = 0;
+    middle.for_each([&] (block* b) {
+      nb += size_type(b->nb_bytes);
+    });
+    return nb;
+  }
+
+  //! Number of items in sealed chunks
+  size_type nb_sealed_items() const {
+    return middle.get_cached();
+  }
+
+  ///@}
+
+  /*---------------------------------------------------------------------*/
+  /** @name Item access
+   */
+  ///@{
+
+  value_type front() const {
+    assert(! empty());
+    if (! front_chunk.empty())
+      return front_chunk.front();
+    if (! middle.empty()) {
+      block* b = middle.front();
+      value_type items[Chunk_capacity];
+      Codec::decode(b->bytes(), b->nb, items);
+      return items[0];
+    }
+    return back_chunk.front();
+  }
+
+  value_type back() const {
+    assert(! empty());
+    if (! back_chunk.empty())
+      return back_chunk.back();
+    if (! middle.empty()) {
+      block* b = middle.back();
+      value_type items[Chunk_capacity];
+      Codec::decode(b->bytes(), b->nb, items);
+      return items[b->nb - 1];
+    }
+    return front_chunk.back();
+  }
+
+  ///@}
+
+  /*---------------------------------------------------------------------*/
+  /** @name Modifiers
+   */
+  ///@{
+
+  void push_back(const value_type& x) {
+    if (back_chunk.full())
+      seal_back();
+    back_chunk.push_back(x);
+  }
+
+  void push_front(const value_type& x) {
+    if (front_chunk.full())
+      seal_front();
+    front_chunk.push_front(x);
+  }
+
+  value_type pop_back() {
+    assert(! empty());
+    if (back_chunk.empty()) {
+      if (middle.empty())
+        return front_chunk.pop_back();
+      unseal_back();
+    }
+    return back_chunk.pop_back();
+  }
+
+  value_type pop_front() {
+    assert(! empty());
+    if (front_chunk.empty()) {
+      if (middle.empty())
+        return back_chunk.pop_front();
+      unseal_front();
+    }
+    return front_chunk.pop_front();
+  }
+
+  void clear() {
+    front_chunk.clear();
+    free_blocks();
+    back_chunk.clear();
+  }
+
+  void swap(self_type& other) {
+    front_chunk.swap(other.front_chunk);
+    middle.swap(other.middle);
+    back_chunk.swap(other.back_chunk);
+  }
+
+  //! Appends the items of `other`, leaving `other` empty
+  void concat(self_type& other) {
+    if (other.empty())
+      return;
+    if (empty()) {
+      swap(other);
+      return;
+    }
+    // avoids sealing two partial chunks in a row when one fits
+    int nb = other.front_chunk.size();
+    if (back_chunk.size() + nb <= Chunk_capacity)
+      other.front_chunk.transfer_from_front_to_back(back_chunk, nb);
+    seal_back();
+    other.seal_front();
+    middle.concat(other.middle);
+    back_chunk.swap(other.back_chunk);
+  }
+
+  /*!
+   * \brief Split by index
+   *
+   * The container is erased after and including the item at
+   * (zero-based) index `i`; the erased items are moved to `other`.
+   * At most one sealed chunk is decoded.
+   *
+   * \pre The `other` container is empty.
+   */
+  void split(size_type i, self_type& other) {
+    assert(other.empty());
+    assert(i <= size());
+    size_type nb_front = size_type(front_chunk.size());
+    size_type nb_middle = middle.get_cached();
+    if (i <= nb_front) {
+      middle.swap(other.middle);
+      back_chunk.swap(other.back_chunk);
+      front_chunk.transfer_from_back_to_front(other.front_chunk, int(nb_front - i));
+    } else if (i >= nb_front + nb_middle) {
+      int nb = int(nb_front + nb_middle + size_type(back_chunk.size()) - i);
+      back_chunk.transfer_from_back_to_front(other.back_chunk, nb);
+    } else {
+      size_type j = i - nb_front;
+      block* b = nullptr;
+      bool found = middle.split([j] (size_type nb) { return nb > j; }, b, other.middle);
+      assert(found);
+      back_chunk.swap(other.back_chunk);
+      int k = int(j - middle.get_cached());
+      value_type items[Chunk_capacity];
+      Codec::decode(b->bytes(), b->nb, items);
+      back_chunk.pushn_back(static_cast<const value_type*>(items), k);
+      other.front_chunk.pushn_back(static_cast<const value_type*>(items + k), b->nb - k);
+      free(b);
+    }
+  }
+
+  void split_approximate(self_type& other) {
+    assert(size() > 1);
+    split(size() / 2, other);
+  }
+
+  ///@}
+
+  /*---------------------------------------------------------------------*/
+  /** @name Iteration
+   */
+  ///@{
+
+  template <class Body>
+  void for_each(const Body& body) const {
+    for_each_segment([&] (value_type* lo, value_type* hi) {
+      for (value_type* p = lo; p < hi; p++)
+        body(*p);
+    });
+  }
+
+  //! Calls `body(lo, hi)` on consecutive ranges of items; sealed chunks are decoded one at a time
+  template <class Body>
+  void for_each_segment(const Body& body) const {
+    front_chunk.for_each_segment(0, front_chunk.size(), body);
+    value_type items[Chunk_capacity];
+    middle.for_each([&] (block* b) {
+      Codec::decode(b->bytes(), b->nb, items);
+      body(items, items + b->nb);
+    });
+    back_chunk.for_each_segment(0, back_chunk.size(), body);
+  }
+
+  ///@}
+
+  void check() const {
+    size_type nb = 0;
+    middle.for_each([&] (block* b) {
+      assert(b->nb > 0 && b->nb <= Chunk_capacity);
+      nb += size_type(b->nb);
+    });
+    assert(nb == middle.get_cached());
+  }
+
+};
+
+/***********************************************************************/
+
+} // end namespace
+} // end namespace
+} // end namespace
+} // end namespace
+
+#endif /*! _PASL_DATA_COMPRESSEDSEQ_H_ */
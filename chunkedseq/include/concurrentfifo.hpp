@@ -0,0 +1,444 @@
+/*!
+ * \author Umut A. Acar
+ * \author Arthur Chargueraud
+ * \author Mike Rainey
+ * \date 2013-2018
+ * \copyright 2014 Umut A. Acar, Arthur Chargueraud, Mike Rainey
+ *
+ * \brief Lock-free multi-producer multi-consumer chunked FIFO
+ * \file concurrentfifo.hpp
+ *
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <atomic>
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "chunkpool.hpp"
+
+#ifndef _PASL_DATA_CONCURRENTFIFO_H_
+#define _PASL_DATA_CONCURRENTFIFO_H_
+
+namespace pasl {
+namespace data {
+namespace chunkedseq {
+namespace concurrent {
+
+/***********************************************************************/
+
+static constexpr int cache_line_szb = 64;
+
+/*---------------------------------------------------------------------*/
+/*!
+ * \class hazard_pointers
+ * \brief Safe memory reclamation by hazard pointers, with one hazard
+ * pointer per thread
+ *
+ * A thread that reads a shared pointer to a node calls `protect` to
+ * announce that it may access the node, and `clear` once it is done.
+ * A node that is no longer reachable from the shared structure is
+ * passed to `retire`; it is reclaimed once no thread announces it
+ * anymore.
+ *
+ * At most `max_nb_threads` threads may use hazard pointers at the
+ * same time. The nodes that a thread retires and that are still
+ * announced when the thread exits are adopted by the next thread that
+ * scans its retired nodes.
+ */
+template <class Dummy=void>
+class hazard_pointers {
+public:
+
+  static constexpr int max_nb_threads = 512;
+
+  using reclaim_type = void (*)(void*);
+
+private:
+
+  class record_type {
+  public:
+    std::atomic<void*> hazard;
+    std::atomic<bool> active;
+    char padding[cache_line_szb - sizeof(std::atomic<void*>) - sizeof(std::atomic<bool>)];
+  };
+
+  class retired_type {
+  public:
+    void* ptr;
+    reclaim_type reclaim;
+  };
+
+  class thread_state_type {
+  public:
+    int id = -1;
+    std::vector<retired_type> retired;
+
+    ~thread_state_type() {
+      if (id < 0)
+        return;
+      scan(*this);
+      if (! retired.empty()) {
+        std::lock_guard<std::mutex> guard(orphans_lock);
+        orphans.insert(orphans.end(), retired.begin(), retired.end());
+        nb_orphans.store((int)orphans.size());
+      }
+      records[id].hazard.store(nullptr);
+      records[id].active.store(false);
+    }
+  };
+
+  static record_type records[max_nb_threads];
+  static std::atomic<int> nb_records;
+  static std::mutex orphans_lock;
+  static std::vector<retired_type> orphans;
+  static std::atomic<int> nb_orphans;
+  static thread_local thread_state_type thread_state;
+
+  static record_type& my_record() {
+    thread_state_type& s = thread_state;
+    if (s.id >= 0)
+      return records[s.id];
+    for (int i = 0; i < max_nb_threads; i++) {
+      bool expected = false;
+      if (! records[i].active.load() && records[i].active.compare_exchange_strong(expected, true)) {
+        s.id = i;
+        int nb = nb_records.load();
+        while (nb < i + 1 && ! nb_records.compare_exchange_weak(nb, i + 1)) { }
+        return records[i];
+      }
+    }
+    assert(false); // more than max_nb_threads threads
+    abort();
+  }
+
+  // reclaims the retired nodes that no thread announces
+  static void scan(thread_state_type& s) {
+    if (nb_orphans.load() > 0) {
+      std::lock_guard<std::mutex> guard(orphans_lock);
+      s.retired.insert(s.retired.end(), orphans.begin(), orphans.end());
+      orphans.clear();
+      nb_orphans.store(0);
+    }
+    std::vector<void*> hazards;
+    int nb = nb_records.load();
+    for (int i = 0; i < nb; i++) {
+      void* p = records[i].hazard.load();
+      if (p != nullptr)
+        hazards.push_back(p);
+    }
+    std::sort(hazards.begin(), hazards.end());
+    std::vector<retired_type> still_hazardous;
+    for (retired_type& r : s.retired) {
+      if (std::binary_search(hazards.begin(), hazards.end(), r.ptr))
+        still_hazardous.push_back(r);
+      else
+        r.reclaim(r.ptr);
+    }
+    s.retired.swap(still_hazardous);
+  }
+
+public:
+
+  //! Returns the current value of `src`, which stays valid until `clear`
+  template <class T>
+  static T* protect(const std::atomic<T*>& src) {
+    record_type& r = my_record();
+    T* p = src.load();
+    while (true) {
+      r.hazard.store(p);
+      T* q = src.load();
+      if (q == p)
+        return p;
+      p = q;
+    }
+  }
+
+  static void clear() {
+    my_record().hazard.store(nullptr, std::memory_order_release);
+  }
+
+  //! `p` must be unreachable from the shared structure
+  static void retire(void* p, reclaim_type reclaim) {
+    my_record();
+    thread_state_type& s = thread_state;
+    s.retired.push_back({ p, reclaim });
+    if ((int)s.retired.size() >= std::max(64, 2 * nb_records.load()))
+      scan(s);
+  }
+
+};
+
+template <class Dummy>
+typename hazard_pointers<Dummy>::record_type
+hazard_pointers<Dummy>::records[hazard_pointers<Dummy>::max_nb_threads];
+
+template <class Dummy>
+std::atomic<int> hazard_pointers<Dummy>::nb_records(0);
+
+template <class Dummy>
+std::mutex hazard_pointers<Dummy>::orphans_lock;
+
+template <class Dummy>
+std::vector<typename hazard_pointers<Dummy>::retired_type>
+hazard_pointers<Dummy>::orphans;
+
+template <class Dummy>
+std::atomic<int> hazard_pointers<Dummy>::nb_orphans(0);
+
+template <class Dummy>
+thread_local typename hazard_pointers<Dummy>::thread_state_type
+hazard_pointers<Dummy>::thread_state;
+
+/*---------------------------------------------------------------------*/
+/*!
+ * \class fifo
+ * \brief Lock-free multi-producer multi-consumer FIFO queue
+ * \tparam Item type of the items
+ * \tparam Chunk_capacity number of items in a chunk
+ *
+ * The queue is a linked list of chunks. Each chunk is an array of
+ * slots along with two counters: producers claim slots by atomically
+ * incrementing the enqueue counter, and consumers by atomically
+ * incrementing the dequeue counter, so that in the common case an
+ * operation costs a single fetch-and-add. Each slot carries a state
+ * word through which the producer and the consumer of the slot
+ * synchronize: a consumer that reaches a slot before its producer
+ * marks the slot as taken, in which case the producer tries again in
+ * a later slot.
+ *
+ * A new chunk is linked when the last chunk is full. Consumed chunks
+ * are reclaimed through hazard pointers, and then recycled through
+ * the same per-thread pools as the chunks of the chunked sequences
+ * (see `chunkpool.hpp`).
+ */
+template <class Item, int Chunk_capacity=512>
+class fifo {
+public:
+
+  using self_type = fifo<Item, Chunk_capacity>;
+  using value_type = Item;
+  using size_type = size_t;
+
+  static constexpr size_type chunk_capacity = size_type(Chunk_capacity);
+
+private:
+
+  using hazard_pointers_type = hazard_pointers<>;
+
+  typedef enum {
+    empty_slot,
+    full_slot,
+    taken_slot
+  } slot_state_type;
+
+  class slot_type {
+  public:
+    std::atomic<int> state;
+    typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type storage;
+
+    value_type* item() {
+      return (value_type*)&storage;
+    }
+  };
+
+  class chunk_type {
+  public:
+    // the two counters are written by different threads
+    std::atomic<size_type> enq_idx;
+    char padding1[cache_line_szb - sizeof(std::atomic<size_type>)];
+    std::atomic<size_type> deq_idx;
+    char padding2[cache_line_szb - sizeof(std::atomic<size_type>)];
+    std::atomic<chunk_type*> next;
+    slot_type slots[Chunk_capacity];
+
+    chunk_type() {
+      reset();
+    }
+
+    // all the slots have been claimed by consumers
+    bool empty() const {
+      return deq_idx.load() >= chunk_capacity;
+    }
+
+    void reset() {
+      enq_idx.store(0, std::memory_order_relaxed);
+      deq_idx.store(0, std::memory_order_relaxed);
+      next.store(nullptr, std::memory_order_relaxed);
+      for (int i = 0; i < Chunk_capacity; i++)
+        slots[i].state.store(empty_slot, std::memory_order_relaxed);
+    }
+  };
+
+  class reset_chunk {
+  public:
+    static void reset(chunk_type* c) {
+      c->reset();
+    }
+  };
+
+#ifdef DISABLE_CHUNK_POOL
+  using chunk_pool_type = chunkpool::without_pool<chunk_type>;
+#else
+  using chunk_pool_type = chunkpool::thread_local_pool<chunk_type, chunkpool::default_max_nb_chunks, reset_chunk>;
+#endif
+
+  std::atomic<chunk_type*> head;
+  char padding[cache_line_szb - sizeof(std::atomic<chunk_type*>)];
+  std::atomic<chunk_type*> tail;
+
+  static void reclaim_chunk(void* c) {
+    chunk_type* d = (chunk_type*)c;
+    // in case the last slots were claimed by no one
+    d->deq_idx.store(chunk_capacity);
+    chunk_pool_type::free(d);
+  }
+
+  // destroys the items of `c` that were not consumed; not thread safe
+  static void destroy_items(chunk_type* c) {
+    size_type hi = std::min(c->enq_idx.load(), chunk_capacity);
+    for (size_type i = c->deq_idx.load(); i < hi; i++) {
+      slot_type& s = c->slots[i];
+      if (s.state.load() == full_slot)
+        s.item()->~value_type();
+    }
+  }
+
+public:
+
+  fifo() {
+    chunk_type* c = chunk_pool_type::alloc();
+    head.store(c);
+    tail.store(c);
+  }
+
+  fifo(const self_type&) = delete;
+  self_type& operator=(const self_type&) = delete;
+
+  //! Requires that no other thread accesses the queue
+  ~fifo() {
+    chunk_type* c = head.load();
+    while (c != nullptr) {
+      chunk_type* n = c->next.load();
+      destroy_items(c);
+      reclaim_chunk(c);
+      c = n;
+    }
+  }
+
+  /*!
+   * \brief Returns whether the queue is empty
+   *
+   * The result may be out of date as soon as it is returned, if
+   * other threads access the queue concurrently.
+   */
+  bool empty() const {
+    chunk_type* h = hazard_pointers_type::protect(head);
+    bool res = h->deq_idx.load() >= std::min(h->enq_idx.load(), chunk_capacity)
+            && h->next.load() == nullptr;
+    hazard_pointers_type::clear();
+    return res;
+  }
+
+  void push_back(const value_type& x) {
+    value_type y = x;
+    push_back(std::move(y));
+  }
+
+  void push_back(value_type&& x) {
+    while (true) {
+      chunk_type* t = hazard_pointers_type::protect(tail);
+      size_type i = t->enq_idx.fetch_add(1);
+      if (i < chunk_capacity) {
+        slot_type& s = t->slots[i];
+        new (s.item()) value_type(std::move(x));
+        int expected = empty_slot;
+        if (s.state.compare_exchange_strong(expected, full_slot)) {
+          hazard_pointers_type::clear();
+          return;
+        }
+        // a consumer gave up on this slot
+        x = std::move(*s.item());
+        s.item()->~value_type();
+        continue;
+      }
+      chunk_type* n = t->next.load();
+      if (n != nullptr) {
+        tail.compare_exchange_strong(t, n);
+        continue;
+      }
+      if (t != tail.load())
+        continue;
+      chunk_type* c = chunk_pool_type::alloc();
+      slot_type& s = c->slots[0];
+      new (s.item()) value_type(std::move(x));
+      s.state.store(full_slot, std::memory_order_relaxed);
+      c->enq_idx.store(1, std::memory_order_relaxed);
+      chunk_type* expected = nullptr;
+      if (t->next.compare_exchange_strong(expected, c)) {
+        tail.compare_exchange_strong(t, c);
+        hazard_pointers_type::clear();
+        return;
+      }
+      // another producer linked a chunk first
+      x = std::move(*s.item());
+      s.item()->~value_type();
+      reclaim_chunk(c);
+    }
+  }
+
+  /*!
+   * \brief Removes the item at the front of the queue
+   *
+   * Returns `false`, leaving `dst` unchanged, if the queue is empty.
+   */
+  bool try_pop_front(value_type& dst) {
+    while (true) {
+      chunk_type* h = hazard_pointers_type::protect(head);
+      size_type d = h->deq_idx.load();
+      size_type e = std::min(h->enq_idx.load(), chunk_capacity);
+      if (d >= e && h->next.load() == nullptr) {
+        hazard_pointers_type::clear();
+        return false;
+      }
+      size_type i = h->deq_idx.fetch_add(1);
+      if (i < chunk_capacity) {
+        slot_type& s = h->slots[i];
+        if (s.state.exchange(taken_slot) != full_slot)
+          continue; // the producer of the slot will try elsewhere
+        dst = std::move(*s.item());
+        s.item()->~value_type();
+        hazard_pointers_type::clear();
+        return true;
+      }
+      chunk_type* n = h->next.load();
+      if (n == nullptr) {
+        hazard_pointers_type::clear();
+        return false;
+      }
+      // the tail must not lag behind the head, or else the chunk could
+      // be reclaimed while still reachable from the tail
+      chunk_type* t = h;
+      tail.compare_exchange_strong(t, n);
+      if (head.compare_exchange_strong(h, n)) {
+        hazard_pointers_type::clear();
+        hazard_pointers_type::retire(h, reclaim_chunk);
+      }
+    }
+  }
+
+};
+
+/***********************************************************************/
+
+} // end namespace
+} // end namespace
+} // end namespace
+} // end namespace
+
+#endif /*! _PASL_DATA_CONCURRENTFIFO_H_ */
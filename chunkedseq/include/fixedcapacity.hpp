@@ -11,6 +11,7 @@
  */
 
 #include "fixedcapacitybase.hpp"
+#include "hugepagealloc.hpp"
 
 #ifndef _PASL_DATA_FIXEDCAPACITY_H_
 #define _PASL_DATA_FIXEDCAPACITY_H_
@@ -40,6 +41,25 @@ namespace heap_allocated {
 
 }
 
+/*---------------------------------------------------------------------*/
+/* Fixed-capacity buffers allocated in huge pages (see hugepagealloc.hpp) */
+
+namespace hugepage_allocated {
+
+  template <class Item, int Capacity, class Alloc = std::allocator<Item>>
+  using ringbuffer_ptr = base::ringbuffer_ptr<hugepage::block_allocator<Item, Capacity+1>>;
+
+  template <class Item, int Capacity, class Alloc = std::allocator<Item>>
+  using ringbuffer_ptrx = base::ringbuffer_ptrx<hugepage::block_allocator<Item, Capacity+1>>;
+
+  template <class Item, int Capacity, class Alloc = std::allocator<Item>>
+  using ringbuffer_idx = base::ringbuffer_idx<hugepage::block_allocator<Item, Capacity>>;
+
+  template <class Item, int Capacity, class Alloc = std::allocator<Item>>
+  using stack = base::stack<hugepage::block_allocator<Item, Capacity>>;
+
+}
+
 /*---------------------------------------------------------------------*/
 /* Inline-allocated fixed-capacity arrays */
   
@@ -110,6 +110,13 @@ public:
 /*---------------------------------------------------------------------*/
 /* Data movement */
 
+/* Items that are trivially copyable are moved around by `memcpy` and
+ * `memmove`; all other items go through their copy or move
+ * constructors and assignment operators.
+ */
+template <class Alloc>
+using is_trivially_copyable = std::is_trivially_copyable<typename Alloc::value_type>;
+
 /*! \brief Polymorphic array copy
  *
  * Copies `num` items from the location pointed to by `source`
@@ -130,19 +137,77 @@ void copy(typename Alloc::pointer destination,
              typename Alloc::size_type num) {
   // ranges must not intersect
   assert(! (source+num >= destination+1 && destination+num >= source+1));
-  std::copy(source, source+num, destination);
+  if (is_trivially_copyable<Alloc>::value)
+    memcpy(destination, source, num * sizeof(typename Alloc::value_type));
+  else
+    std::copy(source, source+num, destination);
 }
 
+/* Policies for moving items between arrays.
+ *
+ *  - `assign_items` copies into initialized cells;
+ *  - `construct_items` copies into uninitialized cells;
+ *  - `relocate_items` moves into uninitialized cells, and leaves the
+ *    source cells uninitialized.
+ */
+
 template <class Alloc>
-void pblit(typename Alloc::const_pointer t1, int i1,
+class assign_items {
+public:
+  using source_pointer = typename Alloc::const_pointer;
+  static void blit(typename Alloc::pointer dst, source_pointer src, int nb) {
+    copy<Alloc>(dst, src, nb);
+  }
+};
+
+template <class Alloc>
+class construct_items {
+public:
+  using source_pointer = typename Alloc::const_pointer;
+  static void blit(typename Alloc::pointer dst, source_pointer src, int nb) {
+    if (is_trivially_copyable<Alloc>::value)
+      copy<Alloc>(dst, src, nb);
+    else
+      std::uninitialized_copy(src, src + nb, dst);
+  }
+};
+
+template <class Alloc>
+class relocate_items {
+public:
+  using source_pointer = typename Alloc::pointer;
+  static void blit(typename Alloc::pointer dst, source_pointer src, int nb) {
+    // dispatched at compile time, so that move-only items never
+    // instantiate the copying path
+    blit(dst, src, nb, is_trivially_copyable<Alloc>());
+  }
+private:
+  static void blit(typename Alloc::pointer dst, source_pointer src, int nb,
+                   std::true_type) {
+    copy<Alloc>(dst, src, nb);
+  }
+  static void blit(typename Alloc::pointer dst, source_pointer src, int nb,
+                   std::false_type) {
+    Alloc alloc;
+    for (int k = 0; k < nb; k++) {
+      alloc.construct(&dst[k], std::move(src[k]));
+      alloc.destroy(&src[k]);
+    }
+  }
+};
+
+template <class Alloc, class Move=assign_items<Alloc>>
+void pblit(typename Move::source_pointer t1, int i1,
            typename Alloc::pointer t2, int i2,
            int nb) {
-  copy<Alloc>(t2 + i2, t1 + i1, nb);
+  Move::blit(t2 + i2, t1 + i1, nb);
 }
 
 template <class Alloc>
 void destroy_items(typename Alloc::pointer t, int i, int nb) {
   typedef typename Alloc::size_type size_type;
+  if (std::is_trivially_destructible<typename Alloc::value_type>::value)
+    return;
   Alloc alloc;
   for (size_type k = 0; k < nb; k++)
     alloc.destroy(&t[k + i]);
@@ -160,6 +225,10 @@ void destroy_items(typename Alloc::pointer t, int nb) {
  * positions. The direction of the shift is determined
  * by whether `shift_by` is positive or negative.
  *
+ * The items are relocated: the cells left behind by the shift are
+ * uninitialized, and so should be the cells that the items are
+ * shifted onto.
+ *
  * To avoid overflows, the size of the array `t` shall be at least
  * `num + abs(shift_by)` items.
  *
@@ -175,13 +244,23 @@ template <class Alloc>
 void pshiftn(typename Alloc::pointer t,
              typename Alloc::size_type num,
              int shift_by) {
-  if (shift_by == 0)
+  if (shift_by == 0 || num == 0)
     return;
+  if (is_trivially_copyable<Alloc>::value) {
+    memmove(t + shift_by, t, num * sizeof(typename Alloc::value_type));
+    return;
+  }
+  Alloc alloc;
   if (shift_by < 0) {
-    for (int i = 0; i < num; i++)
-      t[i+shift_by] = t[i];
+    for (int i = 0; i < num; i++) {
+      alloc.construct(&t[i+shift_by], std::move(t[i]));
+      alloc.destroy(&t[i]);
+    }
   } else {
-    std::copy_backward(t, t + num, t + num + shift_by);
+    for (int i = int(num) - 1; i >= 0; i--) {
+      alloc.construct(&t[i+shift_by], std::move(t[i]));
+      alloc.destroy(&t[i]);
+    }
   }
 }
 
@@ -204,18 +283,18 @@ void pfill(typename Alloc::pointer first,
  * starting at index i1 and possibly wrapping around, into an
  * array t2 starting at index i2 and not wrapping around.
  */
-template <class Alloc, int capacity>
-void copy_data_wrap_src(typename Alloc::const_pointer t1, int i1,
+template <class Alloc, int capacity, class Move=assign_items<Alloc>>
+void copy_data_wrap_src(typename Move::source_pointer t1, int i1,
                         typename Alloc::pointer t2, int i2,
                         int nb) {
   int j1 = i1 + nb;
   if (j1 <= capacity) {
-    pblit<Alloc>(t1, i1, t2, i2, nb);
+    pblit<Alloc, Move>(t1, i1, t2, i2, nb);
   } else {
     int na = capacity - i1;
     int i2_n = (i2 + na) % capacity;
-    pblit<Alloc>(t1, i1, t2, i2, na);
-    pblit<Alloc>(t1, 0, t2, i2_n, nb - na);
+    pblit<Alloc, Move>(t1, i1, t2, i2, na);
+    pblit<Alloc, Move>(t1, 0, t2, i2_n, nb - na);
   }
 }
 
@@ -223,18 +302,18 @@ void copy_data_wrap_src(typename Alloc::const_pointer t1, int i1,
  * and not wrapping around, into an array t2 of size capacity,
  * starting at index i2 and possibly wrapping around.
  */
-template <class Alloc, int capacity>
-void copy_data_wrap_dst(typename Alloc::const_pointer t1, int i1,
+template <class Alloc, int capacity, class Move=construct_items<Alloc>>
+void copy_data_wrap_dst(typename Move::source_pointer t1, int i1,
                         typename Alloc::pointer t2, int i2,
                         int nb) {
   int j2 = i2 + nb;
   if (j2 <= capacity) {
-    pblit<Alloc>(t1, i1, t2, i2, nb);
+    pblit<Alloc, Move>(t1, i1, t2, i2, nb);
   } else {
     int na = capacity - i2;
     int i1_n = (i1 + na) % capacity;
-    pblit<Alloc>(t1, i1, t2, i2, na);
-    pblit<Alloc>(t1, i1_n, t2, 0, nb - na);
+    pblit<Alloc, Move>(t1, i1, t2, i2, na);
+    pblit<Alloc, Move>(t1, i1_n, t2, 0, nb - na);
   }
 }
 
@@ -243,21 +322,29 @@ void copy_data_wrap_dst(typename Alloc::const_pointer t1, int i1,
  * i2 and possibly wrapping around. Both arrays are assumed to be
  * of size capacity.
  */
-template <class Alloc, int capacity>
-void copy_data_wrap_src_and_dst(typename Alloc::const_pointer t1, int i1,
+template <class Alloc, int capacity, class Move=construct_items<Alloc>>
+void copy_data_wrap_src_and_dst(typename Move::source_pointer t1, int i1,
                                 typename Alloc::pointer t2, int i2,
                                 int nb) {
   int j1 = i1 + nb;
   if (j1 <= capacity) {
-    copy_data_wrap_dst<Alloc, capacity>(t1, i1, t2, i2, nb);
+    copy_data_wrap_dst<Alloc, capacity, Move>(t1, i1, t2, i2, nb);
   } else {
     int na = capacity - i1;
     int i2_n = (i2 + na) % capacity;
-    copy_data_wrap_dst<Alloc, capacity>(t1, i1, t2, i2, na);
-    copy_data_wrap_src_and_dst<Alloc, capacity>(t1, 0, t2, i2_n, nb - na);
+    copy_data_wrap_dst<Alloc, capacity, Move>(t1, i1, t2, i2, na);
+    copy_data_wrap_src_and_dst<Alloc, capacity, Move>(t1, 0, t2, i2_n, nb - na);
   }
 }
 
+/* moves n elements, as above, leaving the source cells uninitialized */
+template <class Alloc, int capacity>
+void relocate_data_wrap_src_and_dst(typename Alloc::pointer t1, int i1,
+                                    typename Alloc::pointer t2, int i2,
+                                    int nb) {
+  copy_data_wrap_src_and_dst<Alloc, capacity, relocate_items<Alloc>>(t1, i1, t2, i2, nb);
+}
+
 /* calls the destructor of the first nb items starting at position i
  * in the circular buffer pointed to by t, possibly wrapping around.
  */
@@ -457,6 +544,10 @@ public:
     return size() == capacity;
   }
   
+  inline int get_capacity() const {
+    return capacity;
+  }
+  
   inline bool empty() const {
     return size() == 0;
   }
@@ -465,22 +556,40 @@ public:
     return !empty() && !full(); // TODO: could be optimized
   }
   
-  inline void push_front(const value_type& x) {
+  template <class... Args>
+  inline void emplace_front(Args&&... args) {
     assert(! full());
     fr--;
     if (fr == -1)
       fr += capacity;
     sz++;
-    alloc.construct(&array[fr], x);
+    alloc.construct(&array[fr], std::forward<Args>(args)...);
   }
   
-  inline void push_back(const value_type& x) {
+  template <class... Args>
+  inline void emplace_back(Args&&... args) {
     assert(! full());
     int bk = (fr + sz);
     if (bk >= capacity)
       bk -= capacity;
     sz++;
-    alloc.construct(&array[bk], x);
+    alloc.construct(&array[bk], std::forward<Args>(args)...);
+  }
+  
+  inline void push_front(const value_type& x) {
+    emplace_front(x);
+  }
+  
+  inline void push_front(value_type&& x) {
+    emplace_front(std::move(x));
+  }
+  
+  inline void push_back(const value_type& x) {
+    emplace_back(x);
+  }
+  
+  inline void push_back(value_type&& x) {
+    emplace_back(std::move(x));
   }
   
   inline value_type& front() const {
@@ -498,7 +607,7 @@ public:
   
   inline value_type pop_front() {
     assert(! empty());
-    value_type v = front();
+    value_type v = std::move(front());
     alloc.destroy(&(front()));
     fr++;
     if (fr == capacity)
@@ -509,7 +618,7 @@ public:
   
   inline value_type pop_back() {
     assert(! empty());
-    value_type v = back();
+    value_type v = std::move(back());
     alloc.destroy(&(back()));
     sz--;
     return v;
@@ -622,7 +731,7 @@ public:
   void transfer_from_back_to_front(ringbuffer_idx& target, int nb) {
     int i1 = (fr + sz - nb) % capacity;
     int i2 = (target.fr - nb + capacity) % capacity;
-    copy_data_wrap_src_and_dst<Item_alloc, capacity>(&array[0], i1, &target.array[0], i2, nb);
+    relocate_data_wrap_src_and_dst<Item_alloc, capacity>(&array[0], i1, &target.array[0], i2, nb);
     sz -= nb;
     target.sz += nb;
     target.fr = i2;
@@ -631,7 +740,7 @@ public:
   void transfer_from_front_to_back(ringbuffer_idx& target, int nb) {
     int i1 = fr;
     int i2 = (target.fr + target.sz) % capacity;
-    copy_data_wrap_src_and_dst<Item_alloc, capacity>(&array[0], i1, &target.array[0], i2, nb);
+    relocate_data_wrap_src_and_dst<Item_alloc, capacity>(&array[0], i1, &target.array[0], i2, nb);
     sz -= nb;
     target.sz += nb;
     fr = (i1 + nb) % capacity;
@@ -901,7 +1010,11 @@ public:
     // alternative:
     //   return (nextn(bk, 2) == fr);
   }
-  
+
+  inline int get_capacity() const {
+    return capacity;
+  }
+
   inline bool empty() const {
     return (bk + 1 == fr) || (bk + 1 - nb_cells == fr);
     // very slow:
@@ -925,21 +1038,43 @@ public:
     return *bk;
   }
   
-  inline void push_front(const value_type& x) {
+  // the new item is constructed before the buffer is updated, so that
+  // the buffer is left unchanged if the constructor throws
+  template <class... Args>
+  inline void emplace_front(Args&&... args) {
     assert(! full());
-    fr = prev(fr);
-    alloc.construct(fr, x);
+    value_type* p = prev(fr);
+    alloc.construct(p, std::forward<Args>(args)...);
+    fr = p;
   }
   
-  inline void push_back(const value_type& x) {
+  template <class... Args>
+  inline void emplace_back(Args&&... args) {
     assert(! full());
-    bk = next(bk);
-    alloc.construct(bk, x);
+    value_type* p = next(bk);
+    alloc.construct(p, std::forward<Args>(args)...);
+    bk = p;
+  }
+  
+  inline void push_front(const value_type& x) {
+    emplace_front(x);
+  }
+  
+  inline void push_front(value_type&& x) {
+    emplace_front(std::move(x));
+  }
+  
+  inline void push_back(const value_type& x) {
+    emplace_back(x);
+  }
+  
+  inline void push_back(value_type&& x) {
+    emplace_back(std::move(x));
   }
   
   inline value_type pop_front() {
     assert(! empty());
-    value_type v = *fr;
+    value_type v = std::move(*fr);
     alloc.destroy(fr);
     fr = next(fr);
     return v;
@@ -947,7 +1082,7 @@ public:
   
   inline value_type pop_back() {
     assert(! empty());
-    value_type v = *bk;
+    value_type v = std::move(*bk);
     alloc.destroy(bk);
     bk = prev(bk);
     return v;
@@ -1021,7 +1156,7 @@ public:
     target.fr = target.prevn(target.fr, nb);
     int i1 = array_index_of_pointer(next(bk));
     int i2 = target.array_index_of_pointer(target.fr);
-    copy_data_wrap_src_and_dst<Item_alloc, nb_cells>(beg(), i1, target.beg(), i2, nb);
+    relocate_data_wrap_src_and_dst<Item_alloc, nb_cells>(beg(), i1, target.beg(), i2, nb);
     check();
     target.check();
   }
@@ -1030,7 +1165,7 @@ public:
     assert(0 <= nb && nb <= size());
     int i1 = array_index_of_pointer(fr);
     int i2 = target.array_index_of_pointer(target.next(target.bk));
-    copy_data_wrap_src_and_dst<Item_alloc, nb_cells>(beg(), i1, target.beg(), i2, nb);
+    relocate_data_wrap_src_and_dst<Item_alloc, nb_cells>(beg(), i1, target.beg(), i2, nb);
     fr = nextn(fr, nb);
     target.bk = target.nextn(target.bk, nb);
     check();
@@ -1333,22 +1468,44 @@ public:
     return bk == fr;
   }
   
+  inline int get_capacity() const {
+    return capacity;
+  }
+  
   inline bool empty() const {
     return (bk-fr == 1) || (bk-(fr-nbcells) == 1);
   }
   
-  inline void push_front(const value_type& x) {
+  template <class... Args>
+  inline void emplace_front(Args&&... args) {
     assert(! full());
-    alloc.construct(fr, x);
+    alloc.construct(fr, std::forward<Args>(args)...);
     fr = alloc_front(fr);
   }
   
-  inline void push_back(const value_type& x) {
+  template <class... Args>
+  inline void emplace_back(Args&&... args) {
     assert(! full());
-    alloc.construct(bk, x);
+    alloc.construct(bk, std::forward<Args>(args)...);
     bk = alloc_back(bk);
   }
   
+  inline void push_front(const value_type& x) {
+    emplace_front(x);
+  }
+  
+  inline void push_front(value_type&& x) {
+    emplace_front(std::move(x));
+  }
+  
+  inline void push_back(const value_type& x) {
+    emplace_back(x);
+  }
+  
+  inline void push_back(value_type&& x) {
+    emplace_back(std::move(x));
+  }
+  
   inline value_type& front() const {
     assert(! empty());
     return *addr_of_front(fr);
@@ -1362,7 +1519,7 @@ public:
   inline value_type pop_front() {
     assert(! empty());
     fr = dealloc_front(fr);
-    value_type v = *fr;
+    value_type v = std::move(*fr);
     alloc.destroy(fr);
     return v;
   }
@@ -1370,7 +1527,7 @@ public:
   inline value_type pop_back() {
     assert(! empty());
     bk = dealloc_back(bk);
-    value_type v = *bk;
+    value_type v = std::move(*bk);
     alloc.destroy(bk);
     return v;
   }
@@ -1439,7 +1596,7 @@ public:
     target.fr = target.allocn_front(target.fr, nb);
     int i1 = array_index_of_pointer(bk);
     int i2 = target.array_index_of_front(target.fr);
-    copy_data_wrap_src_and_dst<Item_alloc, nbcells>(beg(), i1, target.beg(), i2, nb);
+    relocate_data_wrap_src_and_dst<Item_alloc, nbcells>(beg(), i1, target.beg(), i2, nb);
     check(fr, bk);
     target.check(target.fr, target.bk);
   }
@@ -1447,7 +1604,7 @@ public:
   void transfer_from_front_to_back(ringbuffer_ptrx& target, int nb) {
     int i1 = array_index_of_front(fr);
     int i2 = target.array_index_of_pointer(target.bk);
-    copy_data_wrap_src_and_dst<Item_alloc, nbcells>(beg(), i1, target.beg(), i2, nb);
+    relocate_data_wrap_src_and_dst<Item_alloc, nbcells>(beg(), i1, target.beg(), i2, nb);
     fr = deallocn_front(fr, nb);
     target.bk = target.allocn_back(target.bk, nb);
     check(fr, bk);
@@ -1554,6 +1711,345 @@ public:
   
 };
 
+/*---------------------------------------------------------------------*/
+/* Ring buffer whose capacity is chosen at construction time */
+
+/*!
+ *  \class ringbuffer_pow2
+ *  \brief Ring buffer with a capacity that is a power of two, chosen
+ *  when the buffer is constructed
+ *
+ * Container properties
+ * ============
+ *
+ * The capacity is `Capacity::get()`, rounded up to a power of two and
+ * bounded by `2` and `Max_capacity`. It is fixed for the lifetime of
+ * the array of the buffer: a copy gets the capacity of the original
+ * and `swap` exchanges the arrays together with their capacities.
+ * Indices wrap around by masking, so that no modulo is needed.
+ *
+ * \tparam Item Type of the items
+ * \tparam Max_capacity Upper bound on the capacity, which is also
+ * the value of the static member `capacity`
+ * \tparam Capacity Class that provides `static int get()`, the
+ * capacity requested for new buffers
+ * \tparam Item_alloc Type of the allocator object used to define the
+ * storage allocation model.
+ */
+template <class Item, int Max_capacity, class Capacity,
+class Item_alloc = std::allocator<Item> >
+class ringbuffer_pow2 {
+public:
+
+  typedef int size_type;
+  typedef Item value_type;
+  typedef Item_alloc allocator_type;
+  typedef segment<value_type*> segment_type;
+
+  static constexpr int capacity = Max_capacity;
+
+  static int round_capacity(int cap) {
+    int c = 2;
+    while (c < cap && c < Max_capacity)
+      c *= 2;
+    return std::min(c, Max_capacity);
+  }
+
+private:
+
+  value_type* array;
+  int cap;
+  int mask;
+  int fr;
+  int sz;
+  Item_alloc alloc;
+
+  void init(int c) {
+    cap = c;
+    mask = c - 1;
+    fr = 0;
+    sz = 0;
+    array = (value_type*)malloc(sizeof(value_type) * cap);
+    assert(array != NULL);
+  }
+
+  /* calls `body(p, nb, k)` on the (at most two) contiguous ranges of
+   * cells that hold the items at logical positions [i, i + nb); `k`
+   * is the offset of the range relative to `i`.
+   */
+  template <class Body>
+  void for_each_range(int i, int nb, const Body& body) const {
+    if (nb <= 0)
+      return;
+    int j = (fr + i) & mask;
+    int na = std::min(nb, cap - j);
+    body(&array[j], na, 0);
+    if (na < nb)
+      body(&array[0], nb - na, na);
+  }
+
+public:
+
+  ringbuffer_pow2() {
+    assert((Max_capacity & (Max_capacity - 1)) == 0);
+    init(round_capacity(Capacity::get()));
+  }
+
+  ringbuffer_pow2(const ringbuffer_pow2& other) {
+    init(other.cap);
+    value_type* dst = array;
+    other.for_each_range(0, other.sz, [&] (value_type* p, int nb, int k) {
+      construct_items<Item_alloc>::blit(dst + k, p, nb);
+    });
+    sz = other.sz;
+  }
+
+  ringbuffer_pow2(size_type nb, const value_type& val) {
+    init(round_capacity(Capacity::get()));
+    pushn_back(const_foreach_body<Item_alloc>(val), nb);
+  }
+
+  ~ringbuffer_pow2() {
+    clear();
+    free(array);
+  }
+
+  inline int size() const {
+    return sz;
+  }
+
+  inline bool full() const {
+    return sz == cap;
+  }
+
+  inline int get_capacity() const {
+    return cap;
+  }
+
+  inline bool empty() const {
+    return sz == 0;
+  }
+
+  inline bool partial() const {
+    return !empty() && !full();
+  }
+
+  template <class... Args>
+  inline void emplace_front(Args&&... args) {
+    assert(! full());
+    fr = (fr - 1) & mask;
+    sz++;
+    alloc.construct(&array[fr], std::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  inline void emplace_back(Args&&... args) {
+    assert(! full());
+    alloc.construct(&array[(fr + sz) & mask], std::forward<Args>(args)...);
+    sz++;
+  }
+
+  inline void push_front(const value_type& x) {
+    emplace_front(x);
+  }
+
+  inline void push_front(value_type&& x) {
+    emplace_front(std::move(x));
+  }
+
+  inline void push_back(const value_type& x) {
+    emplace_back(x);
+  }
+
+  inline void push_back(value_type&& x) {
+    emplace_back(std::move(x));
+  }
+
+  inline value_type& front() const {
+    assert(! empty());
+    return array[fr];
+  }
+
+  inline value_type& back() const {
+    assert(! empty());
+    return array[(fr + sz - 1) & mask];
+  }
+
+  inline value_type pop_front() {
+    assert(! empty());
+    value_type v = std::move(front());
+    alloc.destroy(&(front()));
+    fr = (fr + 1) & mask;
+    sz--;
+    return v;
+  }
+
+  inline value_type pop_back() {
+    assert(! empty());
+    value_type v = std::move(back());
+    alloc.destroy(&(back()));
+    sz--;
+    return v;
+  }
+
+  void frontn(value_type* dst, int nb) const {
+    assert(size() >= nb);
+    for_each_range(0, nb, [&] (value_type* p, int n, int k) {
+      assign_items<Item_alloc>::blit(dst + k, p, n);
+    });
+  }
+
+  void backn(value_type* dst, int nb) const {
+    assert(size() >= nb);
+    for_each_range(sz - nb, nb, [&] (value_type* p, int n, int k) {
+      assign_items<Item_alloc>::blit(dst + k, p, n);
+    });
+  }
+
+  void pushn_front(const value_type* xs, int nb) {
+    assert(nb + size() <= cap);
+    fr = (fr - nb) & mask;
+    sz += nb;
+    for_each_range(0, nb, [&] (value_type* p, int n, int k) {
+      construct_items<Item_alloc>::blit(p, xs + k, n);
+    });
+  }
+
+  void pushn_back(const value_type* xs, int nb) {
+    assert(nb + size() <= cap);
+    sz += nb;
+    for_each_range(sz - nb, nb, [&] (value_type* p, int n, int k) {
+      construct_items<Item_alloc>::blit(p, xs + k, n);
+    });
+  }
+
+  template <class Body>
+  void pushn_back(const Body& body, int nb) {
+    assert(nb + size() <= cap);
+    sz += nb;
+    for_each_range(sz - nb, nb, [&] (value_type* p, int n, int k) {
+      papply<Body>(p, n, k, body);
+    });
+  }
+
+  void popn_front(int nb) {
+    assert(size() >= nb);
+    for_each_range(0, nb, [&] (value_type* p, int n, int) {
+      destroy_items<Item_alloc>(p, n);
+    });
+    fr = (fr + nb) & mask;
+    sz -= nb;
+  }
+
+  void popn_back(int nb) {
+    assert(size() >= nb);
+    for_each_range(sz - nb, nb, [&] (value_type* p, int n, int) {
+      destroy_items<Item_alloc>(p, n);
+    });
+    sz -= nb;
+  }
+
+  void popn_front(value_type* dst, int nb) {
+    frontn(dst, nb);
+    popn_front(nb);
+  }
+
+  void popn_back(value_type* dst, int nb) {
+    backn(dst, nb);
+    popn_back(nb);
+  }
+
+  void transfer_from_back_to_front(ringbuffer_pow2& target, int nb) {
+    assert(size() >= nb);
+    assert(nb + target.size() <= target.cap);
+    target.fr = (target.fr - nb) & target.mask;
+    target.sz += nb;
+    for_each_range(sz - nb, nb, [&] (value_type* p, int n, int k) {
+      target.for_each_range(k, n, [&] (value_type* q, int m, int l) {
+        relocate_items<Item_alloc>::blit(q, p + l, m);
+      });
+    });
+    sz -= nb;
+  }
+
+  void transfer_from_front_to_back(ringbuffer_pow2& target, int nb) {
+    assert(size() >= nb);
+    assert(nb + target.size() <= target.cap);
+    int i2 = target.sz;
+    target.sz += nb;
+    for_each_range(0, nb, [&] (value_type* p, int n, int k) {
+      target.for_each_range(i2 + k, n, [&] (value_type* q, int m, int l) {
+        relocate_items<Item_alloc>::blit(q, p + l, m);
+      });
+    });
+    fr = (fr + nb) & mask;
+    sz -= nb;
+  }
+
+  value_type& operator[](int ix) const {
+    assert(ix >= 0);
+    assert(ix < size());
+    return array[(fr + ix) & mask];
+  }
+
+  value_type& operator[](size_t ix) const {
+    return (*this)[int(ix)];
+  }
+
+  void clear() {
+    popn_back(size());
+  }
+
+  void swap(ringbuffer_pow2& other) {
+    std::swap(array, other.array);
+    std::swap(cap, other.cap);
+    std::swap(mask, other.mask);
+    std::swap(fr, other.fr);
+    std::swap(sz, other.sz);
+  }
+
+  segment_type segment_by_index(int ix) const {
+    assert(ix >= 0);
+    assert(ix < size());
+    segment_type seg;
+    int j = (fr + ix) & mask;
+    seg.middle = &array[j];
+    if (fr + sz <= cap) {
+      seg.begin = &array[fr];
+      seg.end = &array[fr + sz];
+    } else if (j >= fr) {
+      seg.begin = &array[fr];
+      seg.end = &array[cap];
+    } else {
+      seg.begin = &array[0];
+      seg.end = &array[(fr + sz) & mask];
+    }
+    return seg;
+  }
+
+  int index_of_pointer(const value_type* p) const {
+    assert(p >= &array[0]);
+    assert(p < &array[cap]);
+    return (int(p - &array[0]) - fr) & mask;
+  }
+
+  template <class Body>
+  void for_each(const Body& body) const {
+    for_each_range(0, sz, [&] (value_type* p, int n, int) {
+      for (int i = 0; i < n; i++)
+        body(p[i]);
+    });
+  }
+
+  template <class Body>
+  void for_each_segment(int lo, int hi, const Body& body) const {
+    for_each_range(lo, hi - lo, [&] (value_type* p, int n, int) {
+      body(p, p + n);
+    });
+  }
+
+};
+
 /*---------------------------------------------------------------------*/
 /* Stack */
 
@@ -1630,6 +2126,10 @@ public:
     return size() == capacity;
   }
   
+  inline int get_capacity() const {
+    return capacity;
+  }
+  
   inline bool empty() const {
     return size() == 0;
   }
@@ -1638,17 +2138,35 @@ public:
     return !empty() && !full(); // TODO: could be optimized
   }
   
-  inline void push_front(const value_type& x) {
+  template <class... Args>
+  inline void emplace_front(Args&&... args) {
     assert(! full());
     pshiftn<Item_alloc>(&array[0], size(), +1);
-    alloc.construct(&array[0], x);
+    alloc.construct(&array[0], std::forward<Args>(args)...);
     bk++;
   }
   
-  inline void push_back(const value_type& x) {
+  template <class... Args>
+  inline void emplace_back(Args&&... args) {
     assert(! full());
     bk++;
-    alloc.construct(&array[bk], x);
+    alloc.construct(&array[bk], std::forward<Args>(args)...);
+  }
+  
+  inline void push_front(const value_type& x) {
+    emplace_front(x);
+  }
+  
+  inline void push_front(value_type&& x) {
+    emplace_front(std::move(x));
+  }
+  
+  inline void push_back(const value_type& x) {
+    emplace_back(x);
+  }
+  
+  inline void push_back(value_type&& x) {
+    emplace_back(std::move(x));
   }
   
   inline value_type& front() const {
@@ -1663,7 +2181,7 @@ public:
   
   inline value_type pop_front() {
     assert(! empty());
-    value_type v = front();
+    value_type v = std::move(front());
     alloc.destroy(&(front()));
     pshiftn<Item_alloc>(&array.operator[](1), size() - 1, -1);
     bk--;
@@ -1672,7 +2190,7 @@ public:
   
   inline value_type pop_back() {
     assert(! empty());
-    value_type v = back();
+    value_type v = std::move(back());
     alloc.destroy(&(back()));
     bk--;
     return v;
@@ -1691,13 +2209,13 @@ public:
   void pushn_front(const value_type* xs, size_type nb) {
     assert(nb + size() <= capacity);
     pshiftn<Item_alloc>(&array[0], size(), +nb);
-    copy<Item_alloc>(&array[0], xs, nb);
+    construct_items<Item_alloc>::blit(&array[0], xs, nb);
     bk += nb;
   }
   
   void pushn_back(const value_type* xs, size_type nb) {
     assert(nb + size() <= capacity);
-    copy<Item_alloc>(&array.operator[](size()), xs, nb);
+    construct_items<Item_alloc>::blit(&array.operator[](size()), xs, nb);
     bk += nb;
   }
   
@@ -1735,14 +2253,17 @@ public:
     assert(nb <= size());
     assert(target.size() + nb <= capacity);
     pshiftn<Item_alloc>(&target.array[0], target.size(), +nb);
-    popn_back(&target.array[0], nb);
+    relocate_items<Item_alloc>::blit(&target.array[0], &array.operator[](size() - nb), nb);
+    bk -= nb;
     target.bk += nb;
   }
   
   void transfer_from_front_to_back(stack& target, size_type nb) {
     assert(nb <= size());
     assert(target.size() + nb <= capacity);
-    popn_front(&target.array.operator[](target.size()), nb);
+    relocate_items<Item_alloc>::blit(&target.array.operator[](target.size()), &array[0], nb);
+    pshiftn<Item_alloc>(&array.operator[](nb), size() - nb, -nb);
+    bk -= nb;
     target.bk += nb;
   }
   
@@ -0,0 +1,390 @@
+/*!
+ * \author Umut A. Acar
+ * \author Arthur Chargueraud
+ * \author Mike Rainey
+ * \date 2013-2018
+ * \copyright 2014 Umut A. Acar, Arthur Chargueraud, Mike Rainey
+ *
+ * \brief Allocation of chunk buffers in huge pages, with NUMA placement
+ * \file hugepagealloc.hpp
+ *
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#ifndef _PASL_DATA_HUGEPAGEALLOC_H_
+#define _PASL_DATA_HUGEPAGEALLOC_H_
+
+namespace pasl {
+namespace data {
+namespace hugepage {
+
+/***********************************************************************/
+
+/*---------------------------------------------------------------------*/
+/* Settings and statistics
+ *
+ * Buffers are carved out of regions of `region_szb` bytes that are
+ * aligned on their size, so that each region can be backed by a
+ * single huge page. The page mode selects how the regions are mapped:
+ *
+ *   - `pages_default`: plain anonymous mappings (base pages, unless
+ *     the kernel applies transparent huge pages to all mappings);
+ *   - `pages_transparent`: anonymous mappings advised with
+ *     `MADV_HUGEPAGE`, which suffices when transparent huge pages are
+ *     in `madvise` mode;
+ *   - `pages_explicit`: mappings from the pool of huge pages reserved
+ *     by the administrator (`MAP_HUGETLB`); when the pool is empty,
+ *     the region falls back to the transparent mode.
+ *
+ * The placement selects the NUMA nodes that hold the regions: the
+ * node of the thread that first touches each page (the default of the
+ * kernel), a given node, or all the online nodes in turn. Placement
+ * is a hint: on a system that does not support it, the region is
+ * mapped anyway and the failure is counted in the statistics.
+ *
+ * As with the chunk capacities, the settings are global to the
+ * process and are meant to be set at startup; they apply to the
+ * regions mapped from then on.
+ */
+
+static constexpr size_t region_szb = size_t(2) << 20;
+static constexpr size_t block_align_szb = 64;
+
+enum page_mode_type { pages_default, pages_transparent, pages_explicit };
+
+enum placement_type { placement_first_touch, placement_node, placement_interleave };
+
+class stats_type {
+public:
+  uint64_t nb_regions = 0;             //! regions mapped
+  uint64_t nb_explicit_regions = 0;    //! regions mapped from the pool of reserved huge pages
+  uint64_t nb_explicit_fallbacks = 0;  //! regions for which that pool was empty
+  uint64_t nb_placement_failures = 0;  //! regions whose placement was refused
+  uint64_t nb_bytes = 0;               //! bytes mapped
+};
+
+template <class Dummy=void>
+class settings {
+public:
+  static page_mode_type page_mode;
+  static placement_type placement;
+  static int node;                     // target of `placement_node`
+  static unsigned long interleave_mask; // nodes of `placement_interleave`; 0 for all online nodes
+  static stats_type stats;
+  static std::mutex mutex;             // protects the statistics
+};
+
+template <class Dummy>
+page_mode_type settings<Dummy>::page_mode = pages_transparent;
+
+template <class Dummy>
+placement_type settings<Dummy>::placement = placement_first_touch;
+
+template <class Dummy>
+int settings<Dummy>::node = 0;
+
+template <class Dummy>
+unsigned long settings<Dummy>::interleave_mask = 0;
+
+template <class Dummy>
+stats_type settings<Dummy>::stats;
+
+template <class Dummy>
+std::mutex settings<Dummy>::mutex;
+
+static inline void set_page_mode(page_mode_type mode) {
+  settings<>::page_mode = mode;
+}
+
+static inline void set_first_touch() {
+  settings<>::placement = placement_first_touch;
+}
+
+static inline void set_node(int node) {
+  assert(node >= 0 && node < int(8 * sizeof(unsigned long)));
+  settings<>::placement = placement_node;
+  settings<>::node = node;
+}
+
+//! Interleaves over the nodes of `mask`, or over all online nodes if `mask` is 0
+static inline void set_interleave(unsigned long mask = 0) {
+  settings<>::placement = placement_interleave;
+  settings<>::interleave_mask = mask;
+}
+
+static inline stats_type get_stats() {
+  std::lock_guard<std::mutex> guard(settings<>::mutex);
+  return settings<>::stats;
+}
+
+/*---------------------------------------------------------------------*/
+/* Regions */
+
+#ifdef __linux__
+// values of <linux/mempolicy.h>, which not all systems provide
+static constexpr int mpol_bind = 2;
+static constexpr int mpol_interleave = 3;
+
+//! Mask of the online nodes, as listed by sysfs (e.g., "0-3,5")
+static inline unsigned long online_nodes() {
+  unsigned long mask = 1;
+  FILE* f = fopen("/sys/devices/system/node/online", "r");
+  if (f == NULL)
+    return mask;
+  int lo, hi;
+  char sep;
+  if (fscanf(f, "%d", &lo) == 1) {
+    mask = 0;
+    while (true) {
+      hi = lo;
+      int r = fscanf(f, "%c", &sep);
+      if (r == 1 && sep == '-' && fscanf(f, "%d", &hi) == 1)
+        r = fscanf(f, "%c", &sep);
+      for (int k = lo; k <= hi && k < int(8 * sizeof(unsigned long)); k++)
+        mask |= 1UL << k;
+      if (r != 1 || sep != ',' || fscanf(f, "%d", &lo) != 1)
+        break;
+    }
+  }
+  fclose(f);
+  return (mask == 0) ? 1 : mask;
+}
+
+static inline bool place(void* p, size_t szb) {
+  int mode;
+  unsigned long mask;
+  switch (settings<>::placement) {
+    case placement_node:
+      mode = mpol_bind;
+      mask = 1UL << settings<>::node;
+      break;
+    case placement_interleave:
+      mode = mpol_interleave;
+      mask = (settings<>::interleave_mask == 0) ? online_nodes() : settings<>::interleave_mask;
+      break;
+    default:
+      return true;
+  }
+  unsigned long maxnode = 8 * sizeof(unsigned long) + 1;
+  return syscall(SYS_mbind, p, szb, mode, &mask, maxnode, 0) == 0;
+}
+#else
+static inline bool place(void*, size_t) {
+  return settings<>::placement == placement_first_touch;
+}
+#endif
+
+//! Maps `szb` bytes aligned on `region_szb`, where `szb` is a multiple of `region_szb`
+static inline void* map_region(size_t szb) {
+  assert(szb % region_szb == 0);
+  stats_type s;
+  void* p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  if (settings<>::page_mode == pages_explicit) {
+    p = mmap(NULL, szb, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p == MAP_FAILED)
+      s.nb_explicit_fallbacks++;
+    else
+      s.nb_explicit_regions++;
+  }
+#endif
+  if (p == MAP_FAILED) {
+    // over-allocate, then trim, to align the region
+    size_t len = szb + region_szb;
+    char* q = (char*)mmap(NULL, len, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (q == MAP_FAILED)
+      return nullptr;
+    char* r = (char*)(((uintptr_t)q + region_szb - 1) & ~(uintptr_t)(region_szb - 1));
+    if (r > q)
+      munmap(q, r - q);
+    if (r + szb < q + len)
+      munmap(r + szb, (q + len) - (r + szb));
+    p = r;
+#ifdef MADV_HUGEPAGE
+    if (settings<>::page_mode != pages_default)
+      madvise(p, szb, MADV_HUGEPAGE);
+#endif
+  }
+  if (! place(p, szb))
+    s.nb_placement_failures++;
+  std::lock_guard<std::mutex> guard(settings<>::mutex);
+  settings<>::stats.nb_regions++;
+  settings<>::stats.nb_explicit_regions += s.nb_explicit_regions;
+  settings<>::stats.nb_explicit_fallbacks += s.nb_explicit_fallbacks;
+  settings<>::stats.nb_placement_failures += s.nb_placement_failures;
+  settings<>::stats.nb_bytes += szb;
+  return p;
+}
+
+static inline void unmap_region(void* p, size_t szb) {
+  munmap(p, szb);
+  std::lock_guard<std::mutex> guard(settings<>::mutex);
+  settings<>::stats.nb_bytes -= szb;
+}
+
+/*---------------------------------------------------------------------*/
+/*!
+ * \class arena
+ * \brief Allocator of blocks of `Block_szb` bytes carved out of
+ * huge-page regions
+ *
+ * Freed blocks go to a free list, from which later allocations are
+ * served first; regions are never returned to the system. Blocks that
+ * do not fit in a region get a mapping of their own, which is
+ * returned on free. The arena is shared by all threads; its lock is
+ * taken once per block, that is, once per chunk that misses the chunk
+ * pool.
+ */
+template <size_t Block_szb>
+class arena {
+private:
+
+  static constexpr bool is_large = Block_szb > region_szb;
+  static constexpr size_t large_szb = (Block_szb + region_szb - 1) / region_szb * region_szb;
+
+  class free_block {
+  public:
+    free_block* next;
+  };
+
+  static std::mutex mutex;
+  static free_block* free_list;
+  static char* cur;
+  static char* end;
+
+public:
+
+  static_assert(Block_szb % block_align_szb == 0, "misaligned block size");
+
+  static void* alloc() {
+    if (is_large)
+      return map_region(large_szb);
+    std::lock_guard<std::mutex> guard(mutex);
+    if (free_list != nullptr) {
+      free_block* b = free_list;
+      free_list = b->next;
+      return b;
+    }
+    if (cur == nullptr || cur + Block_szb > end) {
+      cur = (char*)map_region(region_szb);
+      if (cur == nullptr) {
+        end = nullptr;
+        return nullptr;
+      }
+      end = cur + region_szb;
+    }
+    void* p = cur;
+    cur += Block_szb;
+    return p;
+  }
+
+  static void free(void* p) {
+    if (p == nullptr)
+      return;
+    if (is_large) {
+      unmap_region(p, large_szb);
+      return;
+    }
+    std::lock_guard<std::mutex> guard(mutex);
+    free_block* b = (free_block*)p;
+    b->next = free_list;
+    free_list = b;
+  }
+
+};
+
+template <size_t Block_szb>
+std::mutex arena<Block_szb>::mutex;
+
+template <size_t Block_szb>
+typename arena<Block_szb>::free_block* arena<Block_szb>::free_list = nullptr;
+
+template <size_t Block_szb>
+char* arena<Block_szb>::cur = nullptr;
+
+template <size_t Block_szb>
+char* arena<Block_szb>::end = nullptr;
+
+/*---------------------------------------------------------------------*/
+/*!
+ * \class block_allocator
+ * \brief Array allocator for fixed-capacity buffers (see
+ * `fixedcapacity::base::heap_allocator`) whose arrays come from
+ * an arena
+ *
+ * Arrays are rounded up to a multiple of the cache line and aligned
+ * on it.
+ */
+template <class Item, int Capacity>
+class block_allocator {
+private:
+
+  static constexpr size_t block_szb =
+    (sizeof(Item) * Capacity + block_align_szb - 1) / block_align_szb * block_align_szb;
+
+  using arena_type = arena<block_szb>;
+
+  class Deleter {
+  public:
+    void operator()(Item* items) {
+      arena_type::free(items);
+    }
+  };
+
+  std::unique_ptr<Item[], Deleter> items;
+
+  // to disable copying
+  block_allocator(const block_allocator& other);
+  block_allocator& operator=(const block_allocator& other);
+
+public:
+
+  using value_type = Item;
+  using self_type = block_allocator<Item, Capacity>;
+
+  static constexpr int capacity = Capacity;
+
+  block_allocator() {
+    Item* p = (value_type*)arena_type::alloc();
+    assert(p != NULL);
+    items.reset(p);
+  }
+
+  // move assignment operator
+  block_allocator(self_type&& x) = default;
+  self_type& operator=(self_type&& a) = default;
+
+  value_type& operator[](int i) const {
+    assert(items != NULL);
+    assert(i >= 0);
+    return items[i];
+  }
+
+  void swap(block_allocator& other) {
+    std::swap(items, other.items);
+  }
+
+};
+
+/***********************************************************************/
+
+} // end namespace
+} // end namespace
+} // end namespace
+
+#endif /*! _PASL_DATA_HUGEPAGEALLOC_H_ */
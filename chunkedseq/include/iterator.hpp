@@ -11,9 +11,11 @@
  */
 
 #include <assert.h>
+#include <algorithm>
 #include <iterator>
 
 #include "itemsearch.hpp"
+#include "prefetch.hpp"
 
 #ifndef _PASL_DATA_ITERATOR_H_
 #define _PASL_DATA_ITERATOR_H_
@@ -232,23 +234,28 @@ private:
     if (found) {
       prefix = chunk_search_by(p, prefix);
     } else {
-      // make the iterator logically point one past the end of the sequence
       assert(size_access::csize(prefix) == seq->size());
-      cur = seq->get_chunk_containing_last_item();
-      size_type sz_cur = cur->size();
-      measured_type m = prefix;
-      size_access::size(m) = seq->size() - sz_cur;
-      cur->annotation.prefix.set_cached(m);
-      if (sz_cur == 0)
-        seg.begin = seg.end = nullptr;
-      else
-        seg = cur->segment_by_index(sz_cur - 1);
-      seg.middle = seg.end;
+      move_past_end(prefix);
     }
     check();
     return prefix;
   }
   
+  // make the iterator logically point one past the end of the sequence;
+  // this position is reached without a search, from the last chunk
+  void move_past_end(measured_type prefix) {
+    cur = seq->get_chunk_containing_last_item();
+    size_type sz_cur = cur->size();
+    measured_type m = prefix;
+    size_access::size(m) = seq->size() - sz_cur;
+    cur->annotation.prefix.set_cached(m);
+    if (sz_cur == 0)
+      seg.begin = seg.end = nullptr;
+    else
+      seg = cur->segment_by_index(sz_cur - 1);
+    seg.middle = seg.end;
+  }
+  
   template <class Pred>
   measured_type chunkedseq_search_by(const Pred& p) {
     return chunkedseq_search_by(p, algebra_type::identity());
@@ -260,14 +267,40 @@ private:
     return it;
   }
   
+  // Prefetches the chunk that is `prefetch::get_distance()` chunks
+  // ahead of the current one, as estimated from the size of the
+  // current chunk, when the iterator has stepped sequentially into
+  // the current chunk (see prefetch.hpp).
+  void prefetch_ahead(size_type sz) {
+    size_type d = prefetch::get_distance();
+    size_type ssz = seq->size();
+    if (d == 0 || sz + cur->size() > ssz)
+      return;
+    size_type target = std::min(sz + d * cur->size(), ssz);
+    using predicate_type = itemsearch::less_than_by_position<measured_type, size_type, size_access>;
+    predicate_type p(target - 1);
+    const_chunk_pointer c = nullptr;
+    bool found;
+    seq->search_for_chunk(p, algebra_type::identity(), found, c);
+    if (found && c != cur) {
+      prefetch::read(c);
+      prefetch::items_of(c);
+    }
+  }
+  
   self_type& increment_by(size_type n) {
     check();
     size_type orig_sz = size();
     pointer m = seg.middle + n;
-    if (m >= seg.end)
+    if (m >= seg.end) {
+      bool sequential = (m == seg.end);
+      const_chunk_pointer prev = cur;
       search_by_one_based_index(orig_sz + n);
-    else
+      if (sequential && cur != prev)
+        prefetch_ahead(orig_sz + n);
+    } else {
       seg.middle = m;
+    }
     assert(size() == orig_sz + n);
     check();
     return *this;
@@ -323,18 +356,17 @@ public:
   
   random_access(const_chunkedseq_pointer seq, const measure_type& meas, position_type pos)
   : seq(seq), cur(nullptr), meas_fct(meas) {
-    search_by_one_based_index(1);
     switch (pos) {
       case begin: {
         search_by_one_based_index(1);
         break;
       }
       case end: {
-        search_by_one_based_index(seq->size() + 1);
+        move_past_end(algebra_type::identity());
+        check();
         break;
       }
     }
-
   }
   
   random_access() : seq(nullptr), cur(nullptr) { }
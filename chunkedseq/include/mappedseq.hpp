@@ -0,0 +1,392 @@
+/*!
+ * \author Umut A. Acar
+ * \author Arthur Chargueraud
+ * \author Mike Rainey
+ * \date 2013-2018
+ * \copyright 2014 Umut A. Acar, Arthur Chargueraud, Mike Rainey
+ *
+ * \brief On-disk format for chunked sequences of plain-old-data items
+ * \file mappedseq.hpp
+ *
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "cachedmeasure.hpp"
+
+#ifndef _PASL_DATA_MAPPEDSEQ_H_
+#define _PASL_DATA_MAPPEDSEQ_H_
+
+namespace pasl {
+namespace data {
+namespace chunkedseq {
+namespace mapped {
+
+/***********************************************************************/
+
+/*---------------------------------------------------------------------*/
+/* File format
+ *
+ * A file consists of a header, followed by the payloads of the chunks,
+ * followed by the index. The payload of a chunk is the contiguous
+ * array of its items, starting at an offset that is a multiple of
+ * `payload_alignment`. The index stores, for each chunk, a descriptor
+ * and then, in a separate array, the cached measure of the chunk.
+ *
+ * All the numbers are stored in the byte order of the machine that
+ * wrote the file.
+ */
+
+static constexpr uint64_t magic = 0x3151534b43534150ull; // "PASCKSQ1"
+static constexpr uint64_t format_version = 1;
+static constexpr uint64_t payload_alignment = 64;
+
+class header_type {
+public:
+  uint64_t magic;
+  uint64_t version;
+  uint64_t item_szb;
+  uint64_t measured_szb;
+  uint64_t nb_items;
+  uint64_t nb_chunks;
+  uint64_t index_offset;
+  uint64_t reserved;
+};
+
+class chunk_descr_type {
+public:
+  uint64_t first_item;  // index in the sequence of the first item of the chunk
+  uint64_t nb_items;
+  uint64_t payload_offset;
+};
+
+static inline uint64_t align_up(uint64_t n, uint64_t a) {
+  return (n + a - 1) / a * a;
+}
+
+/*---------------------------------------------------------------------*/
+/*!
+ * \brief Writes the items of a container to a file
+ *
+ * The chunks of the file follow the segments of the container, with
+ * consecutive segments merged into a chunk as long as the result
+ * holds at most `chunk_capacity` items. Items are written directly
+ * from the segments, without intermediate copies.
+ *
+ * Returns `false` if the file could not be written; `errno` is then
+ * set by the failing call.
+ *
+ * \pre The items are trivially copyable and hold no pointer.
+ */
+template <class Sequence>
+bool write(const Sequence& seq, const std::string& path,
+           size_t chunk_capacity = 512) {
+  using value_type = typename Sequence::value_type;
+  using measured_type = typename Sequence::measured_type;
+  using algebra_type = typename Sequence::algebra_type;
+  using measure_type = typename Sequence::measure_type;
+  static_assert(std::is_trivially_copyable<value_type>::value,
+                "on-disk sequences require trivially copyable items");
+  static_assert(std::is_trivially_copyable<measured_type>::value,
+                "on-disk sequences require trivially copyable measures");
+  assert(chunk_capacity > 0);
+  FILE* f = fopen(path.c_str(), "wb");
+  if (f == NULL)
+    return false;
+  bool ok = true;
+  uint64_t pos = 0;
+  auto put = [&] (const void* p, uint64_t szb) {
+    if (ok && szb > 0 && fwrite(p, 1, szb, f) != szb)
+      ok = false;
+    pos += szb;
+  };
+  auto pad_to = [&] (uint64_t alignment) {
+    static const char zeros[payload_alignment] = { 0 };
+    uint64_t target = align_up(pos, alignment);
+    while (pos < target)
+      put(zeros, std::min(target - pos, payload_alignment));
+  };
+  header_type h;
+  memset(&h, 0, sizeof(h));
+  put(&h, sizeof(h));
+  measure_type meas = seq.get_measure();
+  std::vector<chunk_descr_type> descrs;
+  std::vector<measured_type> measures;
+  uint64_t nb_items = 0;
+  seq.for_each_segment([&] (const value_type* lo, const value_type* hi) {
+    while (lo < hi) {
+      bool fresh = descrs.empty() || descrs.back().nb_items == chunk_capacity;
+      if (fresh) {
+        pad_to(payload_alignment);
+        descrs.push_back({ nb_items, 0, pos });
+        measures.push_back(algebra_type::identity());
+      }
+      chunk_descr_type& d = descrs.back();
+      uint64_t nb = std::min(uint64_t(hi - lo), uint64_t(chunk_capacity - d.nb_items));
+      put(lo, nb * sizeof(value_type));
+      measures.back() = algebra_type::combine(measures.back(), meas(lo, lo + nb));
+      d.nb_items += nb;
+      nb_items += nb;
+      lo += nb;
+    }
+  });
+  pad_to(payload_alignment);
+  h.magic = magic;
+  h.version = format_version;
+  h.item_szb = sizeof(value_type);
+  h.measured_szb = sizeof(measured_type);
+  h.nb_items = nb_items;
+  h.nb_chunks = descrs.size();
+  h.index_offset = pos;
+  put(descrs.data(), descrs.size() * sizeof(chunk_descr_type));
+  put(measures.data(), measures.size() * sizeof(measured_type));
+  if (ok && fseek(f, 0, SEEK_SET) != 0)
+    ok = false;
+  if (ok && fwrite(&h, 1, sizeof(h), f) != sizeof(h))
+    ok = false;
+  if (fclose(f) != 0)
+    ok = false;
+  return ok;
+}
+
+/*---------------------------------------------------------------------*/
+/*!
+ * \class sequence
+ * \brief Read access to a sequence stored in a file, through a memory
+ * mapping of the file
+ * \tparam Item type of the items
+ * \tparam Cache cached measure that was used to write the file
+ *
+ * Opening a file maps it into memory and checks its header, but reads
+ * neither the payloads nor the index: the pages of the file are
+ * faulted in by the operations that touch them. The items are used in
+ * place, as the segments of the chunks of the file.
+ *
+ * In mode `copy_on_write`, the items may be modified through
+ * `for_each_segment_mutable`; the modified pages become private to
+ * the process and the file is left unchanged.
+ *
+ * #### Complexity ####
+ * - `open`: constant time, plus the cost of the `mmap` system call
+ * - `operator[]`: logarithmic in the number of chunks
+ * - `copy_to`: linear in the number of items, by bulk copies of
+ *   entire chunks
+ */
+template <class Item, class Cache = cachedmeasure::trivial<Item, size_t>>
+class sequence {
+public:
+
+  using self_type = sequence<Item, Cache>;
+  using value_type = Item;
+  using const_reference = const value_type&;
+  using size_type = size_t;
+  using cache_type = Cache;
+  using measured_type = typename cache_type::measured_type;
+  using algebra_type = typename cache_type::algebra_type;
+
+  typedef enum {
+    read_only,
+    copy_on_write
+  } mode_type;
+
+  static_assert(std::is_trivially_copyable<value_type>::value,
+                "on-disk sequences require trivially copyable items");
+
+private:
+
+  char* base = nullptr;
+  size_t file_szb = 0;
+  const header_type* header = nullptr;
+  const chunk_descr_type* descrs = nullptr;
+  const measured_type* measures = nullptr;
+
+  value_type* payload(size_type k) const {
+    return (value_type*)(base + descrs[k].payload_offset);
+  }
+
+  bool validate() const {
+    if (file_szb < sizeof(header_type))
+      return false;
+    const header_type& h = *header;
+    if (h.magic != magic || h.version != format_version)
+      return false;
+    if (h.item_szb != sizeof(value_type) || h.measured_szb != sizeof(measured_type))
+      return false;
+    uint64_t index_szb = h.nb_chunks * (sizeof(chunk_descr_type) + sizeof(measured_type));
+    if (h.index_offset > file_szb || index_szb > file_szb - h.index_offset)
+      return false;
+    return true;
+  }
+
+public:
+
+  sequence() { }
+
+  sequence(const self_type&) = delete;
+  self_type& operator=(const self_type&) = delete;
+
+  ~sequence() {
+    close();
+  }
+
+  /*!
+   * \brief Maps the file at `path`
+   *
+   * Returns `false` if the file cannot be mapped or was not written
+   * by `write` for the same item and measure types.
+   */
+  bool open(const std::string& path, mode_type mode = read_only) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      ::close(fd);
+      return false;
+    }
+    file_szb = (size_t)st.st_size;
+    int prot = (mode == read_only) ? PROT_READ : (PROT_READ | PROT_WRITE);
+    int flags = (mode == read_only) ? MAP_SHARED : MAP_PRIVATE;
+    void* p = mmap(NULL, file_szb, prot, flags, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+      file_szb = 0;
+      return false;
+    }
+    base = (char*)p;
+    header = (const header_type*)base;
+    if (! validate()) {
+      close();
+      return false;
+    }
+    descrs = (const chunk_descr_type*)(base + header->index_offset);
+    measures = (const measured_type*)(descrs + header->nb_chunks);
+    return true;
+  }
+
+  void close() {
+    if (base != nullptr)
+      munmap(base, file_szb);
+    base = nullptr;
+    file_szb = 0;
+    header = nullptr;
+    descrs = nullptr;
+    measures = nullptr;
+  }
+
+  bool is_open() const {
+    return base != nullptr;
+  }
+
+  size_type size() const {
+    return is_open() ? size_type(header->nb_items) : 0;
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  size_type nb_chunks() const {
+    return is_open() ? size_type(header->nb_chunks) : 0;
+  }
+
+  //! Number of items of the `k`-th chunk
+  size_type chunk_size(size_type k) const {
+    assert(k < nb_chunks());
+    return descrs[k].nb_items;
+  }
+
+  //! Cached measure of the `k`-th chunk
+  measured_type chunk_cached(size_type k) const {
+    assert(k < nb_chunks());
+    return measures[k];
+  }
+
+  measured_type get_cached() const {
+    measured_type m = algebra_type::identity();
+    for (size_type k = 0; k < nb_chunks(); k++)
+      m = algebra_type::combine(m, measures[k]);
+    return m;
+  }
+
+  const_reference operator[](size_type i) const {
+    assert(i < size());
+    const chunk_descr_type* lo = descrs;
+    const chunk_descr_type* hi = descrs + nb_chunks();
+    const chunk_descr_type* d = std::upper_bound(lo, hi, uint64_t(i),
+      [] (uint64_t i, const chunk_descr_type& d) {
+        return i < d.first_item;
+      }) - 1;
+    return payload(d - lo)[i - d->first_item];
+  }
+
+  const_reference front() const {
+    return operator[](0);
+  }
+
+  const_reference back() const {
+    return operator[](size() - 1);
+  }
+
+  // `body(lo, hi)` is called on the items of each chunk, in order
+  template <class Body>
+  void for_each_segment(const Body& body) const {
+    for (size_type k = 0; k < nb_chunks(); k++) {
+      const value_type* lo = payload(k);
+      body(lo, lo + descrs[k].nb_items);
+    }
+  }
+
+  //! Requires the mode `copy_on_write`
+  template <class Body>
+  void for_each_segment_mutable(const Body& body) {
+    for (size_type k = 0; k < nb_chunks(); k++) {
+      value_type* lo = payload(k);
+      body(lo, lo + descrs[k].nb_items);
+    }
+  }
+
+  template <class Body>
+  void for_each(const Body& body) const {
+    for_each_segment([&] (const value_type* lo, const value_type* hi) {
+      for (const value_type* p = lo; p < hi; p++)
+        body(*p);
+    });
+  }
+
+  //! Appends all the items to `dst`, one chunk at a time
+  template <class Sequence>
+  void copy_to(Sequence& dst) const {
+    for_each_segment([&] (const value_type* lo, const value_type* hi) {
+      dst.pushn_back(lo, size_type(hi - lo));
+    });
+  }
+
+  //! Advises the kernel that the whole file is about to be read
+  void will_need() const {
+    if (is_open())
+      madvise(base, file_szb, MADV_WILLNEED);
+  }
+
+};
+
+/***********************************************************************/
+
+} // end namespace
+} // end namespace
+} // end namespace
+} // end namespace
+
+#endif /*! _PASL_DATA_MAPPEDSEQ_H_ */
@@ -0,0 +1,535 @@
+/*!
+ * \author Umut A. Acar
+ * \author Arthur Chargueraud
+ * \author Mike Rainey
+ * \date 2013-2018
+ * \copyright 2014 Umut A. Acar, Arthur Chargueraud, Mike Rainey
+ *
+ * \brief Ordered sets and maps with bulk operations
+ * \file orderedmap.hpp
+ *
+ */
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "chunkedseq.hpp"
+
+#ifndef _PASL_DATA_ORDEREDMAP_H_
+#define _PASL_DATA_ORDEREDMAP_H_
+
+namespace pasl {
+namespace data {
+namespace chunkedseq {
+namespace ordered {
+
+/***********************************************************************/
+
+/*---------------------------------------------------------------------*/
+/* Cached measure: key of the last item
+ *
+ * Items are stored sorted by key, so the key of the last item of a
+ * subsequence is its largest key. A search for the first prefix
+ * whose last key is not less than a given key thus finds the
+ * position of that key in logarithmic time.
+ */
+
+template <class Key>
+class last_key {
+public:
+
+  Key key;
+  bool empty;
+
+  last_key()
+  : key(), empty(true) { }
+
+  last_key(const Key& key)
+  : key(key), empty(false) { }
+
+};
+
+template <class Key>
+class take_right_if_nonempty {
+public:
+
+  using value_type = last_key<Key>;
+
+  static constexpr bool has_inverse = false;
+
+  static value_type identity() {
+    return value_type();
+  }
+
+  static value_type combine(value_type left, value_type right) {
+    return right.empty ? left : right;
+  }
+
+  static value_type inverse(value_type x) {
+    assert(false);
+    return identity();
+  }
+
+};
+
+template <class Item, class Key_of>
+class get_key_of_last_item {
+public:
+
+  using value_type = Item;
+  using key_type = typename Key_of::key_type;
+  using measured_type = last_key<key_type>;
+
+  measured_type operator()(const value_type& v) const {
+    return measured_type(Key_of::key(v));
+  }
+
+  measured_type operator()(const value_type* lo, const value_type* hi) const {
+    if (hi == lo)
+      return measured_type();
+    return measured_type(Key_of::key(*(hi - 1)));
+  }
+
+};
+
+template <class Item, class Size, class Key_of>
+class key_cache {
+public:
+
+  using size_type = Size;
+  using value_type = Item;
+  using algebra_type = take_right_if_nonempty<typename Key_of::key_type>;
+  using measured_type = typename algebra_type::value_type;
+  using measure_type = get_key_of_last_item<value_type, Key_of>;
+
+  static void swap(measured_type& x, measured_type& y) {
+    std::swap(x, y);
+  }
+
+};
+
+/*---------------------------------------------------------------------*/
+/* Policies */
+
+template <class Key>
+class identity_key {
+public:
+  using key_type = Key;
+  static const key_type& key(const Key& x) {
+    return x;
+  }
+};
+
+template <class Key, class Item>
+class first_key {
+public:
+  using key_type = Key;
+  static const key_type& key(const std::pair<Key, Item>& x) {
+    return x.first;
+  }
+};
+
+/*---------------------------------------------------------------------*/
+/*!
+ * \class orderedbase
+ * \brief Sorted chunked sequence of items with unique keys
+ * \tparam Item type of the items
+ * \tparam Key_of policy giving access to the key of an item
+ * \tparam Compare strict weak order on keys
+ * \tparam Chunk_capacity capacity of the chunks
+ * \tparam Fork2 policy that runs the two branches of a bulk operation,
+ * possibly in parallel
+ *
+ * Point operations (`find`, `insert`, `erase`) locate a key by a
+ * search on the cached key of the last item of each chunk and of
+ * each subtree, and take logarithmic time, plus the cost of shifting
+ * items within one chunk.
+ *
+ * Bulk operations (`union_with`, `intersection_with`,
+ * `difference_with`) proceed by divide and conquer: the item in the
+ * middle of the larger input is taken as a pivot, both inputs are
+ * split by the key of the pivot, the two pairs of halves are
+ * processed by the two branches of `Fork2::fork2`, and the results
+ * are joined by `concat`. Below `cutoff` items, inputs are combined
+ * by the sequential algorithms of the STL.
+ */
+template <
+  class Item,
+  class Key_of,
+  class Compare,
+  int Chunk_capacity,
+  class Fork2
+>
+class orderedbase {
+public:
+
+  using self_type = orderedbase<Item, Key_of, Compare, Chunk_capacity, Fork2>;
+  using key_type = typename Key_of::key_type;
+  using value_type = Item;
+  using key_compare = Compare;
+  using size_type = size_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using pointer = value_type*;
+  using const_pointer = const value_type*;
+
+protected:
+
+  using cache_type = key_cache<value_type, size_type, Key_of>;
+  using container_type = bootstrapped::deque<value_type, Chunk_capacity, cache_type>;
+  using measured_type = typename cache_type::measured_type;
+
+public:
+
+  using iterator = typename container_type::iterator;
+  using const_iterator = iterator;
+
+  static constexpr int default_cutoff = 2048;
+
+protected:
+
+  // invariant: keys of items in seq are strictly increasing
+  mutable container_type seq;
+
+  static bool less(const key_type& x, const key_type& y) {
+    return key_compare()(x, y);
+  }
+
+  static bool equiv(const key_type& x, const key_type& y) {
+    return ! less(x, y) && ! less(y, x);
+  }
+
+  static bool less_items(const value_type& x, const value_type& y) {
+    return less(Key_of::key(x), Key_of::key(y));
+  }
+
+  // moves to `other` the items of `c` whose keys are not less than `k`
+  static void split_by_key(container_type& c, const key_type& k, container_type& other) {
+    if (c.empty() || less(Key_of::key(c.back()), k))
+      return;
+    c.split([&] (const measured_type& m) {
+      return ! m.empty && ! less(m.key, k);
+    }, other);
+  }
+
+  typedef enum {
+    op_union,
+    op_intersection,
+    op_difference
+  } bulk_op_type;
+
+  static void bulk_seq(container_type& src1, container_type& src2, container_type& dst,
+                       bulk_op_type op) {
+    size_type n1 = src1.size();
+    size_type n2 = src2.size();
+    std::vector<value_type> buf1(n1);
+    std::vector<value_type> buf2(n2);
+    std::vector<value_type> res;
+    res.reserve(op == op_union ? n1 + n2 : n1);
+    src1.popn_back(buf1.data(), n1);
+    src2.popn_back(buf2.data(), n2);
+    auto out = std::back_inserter(res);
+    if (op == op_union)
+      std::set_union(buf1.begin(), buf1.end(), buf2.begin(), buf2.end(), out, less_items);
+    else if (op == op_intersection)
+      std::set_intersection(buf1.begin(), buf1.end(), buf2.begin(), buf2.end(), out, less_items);
+    else
+      std::set_difference(buf1.begin(), buf1.end(), buf2.begin(), buf2.end(), out, less_items);
+    dst.pushn_back(res.data(), res.size());
+  }
+
+  static void bulk_rec(container_type& src1, container_type& src2, container_type& dst,
+                       bulk_op_type op, int cutoff) {
+    size_type n1 = src1.size();
+    size_type n2 = src2.size();
+    if (n1 == 0 || n2 == 0) {
+      if (op == op_union || (op == op_difference && n1 > 0))
+        dst.concat(n1 == 0 ? src2 : src1);
+      src1.clear();
+      src2.clear();
+      return;
+    }
+    // below two items, the pivot would leave one side empty
+    if (n1 + n2 <= std::max(size_type(cutoff), size_type(2))) {
+      bulk_seq(src1, src2, dst, op);
+      return;
+    }
+    container_type src1_hi;
+    container_type src2_hi;
+    if (n1 >= n2) {
+      size_type m = n1 / 2;
+      key_type pivot = Key_of::key(src1[m]);
+      src1.split(m, src1_hi);
+      split_by_key(src2, pivot, src2_hi);
+    } else {
+      size_type m = n2 / 2;
+      key_type pivot = Key_of::key(src2[m]);
+      src2.split(m, src2_hi);
+      split_by_key(src1, pivot, src1_hi);
+    }
+    container_type dst_hi;
+    Fork2::fork2([&] { bulk_rec(src1, src2, dst, op, cutoff); },
+                 [&] { bulk_rec(src1_hi, src2_hi, dst_hi, op, cutoff); });
+    dst.concat(dst_hi);
+  }
+
+  void bulk(self_type& other, bulk_op_type op, int cutoff) {
+    container_type res;
+    bulk_rec(seq, other.seq, res, op, cutoff);
+    seq.swap(res);
+  }
+
+  void check_sorted() const {
+#ifndef NDEBUG
+    size_type i = 0;
+    value_type prev;
+    seq.for_each([&] (const value_type& v) {
+      assert(i++ == 0 || less_items(prev, v));
+      prev = v;
+    });
+#endif
+  }
+
+public:
+
+  orderedbase() { }
+
+  orderedbase(const self_type& other)
+  : seq(other.seq) { }
+
+  size_type size() const {
+    return seq.size();
+  }
+
+  bool empty() const {
+    return seq.empty();
+  }
+
+  void clear() {
+    seq.clear();
+  }
+
+  void swap(self_type& other) {
+    seq.swap(other.seq);
+  }
+
+  iterator begin() const {
+    return seq.begin();
+  }
+
+  iterator end() const {
+    return seq.end();
+  }
+
+  //! Returns an iterator on the first item whose key is not less than `k`
+  iterator lower_bound(const key_type& k) const {
+    iterator it = seq.begin();
+    it.search_by([&] (const measured_type& m) {
+      return ! m.empty && ! less(m.key, k);
+    });
+    return it;
+  }
+
+  iterator find(const key_type& k) const {
+    iterator it = lower_bound(k);
+    if (it == seq.end() || ! equiv(Key_of::key(*it), k))
+      return seq.end();
+    return it;
+  }
+
+  size_type count(const key_type& k) const {
+    return (find(k) == seq.end()) ? 0 : 1;
+  }
+
+  /*!
+   * \brief Inserts an item, unless an item with the same key is
+   * already present
+   *
+   * \return `true` if the item was inserted
+   */
+  bool insert(const value_type& v) {
+    iterator it = lower_bound(Key_of::key(v));
+    if (it == seq.end()) {
+      seq.push_back(v);
+      return true;
+    }
+    if (equiv(Key_of::key(*it), Key_of::key(v)))
+      return false;
+    seq.insert(it, v);
+    return true;
+  }
+
+  void erase(iterator it) {
+    if (it == seq.end())
+      return;
+    seq.erase(it, it + 1);
+  }
+
+  size_type erase(const key_type& k) {
+    iterator it = find(k);
+    if (it == seq.end())
+      return 0;
+    erase(it);
+    return 1;
+  }
+
+  /*!
+   * \brief Replaces the contents by the items of `[lo, hi)`
+   *
+   * \pre The keys of the items are strictly increasing.
+   */
+  void assign_sorted(const_pointer lo, const_pointer hi) {
+    seq.clear();
+    seq.pushn_back(lo, size_type(hi - lo));
+    check_sorted();
+  }
+
+  /*!
+   * \brief Inserts a batch of items
+   *
+   * The batch is sorted, and then merged by `union_with`. Among
+   * items with the same key, the one already present in the
+   * container, or else the first one of the batch, is kept.
+   */
+  void multi_insert(const_pointer lo, const_pointer hi, int cutoff = default_cutoff) {
+    std::vector<value_type> batch(lo, hi);
+    std::stable_sort(batch.begin(), batch.end(), less_items);
+    auto last = std::unique(batch.begin(), batch.end(), [] (const value_type& x, const value_type& y) {
+      return ! less_items(x, y);
+    });
+    self_type other;
+    other.assign_sorted(batch.data(), batch.data() + (last - batch.begin()));
+    union_with(other, cutoff);
+  }
+
+  /*!
+   * \brief Replaces the contents by their union with the items of
+   * `other`, which is left empty
+   *
+   * For keys present in both containers, the item of this container
+   * is kept.
+   */
+  void union_with(self_type& other, int cutoff = default_cutoff) {
+    bulk(other, op_union, cutoff);
+  }
+
+  //! Keeps only the items whose keys are present in `other`, which is left empty
+  void intersection_with(self_type& other, int cutoff = default_cutoff) {
+    bulk(other, op_intersection, cutoff);
+  }
+
+  //! Removes the items whose keys are present in `other`, which is left empty
+  void difference_with(self_type& other, int cutoff = default_cutoff) {
+    bulk(other, op_difference, cutoff);
+  }
+
+  /*!
+   * \brief Visits the items whose keys lie in `[lo, hi)`
+   *
+   * `body(first, last)` is called on consecutive segments of items,
+   * in order, without copying them.
+   */
+  template <class Body>
+  void for_each_segment_in_range(const key_type& lo, const key_type& hi, const Body& body) const {
+    if (! less(lo, hi))
+      return;
+    iterator beg = lower_bound(lo);
+    iterator end = lower_bound(hi);
+    if (beg.size() < end.size())
+      seq.for_each_segment(beg, end, body);
+  }
+
+  //! Number of items whose keys lie in `[lo, hi)`
+  size_type count_range(const key_type& lo, const key_type& hi) const {
+    if (! less(lo, hi))
+      return 0;
+    return lower_bound(hi).size() - lower_bound(lo).size();
+  }
+
+  template <class Body>
+  void for_each(const Body& body) const {
+    seq.for_each(body);
+  }
+
+  template <class Body>
+  void for_each_segment(const Body& body) const {
+    seq.for_each_segment(body);
+  }
+
+  void check() const {
+    seq.check();
+    check_sorted();
+  }
+
+};
+
+/*---------------------------------------------------------------------*/
+/*!
+ * \class set
+ * \brief Ordered set of keys
+ */
+template <
+  class Key,
+  class Compare = std::less<Key>,
+  int Chunk_capacity = 128,
+  class Fork2 = sequential_fork2
+>
+class set : public orderedbase<Key, identity_key<Key>, Compare, Chunk_capacity, Fork2> {
+public:
+
+  using self_type = set<Key, Compare, Chunk_capacity, Fork2>;
+
+};
+
+/*---------------------------------------------------------------------*/
+/*!
+ * \class map
+ * \brief Ordered map from keys to values
+ */
+template <
+  class Key,
+  class Item,
+  class Compare = std::less<Key>,
+  int Chunk_capacity = 128,
+  class Fork2 = sequential_fork2
+>
+class map : public orderedbase<std::pair<Key, Item>, first_key<Key, Item>, Compare, Chunk_capacity, Fork2> {
+private:
+
+  using base_type = orderedbase<std::pair<Key, Item>, first_key<Key, Item>, Compare, Chunk_capacity, Fork2>;
+
+public:
+
+  using self_type = map<Key, Item, Compare, Chunk_capacity, Fork2>;
+  using key_type = Key;
+  using mapped_type = Item;
+  using value_type = typename base_type::value_type;
+  using iterator = typename base_type::iterator;
+
+  /*!
+   * \brief Returns the value associated with `k`, inserting a
+   * default-constructed value first if there is none
+   */
+  mapped_type& operator[](const key_type& k) {
+    iterator it = base_type::lower_bound(k);
+    if (it == base_type::seq.end()) {
+      base_type::seq.push_back(value_type(k, mapped_type()));
+      it = base_type::seq.end() - 1;
+    } else if (! base_type::equiv((*it).first, k)) {
+      it = base_type::seq.insert(it, value_type(k, mapped_type()));
+    }
+    return (*it).second;
+  }
+
+};
+
+/***********************************************************************/
+
+} // end namespace
+} // end namespace
+} // end namespace
+} // end namespace
+
+#endif /*! _PASL_DATA_ORDEREDMAP_H_ */
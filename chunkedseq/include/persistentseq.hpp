@@ -0,0 +1,926 @@
+/*!
+ * \author Umut A. Acar
+ * \author Arthur Chargueraud
+ * \author Mike Rainey
+ * \date 2013-2018
+ * \copyright 2014 Umut A. Acar, Arthur Chargueraud, Mike Rainey
+ *
+ * \brief Persistent chunked sequence
+ * \file persistentseq.hpp
+ *
+ */
+
+#include <assert.h>
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <utility>
+
+#include "fixedcapacity.hpp"
+#include "chunk.hpp"
+#include "cachedmeasure.hpp"
+
+#ifndef _PASL_DATA_PERSISTENTSEQ_H_
+#define _PASL_DATA_PERSISTENTSEQ_H_
+
+namespace pasl {
+namespace data {
+namespace chunkedseq {
+namespace persistent {
+
+/***********************************************************************/
+
+/*!
+ * \class deque
+ * \brief Chunked sequence whose versions share their chunks
+ * \tparam Item type of the items
+ * \tparam Chunk_capacity maximal number of items in a chunk
+ * \tparam Cache cached measure of the items (see `cachedmeasure.hpp`)
+ * \tparam Chunk_struct fixed-capacity buffer used to store the items
+ * \tparam Item_alloc allocator of the items
+ *
+ * The items are stored in chunks, and the chunks in the leaves of an
+ * AVL tree whose nodes cache the size and the measure of their
+ * subtree. As in `chunkedseqbase`, a front and a back chunk are kept
+ * out of the tree so that the operations on the ends are cheap.
+ *
+ * Chunks and tree nodes are reference counted. Copying a container
+ * takes constant time and produces a snapshot: the two versions then
+ * share all of their nodes, and each subsequent operation on one
+ * version copies only the nodes that it modifies and that are still
+ * shared (path copying). A node that is owned by a single version is
+ * modified in place. It follows that operations on a version never
+ * affect the items of the other versions.
+ *
+ * Versions may be read and destroyed concurrently by different
+ * threads; a given version may be modified by only one thread at a
+ * time.
+ *
+ * #### Complexity ####
+ * - copy: constant time
+ * - `push_front`, `push_back`, `pop_front`, `pop_back`: amortized
+ *   constant time, plus a copy of at most one chunk after a snapshot,
+ *   plus logarithmic time each time a chunk enters or leaves the tree
+ * - `concat`, `split`, `operator[]`: logarithmic time
+ */
+template <
+  class Item,
+  int Chunk_capacity = 512,
+  class Cache = cachedmeasure::trivial<Item, size_t>,
+  template <
+    class Chunk_item,
+    int Capacity,
+    class Chunk_item_alloc = std::allocator<Item>
+  >
+  class Chunk_struct = fixedcapacity::heap_allocated::ringbuffer_ptrx,
+  class Item_alloc = std::allocator<Item>
+>
+class deque {
+public:
+
+  using self_type = deque<Item, Chunk_capacity, Cache, Chunk_struct, Item_alloc>;
+  using value_type = Item;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using cache_type = Cache;
+  using size_type = typename cache_type::size_type;
+  using difference_type = ptrdiff_t;
+  using measured_type = typename cache_type::measured_type;
+  using algebra_type = typename cache_type::algebra_type;
+  using measure_type = typename cache_type::measure_type;
+
+  static constexpr size_type chunk_capacity = size_type(Chunk_capacity);
+
+private:
+
+  using queue_type = Chunk_struct<value_type, Chunk_capacity, Item_alloc>;
+  using chunk_type = chunk<queue_type, cache_type>;
+
+  /*---------------------------------------------------------------------*/
+  /* Tree nodes */
+
+  // height is 0 for leaves; size and cached summarize the subtree
+  class node {
+  public:
+    std::atomic<int> refcount;
+    int height;
+    size_type size;
+    measured_type cached;
+
+    node(int height)
+    : refcount(1), height(height), size(0), cached(algebra_type::identity()) { }
+  };
+
+  class leaf : public node {
+  public:
+    chunk_type items;
+
+    leaf()
+    : node(0) { }
+
+    leaf(const leaf& other)
+    : node(0), items(other.items) {
+      node::size = other.size;
+      node::cached = other.cached;
+    }
+  };
+
+  class branch : public node {
+  public:
+    node* left;
+    node* right;
+
+    branch(node* left, node* right)
+    : node(1 + std::max(left->height, right->height)), left(left), right(right) {
+      node::size = left->size + right->size;
+      node::cached = algebra_type::combine(left->cached, right->cached);
+    }
+  };
+
+  using node_pointer = node*;
+  using leaf_pointer = leaf*;
+  using branch_pointer = branch*;
+
+  /*---------------------------------------------------------------------*/
+  /* Reference counting
+   *
+   * Unless stated otherwise, the functions below consume the
+   * references that they receive and return fresh references.
+   */
+
+  static node_pointer share(node_pointer n) {
+    if (n != nullptr)
+      n->refcount.fetch_add(1, std::memory_order_relaxed);
+    return n;
+  }
+
+  static leaf_pointer share(leaf_pointer l) {
+    return (leaf_pointer)share((node_pointer)l);
+  }
+
+  static void release(node_pointer n) {
+    if (n == nullptr)
+      return;
+    if (n->refcount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+      return;
+    if (n->height == 0) {
+      delete (leaf_pointer)n;
+    } else {
+      branch_pointer b = (branch_pointer)n;
+      release(b->left);
+      release(b->right);
+      delete b;
+    }
+  }
+
+  static bool unique(const node* n) {
+    return n->refcount.load(std::memory_order_acquire) == 1;
+  }
+
+  static int height_of(const node* n) {
+    return (n == nullptr) ? -1 : n->height;
+  }
+
+  static size_type size_of(const node* n) {
+    return (n == nullptr) ? size_type(0) : n->size;
+  }
+
+  static measured_type cached_of(const node* n) {
+    return (n == nullptr) ? algebra_type::identity() : n->cached;
+  }
+
+  // returns a leaf that the caller may modify in place
+  static leaf_pointer own(leaf_pointer l) {
+    if (l == nullptr)
+      return new leaf();
+    if (unique(l))
+      return l;
+    leaf_pointer c = new leaf(*l);
+    release(l);
+    return c;
+  }
+
+  static void refresh(leaf_pointer l) {
+    l->size = l->items.size();
+    l->cached = l->items.get_cached();
+  }
+
+  // drops the leaf if it holds no item
+  static leaf_pointer nonempty_or_null(leaf_pointer l) {
+    if (l != nullptr && l->size == 0) {
+      release(l);
+      return nullptr;
+    }
+    return l;
+  }
+
+  // gives the children of `n`, copying the branch only if it is shared
+  static void unpack(node_pointer n, node_pointer& left, node_pointer& right) {
+    assert(n->height > 0);
+    branch_pointer b = (branch_pointer)n;
+    if (unique(b)) {
+      left = b->left;
+      right = b->right;
+      delete b;
+    } else {
+      left = share(b->left);
+      right = share(b->right);
+      release(b);
+    }
+  }
+
+  /*---------------------------------------------------------------------*/
+  /* AVL tree */
+
+  // requires that the heights of `l` and `r` differ by at most two
+  static node_pointer join_balanced(node_pointer l, node_pointer r) {
+    int hl = height_of(l);
+    int hr = height_of(r);
+    if (hl > hr + 1) {
+      node_pointer ll, lr;
+      unpack(l, ll, lr);
+      if (height_of(ll) >= height_of(lr))
+        return new branch(ll, new branch(lr, r));
+      node_pointer lrl, lrr;
+      unpack(lr, lrl, lrr);
+      return new branch(new branch(ll, lrl), new branch(lrr, r));
+    }
+    if (hr > hl + 1) {
+      node_pointer rl, rr;
+      unpack(r, rl, rr);
+      if (height_of(rr) >= height_of(rl))
+        return new branch(new branch(l, rl), rr);
+      node_pointer rll, rlr;
+      unpack(rl, rll, rlr);
+      return new branch(new branch(l, rll), new branch(rlr, rr));
+    }
+    return new branch(l, r);
+  }
+
+  // time proportional to the difference of the heights
+  static node_pointer concat(node_pointer l, node_pointer r) {
+    if (l == nullptr)
+      return r;
+    if (r == nullptr)
+      return l;
+    int hl = l->height;
+    int hr = r->height;
+    if (hl > hr + 1) {
+      node_pointer ll, lr;
+      unpack(l, ll, lr);
+      return join_balanced(ll, concat(lr, r));
+    }
+    if (hr > hl + 1) {
+      node_pointer rl, rr;
+      unpack(r, rl, rr);
+      return join_balanced(concat(l, rl), rr);
+    }
+    return new branch(l, r);
+  }
+
+  // `a` receives the first `i` items of `l`, and `b` the other ones
+  void split_leaf(leaf_pointer l, size_type i, leaf_pointer& a, leaf_pointer& b) const {
+    size_type sz = size_of(l);
+    assert(i <= sz);
+    if (i == 0) {
+      a = nullptr;
+      b = l;
+    } else if (i == sz) {
+      a = l;
+      b = nullptr;
+    } else {
+      a = own(l);
+      b = new leaf();
+      a->items.transfer_from_back_to_front(meas, b->items, sz - i);
+      refresh(a);
+      refresh(b);
+    }
+  }
+
+  // `a` receives the first `i` items of `n`, and `b` the other ones
+  void split_tree(node_pointer n, size_type i, node_pointer& a, node_pointer& b) const {
+    if (n == nullptr) {
+      a = nullptr;
+      b = nullptr;
+    } else if (n->height == 0) {
+      leaf_pointer la, lb;
+      split_leaf((leaf_pointer)n, i, la, lb);
+      a = la;
+      b = lb;
+    } else if (i == 0) {
+      a = nullptr;
+      b = n;
+    } else if (i == n->size) {
+      a = n;
+      b = nullptr;
+    } else {
+      node_pointer l, r;
+      unpack(n, l, r);
+      size_type nl = l->size;
+      if (i <= nl) {
+        node_pointer la, lb;
+        split_tree(l, i, la, lb);
+        a = la;
+        b = concat(lb, r);
+      } else {
+        node_pointer ra, rb;
+        split_tree(r, i - nl, ra, rb);
+        a = concat(l, ra);
+        b = rb;
+      }
+    }
+  }
+
+  static const leaf* first_leaf(const node* n) {
+    while (n->height > 0)
+      n = ((const branch*)n)->left;
+    return (const leaf*)n;
+  }
+
+  static const leaf* last_leaf(const node* n) {
+    while (n->height > 0)
+      n = ((const branch*)n)->right;
+    return (const leaf*)n;
+  }
+
+  // removes the first leaf of `n` and stores it in `l`
+  void pop_first_leaf(node_pointer& n, leaf_pointer& l) const {
+    node_pointer a, b;
+    split_tree(n, first_leaf(n)->size, a, b);
+    l = (leaf_pointer)a;
+    n = b;
+  }
+
+  // removes the last leaf of `n` and stores it in `l`
+  void pop_last_leaf(node_pointer& n, leaf_pointer& l) const {
+    node_pointer a, b;
+    split_tree(n, n->size - last_leaf(n)->size, a, b);
+    n = a;
+    l = (leaf_pointer)b;
+  }
+
+  // does not consume `n`
+  template <class Body>
+  static void for_each_leaf(const node* n, const Body& body) {
+    if (n == nullptr)
+      return;
+    if (n->height == 0) {
+      body((const leaf*)n);
+    } else {
+      const branch* b = (const branch*)n;
+      for_each_leaf(b->left, body);
+      for_each_leaf(b->right, body);
+    }
+  }
+
+  /*---------------------------------------------------------------------*/
+  /* Representation
+   *
+   * The items are those of `front`, then those of `middle`, then those
+   * of `back`. Each of the three pointers may be null. The leaves of
+   * `middle` are never empty.
+   */
+
+  leaf_pointer front_chunk;
+  node_pointer middle;
+  leaf_pointer back_chunk;
+  measure_type meas;
+
+  size_type front_size() const {
+    return size_of(front_chunk);
+  }
+
+  size_type back_size() const {
+    return size_of(back_chunk);
+  }
+
+  // moves the back chunk into the middle tree, fusing it with the last
+  // leaf of the tree if the two fit in a single chunk
+  void push_back_chunk_into_middle() {
+    leaf_pointer c = nonempty_or_null(back_chunk);
+    back_chunk = nullptr;
+    if (c == nullptr)
+      return;
+    if (middle != nullptr && last_leaf(middle)->size + c->size <= chunk_capacity) {
+      leaf_pointer l;
+      pop_last_leaf(middle, l);
+      c = own(c);
+      l = own(l);
+      c->items.transfer_from_front_to_back(meas, l->items, c->size);
+      refresh(l);
+      release(c);
+      c = l;
+    }
+    middle = concat(middle, c);
+  }
+
+  // symmetric to push_back_chunk_into_middle
+  void push_front_chunk_into_middle() {
+    leaf_pointer c = nonempty_or_null(front_chunk);
+    front_chunk = nullptr;
+    if (c == nullptr)
+      return;
+    if (middle != nullptr && first_leaf(middle)->size + c->size <= chunk_capacity) {
+      leaf_pointer l;
+      pop_first_leaf(middle, l);
+      c = own(c);
+      l = own(l);
+      c->items.transfer_from_back_to_front(meas, l->items, c->size);
+      refresh(l);
+      release(c);
+      c = l;
+    }
+    middle = concat(c, middle);
+  }
+
+  // ensures that the back chunk holds at least one item, if possible
+  void refill_back() {
+    if (back_size() > 0)
+      return;
+    release(back_chunk);
+    back_chunk = nullptr;
+    if (middle != nullptr) {
+      pop_last_leaf(middle, back_chunk);
+    } else {
+      back_chunk = front_chunk;
+      front_chunk = nullptr;
+    }
+  }
+
+  // symmetric to refill_back
+  void refill_front() {
+    if (front_size() > 0)
+      return;
+    release(front_chunk);
+    front_chunk = nullptr;
+    if (middle != nullptr) {
+      pop_first_leaf(middle, front_chunk);
+    } else {
+      front_chunk = back_chunk;
+      back_chunk = nullptr;
+    }
+  }
+
+  void release_all() {
+    release(front_chunk);
+    release(middle);
+    release(back_chunk);
+    front_chunk = nullptr;
+    middle = nullptr;
+    back_chunk = nullptr;
+  }
+
+  // index, within the container, of the first item `x` such that
+  // `p(m)` holds, where `m` is the combined measure of all the items
+  // up to and including `x`; `size()` if there is no such item
+  template <class Pred>
+  size_type search_by(const Pred& p) const {
+    measured_type prefix = algebra_type::identity();
+    size_type pos = 0;
+    auto search_leaf = [&] (const leaf* l) {
+      size_type sz = size_of(l);
+      for (size_type i = 0; i < sz; i++) {
+        prefix = algebra_type::combine(prefix, meas(l->items[i]));
+        if (p(prefix))
+          return pos + i;
+      }
+      pos += sz;
+      return size();
+    };
+    auto search_tree = [&] (const node* n) {
+      if (n == nullptr || ! p(algebra_type::combine(prefix, n->cached))) {
+        prefix = algebra_type::combine(prefix, cached_of(n));
+        pos += size_of(n);
+        return size();
+      }
+      while (n->height > 0) {
+        const branch* b = (const branch*)n;
+        measured_type m = algebra_type::combine(prefix, b->left->cached);
+        if (p(m)) {
+          n = b->left;
+        } else {
+          prefix = m;
+          pos += b->left->size;
+          n = b->right;
+        }
+      }
+      return search_leaf((const leaf*)n);
+    };
+    size_type i = search_leaf(front_chunk);
+    if (i < size())
+      return i;
+    i = search_tree(middle);
+    if (i < size())
+      return i;
+    return search_leaf(back_chunk);
+  }
+
+public:
+
+  /*---------------------------------------------------------------------*/
+  /** @name Constructors and destructors
+   */
+  ///@{
+
+  deque()
+  : front_chunk(nullptr), middle(nullptr), back_chunk(nullptr) { }
+
+  deque(const measure_type& meas)
+  : front_chunk(nullptr), middle(nullptr), back_chunk(nullptr), meas(meas) { }
+
+  /*!
+   * \brief Snapshot constructor
+   *
+   * Constructs a new version that shares all of its chunks with
+   * `other`.
+   *
+   * #### Complexity ####
+   * Constant time.
+   */
+  deque(const self_type& other)
+  : front_chunk(share(other.front_chunk)),
+    middle(share(other.middle)),
+    back_chunk(share(other.back_chunk)),
+    meas(other.meas) { }
+
+  deque(self_type&& other)
+  : front_chunk(other.front_chunk),
+    middle(other.middle),
+    back_chunk(other.back_chunk),
+    meas(other.meas) {
+    other.front_chunk = nullptr;
+    other.middle = nullptr;
+    other.back_chunk = nullptr;
+  }
+
+  deque(std::initializer_list<value_type> l)
+  : front_chunk(nullptr), middle(nullptr), back_chunk(nullptr) {
+    for (auto it = l.begin(); it != l.end(); it++)
+      push_back(*it);
+  }
+
+  ~deque() {
+    release_all();
+  }
+
+  self_type& operator=(const self_type& other) {
+    if (&other != this) {
+      self_type tmp(other);
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  self_type& operator=(self_type&& other) {
+    if (&other != this) {
+      release_all();
+      swap(other);
+    }
+    return *this;
+  }
+
+  //! Returns a new version that shares all of its chunks with this one
+  self_type snapshot() const {
+    return self_type(*this);
+  }
+  ///@}
+
+  /*---------------------------------------------------------------------*/
+  /** @name Capacity
+   */
+  ///@{
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  size_type size() const {
+    return front_size() + size_of(middle) + back_size();
+  }
+
+  measured_type get_cached() const {
+    measured_type m = algebra_type::combine(cached_of(front_chunk), cached_of(middle));
+    return algebra_type::combine(m, cached_of(back_chunk));
+  }
+
+  measure_type get_measure() const {
+    return meas;
+  }
+  ///@}
+
+  /*---------------------------------------------------------------------*/
+  /** @name Item access
+   *
+   * Items are shared between versions, and thus only exposed as
+   * constant references.
+   */
+  ///@{
+
+  const_reference front() const {
+    assert(! empty());
+    if (front_size() > 0)
+      return front_chunk->items.front();
+    if (middle != nullptr)
+      return first_leaf(middle)->items.front();
+    return back_chunk->items.front();
+  }
+
+  const_reference back() const {
+    assert(! empty());
+    if (back_size() > 0)
+      return back_chunk->items.back();
+    if (middle != nullptr)
+      return last_leaf(middle)->items.back();
+    return front_chunk->items.back();
+  }
+
+  /*!
+   * \brief Access item
+   *
+   * #### Complexity ####
+   * Logarithmic time.
+   */
+  const_reference operator[](size_type i) const {
+    assert(i < size());
+    size_type nf = front_size();
+    if (i < nf)
+      return front_chunk->items[i];
+    i -= nf;
+    size_type nm = size_of(middle);
+    if (i >= nm)
+      return back_chunk->items[i - nm];
+    const node* n = middle;
+    while (n->height > 0) {
+      const branch* b = (const branch*)n;
+      if (i < b->left->size) {
+        n = b->left;
+      } else {
+        i -= b->left->size;
+        n = b->right;
+      }
+    }
+    return ((const leaf*)n)->items[i];
+  }
+  ///@}
+
+  /*---------------------------------------------------------------------*/
+  /** @name Modifiers
+   *
+   * Each of the modifiers below changes only this version.
+   */
+  ///@{
+
+  void push_front(const value_type& x) {
+    value_type y = x;
+    push_front(std::move(y));
+  }
+
+  void push_front(value_type&& x) {
+    front_chunk = own(front_chunk);
+    if (front_chunk->items.full()) {
+      middle = concat(front_chunk, middle);
+      front_chunk = new leaf();
+    }
+    front_chunk->items.push_front(meas, std::move(x));
+    refresh(front_chunk);
+  }
+
+  void push_back(const value_type& x) {
+    value_type y = x;
+    push_back(std::move(y));
+  }
+
+  void push_back(value_type&& x) {
+    back_chunk = own(back_chunk);
+    if (back_chunk->items.full()) {
+      middle = concat(middle, back_chunk);
+      back_chunk = new leaf();
+    }
+    back_chunk->items.push_back(meas, std::move(x));
+    refresh(back_chunk);
+  }
+
+  value_type pop_front() {
+    assert(! empty());
+    refill_front();
+    front_chunk = own(front_chunk);
+    value_type x = front_chunk->items.pop_front(meas);
+    refresh(front_chunk);
+    return x;
+  }
+
+  value_type pop_back() {
+    assert(! empty());
+    refill_back();
+    back_chunk = own(back_chunk);
+    value_type x = back_chunk->items.pop_back(meas);
+    refresh(back_chunk);
+    return x;
+  }
+
+  /*!
+   * \brief Merges with content of another container
+   *
+   * Removes all items from `other`, inserting them at the end of
+   * this container. The chunks of `other` that are shared with other
+   * versions are not copied.
+   *
+   * #### Complexity ####
+   * Logarithmic in the size of the largest of the two containers.
+   */
+  void concat(self_type& other) {
+    if (&other == this) {
+      self_type tmp(other);
+      concat(tmp);
+      return;
+    }
+    if (other.empty())
+      return;
+    if (empty()) {
+      swap(other);
+      return;
+    }
+    push_back_chunk_into_middle();
+    other.push_front_chunk_into_middle();
+    if (middle == nullptr) {
+      middle = nonempty_or_null(front_chunk);
+      front_chunk = nullptr;
+    }
+    node_pointer m = other.middle;
+    other.middle = nullptr;
+    if (middle != nullptr && m != nullptr
+        && last_leaf(middle)->size + first_leaf(m)->size <= chunk_capacity) {
+      leaf_pointer l1, l2;
+      pop_last_leaf(middle, l1);
+      pop_first_leaf(m, l2);
+      l1 = own(l1);
+      l2 = own(l2);
+      l2->items.transfer_from_front_to_back(meas, l1->items, l2->size);
+      refresh(l1);
+      release(l2);
+      middle = concat(middle, l1);
+    }
+    middle = concat(middle, m);
+    back_chunk = other.back_chunk;
+    other.back_chunk = nullptr;
+    assert(other.empty());
+  }
+
+  /*!
+   * \brief Split by index
+   *
+   * The container is erased after and including the item at
+   * (zero-based) index `i`. The erased items are moved to the
+   * `other` container.
+   *
+   * \pre The `other` container is empty.
+   * \pre `i <= size()`
+   *
+   * #### Complexity ####
+   * Logarithmic time.
+   */
+  void split(size_type i, self_type& other) {
+    assert(other.empty());
+    assert(i <= size());
+    other.release_all();
+    size_type nf = front_size();
+    size_type nm = size_of(middle);
+    if (i <= nf) {
+      leaf_pointer a, b;
+      split_leaf(front_chunk, i, a, b);
+      front_chunk = a;
+      other.front_chunk = b;
+      other.middle = middle;
+      other.back_chunk = back_chunk;
+      middle = nullptr;
+      back_chunk = nullptr;
+    } else if (i <= nf + nm) {
+      node_pointer a, b;
+      split_tree(middle, i - nf, a, b);
+      middle = a;
+      other.middle = b;
+      other.back_chunk = back_chunk;
+      back_chunk = nullptr;
+    } else {
+      leaf_pointer a, b;
+      split_leaf(back_chunk, i - nf - nm, a, b);
+      back_chunk = a;
+      other.back_chunk = b;
+    }
+  }
+
+  /*!
+   * \brief Split by predicate
+   *
+   * Moves to `other` the first item `x` such that `p(m)` holds, where
+   * `m` is the combined measure of all the items up to and including
+   * `x`, as well as all the items that follow `x`.
+   *
+   * \pre The `other` container is empty.
+   */
+  template <class Pred>
+  void split(const Pred& p, self_type& other) {
+    split(search_by(p), other);
+  }
+
+  void clear() {
+    release_all();
+  }
+
+  void swap(self_type& other) {
+    std::swap(front_chunk, other.front_chunk);
+    std::swap(middle, other.middle);
+    std::swap(back_chunk, other.back_chunk);
+  }
+  ///@}
+
+  /*---------------------------------------------------------------------*/
+  /** @name Iteration
+   */
+  ///@{
+
+  // `body(lo, hi)` is called on each right-open interval of items
+  template <class Body>
+  void for_each_segment(const Body& body) const {
+    auto f = [&] (const leaf* l) {
+      if (l != nullptr)
+        l->items.for_each_segment(body);
+    };
+    f(front_chunk);
+    for_each_leaf(middle, f);
+    f(back_chunk);
+  }
+
+  template <class Body>
+  void for_each(const Body& body) const {
+    for_each_segment([&] (const value_type* lo, const value_type* hi) {
+      for (const value_type* p = lo; p < hi; p++)
+        body(*p);
+    });
+  }
+  ///@}
+
+  /*---------------------------------------------------------------------*/
+  /** @name Debugging
+   */
+  ///@{
+
+  //! Number of tree nodes and chunks that this version shares with others
+  size_type nb_shared_nodes() const {
+    size_type nb = 0;
+    std::function<void(const node*, bool)> f = [&] (const node* n, bool shared) {
+      if (n == nullptr)
+        return;
+      shared = shared || ! unique(n);
+      if (shared)
+        nb++;
+      if (n->height > 0) {
+        f(((const branch*)n)->left, shared);
+        f(((const branch*)n)->right, shared);
+      }
+    };
+    f(front_chunk, false);
+    f(middle, false);
+    f(back_chunk, false);
+    return nb;
+  }
+
+  void check() const {
+#ifndef NDEBUG
+    std::function<void(const node*)> f = [&] (const node* n) {
+      assert(n->refcount.load() > 0);
+      if (n->height == 0) {
+        const leaf* l = (const leaf*)n;
+        assert(l->size == l->items.size());
+        assert(l->size > 0);
+        return;
+      }
+      const branch* b = (const branch*)n;
+      f(b->left);
+      f(b->right);
+      assert(n->height == 1 + std::max(b->left->height, b->right->height));
+      assert(std::abs(b->left->height - b->right->height) <= 1);
+      assert(n->size == b->left->size + b->right->size);
+    };
+    if (middle != nullptr)
+      f(middle);
+    size_type sz = 0;
+    for_each([&] (const value_type&) {
+      sz++;
+    });
+    assert(sz == size());
+#endif
+  }
+  ///@}
+
+};
+
+/***********************************************************************/
+
+} // end namespace
+} // end namespace
+} // end namespace
+} // end namespace
+
+#endif /*! _PASL_DATA_PERSISTENTSEQ_H_ */
@@ -0,0 +1,141 @@
+/*!
+ * \author Umut A. Acar
+ * \author Arthur Chargueraud
+ * \author Mike Rainey
+ * \date 2013-2018
+ * \copyright 2014 Umut A. Acar, Arthur Chargueraud, Mike Rainey
+ *
+ * \brief Software prefetching for sequential traversals of chunked sequences
+ * \file prefetch.hpp
+ *
+ */
+
+#include <assert.h>
+
+#ifndef _PASL_DATA_PREFETCH_H_
+#define _PASL_DATA_PREFETCH_H_
+
+namespace pasl {
+namespace data {
+namespace chunkedseq {
+namespace prefetch {
+
+/***********************************************************************/
+
+/*---------------------------------------------------------------------*/
+/* Settings
+ *
+ * The traversals of the whole container (`for_each` and
+ * `for_each_segment`) visit the chunks of the middle sequence in a
+ * window: when a chunk is handed to the consumer, the chunk that
+ * comes `distance` positions later is prefetched, as well as the
+ * first items of the chunk that comes next; the nodes of the middle
+ * sequence are fetched one child ahead. An iterator that steps
+ * sequentially into a new chunk looks up, and prefetches, the chunk
+ * that comes `distance` chunks later. A distance of 0 disables
+ * prefetching.
+ *
+ * The distance is global to the process and meant to be set at
+ * startup.
+ */
+
+static constexpr int max_distance = 32;
+static constexpr int default_distance = 4;
+
+//! Number of cache lines prefetched at the front of the next chunk
+static constexpr int nb_item_lines = 4;
+static constexpr int cache_line_szb = 64;
+
+template <class Dummy=void>
+class settings {
+public:
+  static int distance;
+};
+
+template <class Dummy>
+int settings<Dummy>::distance = default_distance;
+
+static inline int get_distance() {
+  return settings<>::distance;
+}
+
+static inline void set_distance(int distance) {
+  assert(distance >= 0);
+  settings<>::distance = (distance < max_distance) ? distance : max_distance;
+}
+
+template <class Type>
+static inline void read(const Type* p) {
+  __builtin_prefetch(p, 0, 3);
+}
+
+//! Prefetches the items at the front of a nonempty chunk
+template <class Chunk>
+static inline void items_of(const Chunk* c) {
+  if (c->empty())
+    return;
+  const char* p = (const char*)&c->front();
+  for (int i = 0; i < nb_item_lines; i++)
+    read(p + i * cache_line_szb);
+}
+
+/*---------------------------------------------------------------------*/
+/*!
+ * \class window
+ * \brief Ring of the chunk pointers that are produced, but not yet
+ * consumed, by a traversal
+ */
+template <class Chunk_pointer>
+class window {
+private:
+
+  Chunk_pointer ptrs[max_distance];
+  int distance;
+  int head = 0;
+  int nb = 0;
+
+public:
+
+  window(int distance)
+  : distance(distance) {
+    assert(distance > 0 && distance <= max_distance);
+  }
+
+  //! Adds `p` to the window; applies `f` to the chunk that leaves the window, if any
+  template <class Body>
+  void push(Chunk_pointer p, const Body& f) {
+    read(p);
+    if (nb < distance) {
+      ptrs[(head + nb) % distance] = p;
+      nb++;
+      return;
+    }
+    Chunk_pointer q = ptrs[head];
+    ptrs[head] = p;
+    head = (head + 1) % distance;
+    items_of(ptrs[head]);
+    f(q);
+  }
+
+  //! Applies `f` to the chunks left in the window
+  template <class Body>
+  void flush(const Body& f) {
+    for (; nb > 0; nb--) {
+      Chunk_pointer q = ptrs[head];
+      head = (head + 1) % distance;
+      if (nb > 1)
+        items_of(ptrs[head]);
+      f(q);
+    }
+  }
+
+};
+
+/***********************************************************************/
+
+} // end namespace
+} // end namespace
+} // end namespace
+} // end namespace
+
+#endif /*! _PASL_DATA_PREFETCH_H_ */
@@ -0,0 +1,365 @@
+/*!
+ * \author Umut A. Acar
+ * \author Arthur Chargueraud
+ * \author Mike Rainey
+ * \date 2013-2018
+ * \copyright 2014 Umut A. Acar, Arthur Chargueraud, Mike Rainey
+ *
+ * \brief Text buffer with byte and line indexing
+ * \file rope.hpp
+ *
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "chunkedseq.hpp"
+
+#ifndef _PASL_DATA_ROPE_H_
+#define _PASL_DATA_ROPE_H_
+
+namespace pasl {
+namespace data {
+namespace chunkedseq {
+
+/***********************************************************************/
+
+namespace text {
+
+/*---------------------------------------------------------------------*/
+/* Newline counting
+ *
+ * Bytes are processed eight at a time: after xor-ing a word with a
+ * word of newline characters, the bytes that were newlines are the
+ * zero bytes, which the standard bit trick below maps exactly (that
+ * is, without false positives due to borrows) to their high bits.
+ */
+
+static inline size_t count_newlines(const char* lo, const char* hi) {
+  const uint64_t ones_7f = 0x7f7f7f7f7f7f7f7full;
+  const uint64_t newlines = 0x0a0a0a0a0a0a0a0aull;
+  size_t nb = 0;
+  while (lo < hi && ((uintptr_t)lo & 7) != 0)
+    nb += (*lo++ == '\n');
+  for (; hi - lo >= 8; lo += 8) {
+    uint64_t x;
+    memcpy(&x, lo, 8);
+    x ^= newlines;
+    uint64_t y = ~(((x & ones_7f) + ones_7f) | x | ones_7f);
+    nb += __builtin_popcountll(y);
+  }
+  while (lo < hi)
+    nb += (*lo++ == '\n');
+  return nb;
+}
+
+template <class Measured>
+class newline_measure {
+public:
+
+  using value_type = char;
+  using measured_type = Measured;
+
+  measured_type operator()(const value_type& c) const {
+    return measured_type(c == '\n');
+  }
+
+  measured_type operator()(const value_type* lo, const value_type* hi) const {
+    return measured_type(count_newlines(lo, hi));
+  }
+
+};
+
+template <class Size>
+class newline_cache {
+public:
+
+  using size_type = Size;
+  using value_type = char;
+  using algebra_type = algebra::int_group_under_addition_and_negation<size_type>;
+  using measured_type = typename algebra_type::value_type;
+  using measure_type = newline_measure<measured_type>;
+
+  static void swap(measured_type& x, measured_type& y) {
+    std::swap(x, y);
+  }
+
+};
+
+} // end namespace
+
+/*---------------------------------------------------------------------*/
+/*!
+ * \class rope
+ * \brief Text buffer
+ * \tparam Chunk_capacity capacity of the chunks, in bytes
+ * \tparam Fork2 policy that runs the two branches of a bulk load,
+ * possibly in parallel
+ *
+ * The bytes of the text are the items of a chunked sequence whose
+ * cached measure is the number of newline characters. As the
+ * chunked sequence also caches the number of items, every subtree
+ * knows both its number of bytes and its number of lines, so that
+ * the text can be indexed by byte offset and by line number in
+ * logarithmic time.
+ *
+ * Lines are numbered from zero; line `i` starts after the `i`-th
+ * newline character.
+ *
+ * #### Complexity ####
+ * - `line_offset`, `split`, `concat`: logarithmic time
+ * - `line_of`: squared logarithmic time
+ * - `insert`, `erase`: logarithmic time, plus linear time in the
+ *   number of bytes inserted or erased
+ */
+template <int Chunk_capacity = 4096, class Fork2 = sequential_fork2>
+class rope {
+public:
+
+  using self_type = rope<Chunk_capacity, Fork2>;
+  using value_type = char;
+  using size_type = size_t;
+
+private:
+
+  using cache_type = text::newline_cache<size_type>;
+  using container_type = bootstrapped::deque<value_type, Chunk_capacity, cache_type>;
+  using iterator = typename container_type::iterator;
+
+  container_type seq;
+
+  static void load_rec(int fd, size_type lo, size_type hi, size_type block_szb,
+                       self_type& dst, bool& ok) {
+    if (hi - lo <= block_szb) {
+      std::vector<char> buf(hi - lo);
+      size_type nb = 0;
+      while (nb < hi - lo) {
+        ssize_t r = pread(fd, buf.data() + nb, hi - lo - nb, off_t(lo + nb));
+        if (r <= 0) {
+          ok = false;
+          return;
+        }
+        nb += size_type(r);
+      }
+      dst.append(buf.data(), nb);
+      return;
+    }
+    size_type mid = lo + (hi - lo) / 2;
+    self_type dst_hi;
+    bool ok_hi = true;
+    Fork2::fork2([&] { load_rec(fd, lo, mid, block_szb, dst, ok); },
+                 [&] { load_rec(fd, mid, hi, block_szb, dst_hi, ok_hi); });
+    ok = ok && ok_hi;
+    dst.concat(dst_hi);
+  }
+
+public:
+
+  rope() { }
+
+  rope(const std::string& s) {
+    append(s);
+  }
+
+  rope(const self_type& other)
+  : seq(other.seq) { }
+
+  //! Number of bytes
+  size_type size() const {
+    return seq.size();
+  }
+
+  bool empty() const {
+    return seq.empty();
+  }
+
+  size_type nb_newlines() const {
+    return seq.get_cached();
+  }
+
+  //! Number of lines, counting a last line that has no newline
+  size_type nb_lines() const {
+    if (empty())
+      return 0;
+    return nb_newlines() + (seq.back() == '\n' ? 0 : 1);
+  }
+
+  value_type operator[](size_type i) const {
+    return seq[i];
+  }
+
+  void clear() {
+    seq.clear();
+  }
+
+  void swap(self_type& other) {
+    seq.swap(other.seq);
+  }
+
+  void append(const char* s, size_type nb) {
+    seq.pushn_back(s, nb);
+  }
+
+  void append(const std::string& s) {
+    append(s.data(), s.size());
+  }
+
+  //! Appends the contents of `other`, leaving `other` empty
+  void concat(self_type& other) {
+    seq.concat(other.seq);
+  }
+
+  //! Moves the bytes from `offset` onwards to `other`, which must be empty
+  void split(size_type offset, self_type& other) {
+    assert(offset <= size());
+    if (offset < size())
+      seq.split(offset, other.seq);
+  }
+
+  void insert(size_type offset, const char* s, size_type nb) {
+    self_type hi;
+    split(offset, hi);
+    append(s, nb);
+    concat(hi);
+  }
+
+  void insert(size_type offset, const std::string& s) {
+    insert(offset, s.data(), s.size());
+  }
+
+  void erase(size_type offset, size_type nb) {
+    assert(offset + nb <= size());
+    self_type mid;
+    self_type hi;
+    split(offset, mid);
+    mid.split(nb, hi);
+    concat(hi);
+  }
+
+  //! Byte offset of the start of line `line`, or `size()` if there is no such line
+  size_type line_offset(size_type line) const {
+    if (line == 0)
+      return 0;
+    if (line > nb_newlines())
+      return size();
+    iterator it = seq.begin();
+    it.search_by([&] (size_type nb_newlines_in_prefix) {
+      return nb_newlines_in_prefix >= line;
+    });
+    // the iterator points on the newline that ends line `line - 1`
+    return it.size();
+  }
+
+  //! Number of the line that contains the byte at `offset`
+  size_type line_of(size_type offset) const {
+    assert(offset <= size());
+    size_type lo = 0;
+    size_type hi = nb_newlines();
+    while (lo < hi) {
+      size_type mid = lo + (hi - lo + 1) / 2;
+      if (line_offset(mid) <= offset)
+        lo = mid;
+      else
+        hi = mid - 1;
+    }
+    return lo;
+  }
+
+  /*!
+   * \brief Calls `body(first, last)` on consecutive segments of the
+   * bytes in `[offset, offset + nb)`, without copying them
+   */
+  template <class Body>
+  void for_each_segment(size_type offset, size_type nb, const Body& body) const {
+    assert(offset + nb <= size());
+    if (nb == 0)
+      return;
+    iterator beg = seq.begin() + offset;
+    iterator end = seq.begin() + (offset + nb);
+    seq.for_each_segment(beg, end, [&] (const char* lo, const char* hi) {
+      body(lo, hi);
+    });
+  }
+
+  template <class Body>
+  void for_each_segment(const Body& body) const {
+    seq.for_each_segment([&] (const char* lo, const char* hi) {
+      body(lo, hi);
+    });
+  }
+
+  void copy(size_type offset, size_type nb, char* dst) const {
+    for_each_segment(offset, nb, [&] (const char* lo, const char* hi) {
+      memcpy(dst, lo, hi - lo);
+      dst += hi - lo;
+    });
+  }
+
+  std::string substr(size_type offset, size_type nb) const {
+    std::string s(nb, '\0');
+    copy(offset, nb, &s[0]);
+    return s;
+  }
+
+  //! Contents of line `line`, without its newline character
+  std::string get_line(size_type line) const {
+    size_type lo = line_offset(line);
+    size_type hi = line_offset(line + 1);
+    if (hi > lo && seq[hi - 1] == '\n')
+      hi--;
+    return substr(lo, hi - lo);
+  }
+
+  std::string to_string() const {
+    return substr(0, size());
+  }
+
+  /*!
+   * \brief Appends the contents of the file at `path`
+   *
+   * The file is divided in halves down to blocks of `block_szb`
+   * bytes; blocks are read with `pread` into texts of their own,
+   * which are then joined by `concat`. The halves are handled by the
+   * two branches of `Fork2::fork2`.
+   *
+   * Returns `false` if the file cannot be read.
+   */
+  bool load_file(const std::string& path, size_type block_szb = 1 << 20) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      close(fd);
+      return false;
+    }
+    self_type res;
+    bool ok = true;
+    if (st.st_size > 0)
+      load_rec(fd, 0, size_type(st.st_size), std::max(block_szb, size_type(1)), res, ok);
+    close(fd);
+    if (ok)
+      concat(res);
+    return ok;
+  }
+
+  void check() const {
+    seq.check();
+  }
+
+};
+
+/***********************************************************************/
+
+} // end namespace
+} // end namespace
+} // end namespace
+
+#endif /*! _PASL_DATA_ROPE_H_ */
@@ -0,0 +1,478 @@
+/*!
+ * \author Umut A. Acar
+ * \author Arthur Chargueraud
+ * \author Mike Rainey
+ * \date 2013-2018
+ * \copyright 2014 Umut A. Acar, Arthur Chargueraud, Mike Rainey
+ *
+ * \brief Chunked sequences that keep their first few items inline
+ * \file smallseq.hpp
+ *
+ */
+
+#include <assert.h>
+#include <memory>
+#include <type_traits>
+
+#include "chunkedseq.hpp"
+#include "chunkedbag.hpp"
+
+#ifndef _PASL_DATA_SMALLSEQ_H_
+#define _PASL_DATA_SMALLSEQ_H_
+
+namespace pasl {
+namespace data {
+namespace chunkedseq {
+namespace small {
+
+/***********************************************************************/
+
+/*---------------------------------------------------------------------*/
+/*!
+ * \class sequence
+ * \brief Container that stores up to `Nb_inline` items in an array
+ * of its own, and that switches to a chunked sequence beyond that
+ * \tparam Seq type of the chunked sequence (e.g., a deque or a bag)
+ * \tparam Nb_inline maximal number of items stored inline
+ *
+ * An empty container of type `Seq` allocates its four outer and
+ * inner chunks and its middle sequence. The container below performs
+ * no heap allocation as long as it holds at most `Nb_inline` items:
+ * the items live in an array that is part of the container, and the
+ * cached measurement is computed on demand, from at most `Nb_inline`
+ * items. The container is promoted to a `Seq` the first time it
+ * would overflow the array. A promoted container stays promoted,
+ * even if it shrinks, until it is destroyed; `clear` keeps the
+ * chunked sequence, as a vector keeps its buffer.
+ *
+ * Concatenating two containers that fit together in the array keeps
+ * the result inline; splitting an inline container gives two inline
+ * containers.
+ *
+ * The container offers the operations of `Seq` that are listed
+ * below; the operations on the back and on the front have the same
+ * meaning as in `Seq`. Operations on the front of an inline container
+ * take time linear in `Nb_inline`.
+ */
+template <class Seq, int Nb_inline = 8>
+class sequence {
+public:
+
+  using seq_type = Seq;
+  using self_type = sequence<seq_type, Nb_inline>;
+  using size_type = typename seq_type::size_type;
+  using value_type = typename seq_type::value_type;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using pointer = value_type*;
+  using const_pointer = const value_type*;
+
+  using cache_type = typename seq_type::cache_type;
+  using measured_type = typename cache_type::measured_type;
+  using algebra_type = typename cache_type::algebra_type;
+  using measure_type = typename cache_type::measure_type;
+
+  static constexpr int nb_inline = Nb_inline;
+
+private:
+
+  using cell_type = typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type;
+
+  // number of items in the array; zero once promoted
+  int nb;
+  cell_type cells[Nb_inline];
+  // null as long as the container is inline
+  std::unique_ptr<seq_type> seq;
+  measure_type meas;
+
+  value_type* items() {
+    return reinterpret_cast<value_type*>(cells);
+  }
+
+  const value_type* items() const {
+    return reinterpret_cast<const value_type*>(cells);
+  }
+
+  bool is_inline() const {
+    return seq == nullptr;
+  }
+
+  // moves `n` items from `src` to the uninitialized cells at `dst`
+  static void relocate(value_type* dst, value_type* src, int n) {
+    for (int i = 0; i < n; i++) {
+      new (&dst[i]) value_type(std::move(src[i]));
+      src[i].~value_type();
+    }
+  }
+
+  void destroy_inline(int lo) {
+    for (int i = lo; i < nb; i++)
+      items()[i].~value_type();
+    nb = lo;
+  }
+
+  void promote() {
+    assert(is_inline());
+    seq.reset(new seq_type());
+    seq->set_measure(meas);
+    seq->pushn_back(items(), size_type(nb));
+    destroy_inline(0);
+  }
+
+  void promote_if_empty() {
+    assert(nb == 0);
+    if (is_inline())
+      promote();
+  }
+
+  // appends, as by `pushn_back`, by moving the `n` items at `src`
+  void append_moved(value_type* src, int n) {
+    if (is_inline() && nb + n <= Nb_inline) {
+      relocate(items() + nb, src, n);
+      nb += n;
+      return;
+    }
+    if (is_inline())
+      promote();
+    for (int i = 0; i < n; i++) {
+      seq->push_back(std::move(src[i]));
+      src[i].~value_type();
+    }
+  }
+
+public:
+
+  /*---------------------------------------------------------------------*/
+  /** @name Constructors and destructors
+   */
+  ///@{
+
+  sequence()
+  : nb(0) { }
+
+  sequence(const self_type& other)
+  : nb(0), meas(other.meas) {
+    if (other.is_inline()) {
+      for (int i = 0; i < other.nb; i++)
+        new (&items()[i]) value_type(other.items()[i]);
+      nb = other.nb;
+    } else {
+      seq.reset(new seq_type(*other.seq));
+    }
+  }
+
+  self_type& operator=(const self_type& other) = delete;
+
+  ~sequence() {
+    destroy_inline(0);
+  }
+
+  ///@}
+
+  /*---------------------------------------------------------------------*/
+  /** @name Capacity
+   */
+  ///@{
+
+  size_type size() const {
+    return is_inline() ? size_type(nb) : seq->size();
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  //! Whether the items are stored inline
+  bool is_small() const {
+    return is_inline();
+  }
+
+  ///@}
+
+  /*---------------------------------------------------------------------*/
+  /** @name Item access
+   */
+  ///@{
+
+  value_type front() const {
+    assert(! empty());
+    return is_inline() ? items()[0] : seq->front();
+  }
+
+  value_type back() const {
+    assert(! empty());
+    return is_inline() ? items()[nb - 1] : seq->back();
+  }
+
+  value_type operator[](size_type i) const {
+    assert(i < size());
+    return is_inline() ? items()[i] : (*seq)[i];
+  }
+
+  ///@}
+
+  /*---------------------------------------------------------------------*/
+  /** @name Modifiers
+   */
+  ///@{
+
+  void push_back(const value_type& x) {
+    if (is_inline() && nb < Nb_inline) {
+      new (&items()[nb]) value_type(x);
+      nb++;
+      return;
+    }
+    if (is_inline())
+      promote();
+    seq->push_back(x);
+  }
+
+  void push_front(const value_type& x) {
+    if (is_inline() && nb < Nb_inline) {
+      value_type* p = items();
+      if (nb > 0) {
+        new (&p[nb]) value_type(std::move(p[nb - 1]));
+        for (int i = nb - 1; i > 0; i--)
+          p[i] = std::move(p[i - 1]);
+        p[0] = x;
+      } else {
+        new (&p[0]) value_type(x);
+      }
+      nb++;
+      return;
+    }
+    if (is_inline())
+      promote();
+    seq->push_front(x);
+  }
+
+  value_type pop_back() {
+    assert(! empty());
+    if (! is_inline())
+      return seq->pop_back();
+    value_type v = std::move(items()[nb - 1]);
+    destroy_inline(nb - 1);
+    return v;
+  }
+
+  value_type pop_front() {
+    assert(! empty());
+    if (! is_inline())
+      return seq->pop_front();
+    value_type* p = items();
+    value_type v = std::move(p[0]);
+    for (int i = 0; i + 1 < nb; i++)
+      p[i] = std::move(p[i + 1]);
+    destroy_inline(nb - 1);
+    return v;
+  }
+
+  void pushn_back(const_pointer src, size_type n) {
+    if (is_inline() && nb + int(n) <= Nb_inline) {
+      for (size_type i = 0; i < n; i++)
+        new (&items()[nb + i]) value_type(src[i]);
+      nb += int(n);
+      return;
+    }
+    if (is_inline())
+      promote();
+    seq->pushn_back(src, n);
+  }
+
+  //! Removes all items; a promoted container keeps its chunked sequence
+  void clear() {
+    if (is_inline())
+      destroy_inline(0);
+    else
+      seq->clear();
+  }
+
+  void swap(self_type& other) {
+    int n = std::min(nb, other.nb);
+    for (int i = 0; i < n; i++)
+      std::swap(items()[i], other.items()[i]);
+    if (nb > n)
+      relocate(other.items() + n, items() + n, nb - n);
+    else
+      relocate(items() + n, other.items() + n, other.nb - n);
+    std::swap(nb, other.nb);
+    seq.swap(other.seq);
+    std::swap(meas, other.meas);
+  }
+
+  //! Appends the items of `other`, leaving `other` empty
+  void concat(self_type& other) {
+    if (other.is_inline()) {
+      append_moved(other.items(), other.nb);
+      other.nb = 0;
+      return;
+    }
+    if (is_inline()) {
+      if (empty()) {
+        swap(other);
+        return;
+      }
+      promote();
+    }
+    seq->concat(*other.seq);
+  }
+
+  /*!
+   * \brief Split by index
+   *
+   * The container is erased after and including the item at
+   * (zero-based) index `i`; the erased items are moved to `other`.
+   *
+   * \pre The `other` container is empty.
+   */
+  void split(size_type i, self_type& other) {
+    assert(other.empty());
+    assert(i <= size());
+    if (is_inline()) {
+      other.append_moved(items() + i, nb - int(i));
+      nb = int(i);
+      return;
+    }
+    other.promote_if_empty();
+    seq->split(i, *other.seq);
+  }
+
+  /*!
+   * \brief Split by predicate on the cached measurement
+   *
+   * Finds the first item `x` such that `p` holds for the combined
+   * measurement of the items up to and including `x`. If there is
+   * such an item, the container keeps the items before `x`, `x` is
+   * written in `middle_item`, and the items after `x` are moved to
+   * `other`. Returns whether such an item was found.
+   *
+   * \pre The `other` container is empty.
+   */
+  template <class Pred>
+  bool split(const Pred& p, reference middle_item, self_type& other) {
+    assert(other.empty());
+    if (! is_inline()) {
+      other.promote_if_empty();
+      return seq->split(p, middle_item, *other.seq);
+    }
+    measured_type prefix = algebra_type::identity();
+    for (int i = 0; i < nb; i++) {
+      prefix = algebra_type::combine(prefix, meas(items()[i]));
+      if (p(prefix)) {
+        middle_item = std::move(items()[i]);
+        other.append_moved(items() + i + 1, nb - i - 1);
+        nb = i + 1;
+        destroy_inline(i);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  template <class Pred>
+  void split(const Pred& p, self_type& other) {
+    value_type middle_item;
+    bool found = split(p, middle_item, other);
+    if (found)
+      other.push_front(middle_item);
+  }
+
+  ///@}
+
+  /*---------------------------------------------------------------------*/
+  /** @name Iteration
+   */
+  ///@{
+
+  template <class Body>
+  void for_each(const Body& f) const {
+    if (! is_inline()) {
+      seq->for_each(f);
+      return;
+    }
+    for (int i = 0; i < nb; i++)
+      f(const_cast<value_type&>(items()[i]));
+  }
+
+  template <class Body>
+  void for_each_segment(const Body& f) const {
+    if (! is_inline()) {
+      seq->for_each_segment(f);
+      return;
+    }
+    if (nb > 0) {
+      value_type* lo = const_cast<value_type*>(items());
+      f(lo, lo + nb);
+    }
+  }
+
+  ///@}
+
+  /*---------------------------------------------------------------------*/
+  /** @name Cached measurement
+   */
+  ///@{
+
+  measured_type get_cached() const {
+    if (! is_inline())
+      return seq->get_cached();
+    return meas(items(), items() + nb);
+  }
+
+  measure_type get_measure() const {
+    return meas;
+  }
+
+  void set_measure(measure_type m) {
+    meas = m;
+    if (! is_inline())
+      seq->set_measure(m);
+  }
+
+  ///@}
+
+  void check() const {
+    assert(nb >= 0 && nb <= Nb_inline);
+    if (! is_inline()) {
+      assert(nb == 0);
+      seq->check();
+    }
+  }
+
+};
+
+/*---------------------------------------------------------------------*/
+/* Instantiations */
+
+template <
+  class Item,
+  int Nb_inline = 8,
+  int Chunk_capacity = 512,
+  class Cache = cachedmeasure::trivial<Item, size_t>
+>
+using deque = sequence<bootstrapped::deque<Item, Chunk_capacity, Cache>, Nb_inline>;
+
+template <
+  class Item,
+  int Nb_inline = 8,
+  int Chunk_capacity = 512,
+  class Cache = cachedmeasure::trivial<Item, size_t>
+>
+using stack = sequence<bootstrapped::stack<Item, Chunk_capacity, Cache>, Nb_inline>;
+
+template <
+  class Item,
+  int Nb_inline = 8,
+  int Chunk_capacity = 512,
+  class Cache = cachedmeasure::trivial<Item, size_t>
+>
+using bagopt = sequence<bootstrapped::bagopt<Item, Chunk_capacity, Cache>, Nb_inline>;
+
+/***********************************************************************/
+
+} // end namespace
+} // end namespace
+} // end namespace
+} // end namespace
+
+#endif /*! _PASL_DATA_SMALLSEQ_H_ */
@@ -0,0 +1,728 @@
+/*!
+ * \author Umut A. Acar
+ * \author Arthur Chargueraud
+ * \author Mike Rainey
+ * \date 2013-2018
+ * \copyright 2014 Umut A. Acar, Arthur Chargueraud, Mike Rainey
+ *
+ * \brief Drop-in replacement for std::deque backed by a chunked sequence
+ * \file stldeque.hpp
+ *
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "chunkedseq.hpp"
+
+#ifndef _PASL_DATA_STLDEQUE_H_
+#define _PASL_DATA_STLDEQUE_H_
+
+namespace pasl {
+
+/***********************************************************************/
+
+/*!
+ * \class deque
+ * \brief Double-ended queue with the interface of `std::deque`, backed
+ * by a bootstrapped chunked sequence
+ * \tparam T Type of the items
+ * \tparam Allocator Allocator used to construct and destroy the items
+ *
+ * #### Complexity ####
+ *
+ *   - `push_back`, `push_front`, `pop_back`, `pop_front`, the
+ *     `emplace` variants, `front`, `back`: amortized constant time;
+ *   - `operator[]`, `at`, `begin() + n`: logarithmic time;
+ *   - `end`: constant time, and `begin`: logarithmic time in the
+ *     worst case;
+ *   - `insert` and `erase` of `m` items at any position: logarithmic
+ *     time plus time linear in `m`, where `std::deque` takes time
+ *     linear in the distance to the nearest end;
+ *   - moving an iterator by one: amortized constant time.
+ *
+ * #### Iterator invalidation ####
+ *
+ *   - Any operation that inserts or erases items, at either end or
+ *     in the middle, invalidates all the iterators, including `end()`.
+ *   - Inserting at either end (`push_*`, `emplace_front`,
+ *     `emplace_back`) leaves valid the references to the items.
+ *   - Erasing at either end (`pop_*`, `erase` of a range that
+ *     touches an end) invalidates only the references to the erased
+ *     items.
+ *   - Inserting or erasing in the middle invalidates all the
+ *     references.
+ *   - `swap` exchanges the items without moving them: references
+ *     remain valid, and refer to items of the other container.
+ *
+ * #### Exception safety ####
+ *
+ * If the constructor of an item throws:
+ *
+ *   - in `push_*` or `emplace_*`, the container is left unchanged;
+ *   - in `insert` or `emplace` at any position, the container is
+ *     left unchanged (the items already constructed are destroyed);
+ *   - in a constructor, in `assign` or in the copy assignment, the
+ *     target container is left unchanged.
+ *
+ * Erasures do not throw, provided the destructor of `T` does not.
+ *
+ * #### Requirements ####
+ *
+ * `T` shall be move constructible, because the chunked sequence moves
+ * items between chunks. The operations that work in the middle of the
+ * container (`insert`, `emplace` and `erase` away from both ends)
+ * additionally require `T` to be default constructible, because
+ * splitting the chunked sequence moves the item at the split point
+ * through a temporary. The allocator shall be stateless (its instances
+ * compare equal): the chunks construct and destroy their items with
+ * default-constructed instances of `Allocator`, and take
+ * their storage from the chunk allocator of the chunked sequence.
+ *
+ */
+template <class T, class Allocator = std::allocator<T>>
+class deque {
+private:
+
+  static constexpr int chunk_capacity = 512;
+
+  using cache_type = data::cachedmeasure::trivial<T, size_t>;
+  using sequence_type = data::chunkedseq::bootstrapped::deque<T, chunk_capacity, cache_type,
+                          data::fixedcapacity::heap_allocated::ringbuffer_ptr, Allocator>;
+  using seq_iterator = typename sequence_type::iterator;
+  using alloc_traits = std::allocator_traits<Allocator>;
+
+  static_assert(std::is_same<typename Allocator::value_type, T>::value,
+                "allocator of another value type");
+  static_assert(std::is_empty<Allocator>::value, "stateful allocator");
+
+public:
+
+  /*---------------------------------------------------------------------*/
+  /** @name STL-specific types
+   */
+  ///@{
+  using value_type = T;
+  using allocator_type = Allocator;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using pointer = typename alloc_traits::pointer;
+  using const_pointer = typename alloc_traits::const_pointer;
+  ///@}
+
+  /*---------------------------------------------------------------------*/
+  /*!
+   * \class iterator_base
+   * \brief Random-access iterator, which wraps the iterator of the
+   * chunked sequence
+   */
+  template <class Reference, class Pointer>
+  class iterator_base {
+  public:
+
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using reference = Reference;
+    using pointer = Pointer;
+
+  private:
+
+    friend class deque;
+    template <class, class> friend class iterator_base;
+
+    seq_iterator it;
+
+    explicit iterator_base(const seq_iterator& it)
+    : it(it) { }
+
+    // zero-based index of the item pointed to by the iterator
+    difference_type index() const {
+      return difference_type(it.size()) - 1;
+    }
+
+  public:
+
+    iterator_base() { }
+
+    // conversion from iterator to const_iterator
+    template <class R, class P,
+              class = typename std::enable_if<std::is_convertible<P, Pointer>::value>::type>
+    iterator_base(const iterator_base<R, P>& other)
+    : it(other.it) { }
+
+    reference operator*() const {
+      return *it;
+    }
+
+    pointer operator->() const {
+      return &*it;
+    }
+
+    reference operator[](difference_type n) const {
+      return *(*this + n);
+    }
+
+    iterator_base& operator++() {
+      ++it;
+      return *this;
+    }
+
+    iterator_base operator++(int) {
+      iterator_base result(*this);
+      ++it;
+      return result;
+    }
+
+    iterator_base& operator--() {
+      --it;
+      return *this;
+    }
+
+    iterator_base operator--(int) {
+      iterator_base result(*this);
+      --it;
+      return result;
+    }
+
+    iterator_base& operator+=(difference_type n) {
+      if (n >= 0)
+        it += size_type(n);
+      else
+        it -= size_type(-n);
+      return *this;
+    }
+
+    iterator_base& operator-=(difference_type n) {
+      return *this += -n;
+    }
+
+    friend iterator_base operator+(iterator_base x, difference_type n) {
+      return x += n;
+    }
+
+    friend iterator_base operator+(difference_type n, iterator_base x) {
+      return x += n;
+    }
+
+    friend iterator_base operator-(iterator_base x, difference_type n) {
+      return x -= n;
+    }
+
+    template <class R, class P>
+    difference_type operator-(const iterator_base<R, P>& other) const {
+      return index() - other.index();
+    }
+
+    template <class R, class P>
+    bool operator==(const iterator_base<R, P>& other) const {
+      return it == other.it;
+    }
+
+    template <class R, class P>
+    bool operator!=(const iterator_base<R, P>& other) const {
+      return ! (it == other.it);
+    }
+
+    template <class R, class P>
+    bool operator<(const iterator_base<R, P>& other) const {
+      return index() < other.index();
+    }
+
+    template <class R, class P>
+    bool operator>(const iterator_base<R, P>& other) const {
+      return index() > other.index();
+    }
+
+    template <class R, class P>
+    bool operator<=(const iterator_base<R, P>& other) const {
+      return index() <= other.index();
+    }
+
+    template <class R, class P>
+    bool operator>=(const iterator_base<R, P>& other) const {
+      return index() >= other.index();
+    }
+
+  };
+
+  using iterator = iterator_base<reference, pointer>;
+  using const_iterator = iterator_base<const_reference, const_pointer>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+private:
+
+  allocator_type alloc;
+  sequence_type seq;
+
+  // the end iterator of the chunked sequence is obtained without a
+  // search, so that positioning costs at most one search
+  seq_iterator seq_iterator_at(size_type i) const {
+    assert(i <= size());
+    seq_iterator it = seq.end();
+    it -= size() - i;
+    return it;
+  }
+
+  iterator iterator_at(size_type i) const {
+    return iterator(seq_iterator_at(i));
+  }
+
+  size_type index_of(const_iterator position) const {
+    return size_type(position.index());
+  }
+
+  // Inserts at index `i` the items that `push_items` adds to the back
+  // of `seq`. If `push_items` throws, the items that it has added are
+  // destroyed and the container is restored.
+  template <class Push_items>
+  iterator insert_by(size_type i, const Push_items& push_items) {
+    assert(i <= size());
+    sequence_type tail;
+    if (i < size())
+      seq.split(i, tail);
+    size_type sz = seq.size();
+    try {
+      push_items();
+    } catch (...) {
+      seq.popn_back(seq.size() - sz);
+      seq.concat(tail);
+      throw;
+    }
+    seq.concat(tail);
+    return iterator_at(i);
+  }
+
+public:
+
+  /*---------------------------------------------------------------------*/
+  /** @name Constructors, assignment
+   */
+  ///@{
+
+  deque()
+  : deque(allocator_type()) { }
+
+  explicit deque(const allocator_type& alloc)
+  : alloc(alloc) { }
+
+  explicit deque(size_type n, const allocator_type& alloc = allocator_type())
+  : alloc(alloc) {
+    for (size_type i = 0; i < n; i++)
+      seq.emplace_back();
+  }
+
+  deque(size_type n, const value_type& val, const allocator_type& alloc = allocator_type())
+  : alloc(alloc) {
+    for (size_type i = 0; i < n; i++)
+      seq.push_back(val);
+  }
+
+  template <class Input_iterator,
+            class = typename std::enable_if<! std::is_integral<Input_iterator>::value>::type>
+  deque(Input_iterator first, Input_iterator last, const allocator_type& alloc = allocator_type())
+  : alloc(alloc) {
+    for (; first != last; ++first)
+      seq.emplace_back(*first);
+  }
+
+  deque(const deque& other)
+  : alloc(alloc_traits::select_on_container_copy_construction(other.alloc)),
+    seq(other.seq) { }
+
+  deque(const deque& other, const allocator_type& alloc)
+  : alloc(alloc), seq(other.seq) { }
+
+  deque(deque&& other)
+  : alloc(std::move(other.alloc)) {
+    seq.swap(other.seq);
+  }
+
+  deque(deque&& other, const allocator_type& alloc)
+  : alloc(alloc) {
+    seq.swap(other.seq);
+  }
+
+  deque(std::initializer_list<value_type> l, const allocator_type& alloc = allocator_type())
+  : deque(l.begin(), l.end(), alloc) { }
+
+  deque& operator=(const deque& other) {
+    if (this != &other) {
+      sequence_type tmp(other.seq);
+      seq.swap(tmp);
+    }
+    return *this;
+  }
+
+  // leaves `other` empty
+  deque& operator=(deque&& other) {
+    if (this != &other) {
+      sequence_type tmp;
+      tmp.swap(other.seq);
+      seq.swap(tmp);
+    }
+    return *this;
+  }
+
+  deque& operator=(std::initializer_list<value_type> l) {
+    assign(l.begin(), l.end());
+    return *this;
+  }
+
+  void assign(size_type n, const value_type& val) {
+    deque tmp(n, val);
+    seq.swap(tmp.seq);
+  }
+
+  template <class Input_iterator,
+            class = typename std::enable_if<! std::is_integral<Input_iterator>::value>::type>
+  void assign(Input_iterator first, Input_iterator last) {
+    deque tmp(first, last);
+    seq.swap(tmp.seq);
+  }
+
+  void assign(std::initializer_list<value_type> l) {
+    assign(l.begin(), l.end());
+  }
+
+  allocator_type get_allocator() const {
+    return alloc;
+  }
+  ///@}
+
+  /*---------------------------------------------------------------------*/
+  /** @name Item access
+   */
+  ///@{
+
+  reference at(size_type n) {
+    if (n >= size())
+      throw std::out_of_range("pasl::deque::at");
+    return (*this)[n];
+  }
+
+  const_reference at(size_type n) const {
+    if (n >= size())
+      throw std::out_of_range("pasl::deque::at");
+    return (*this)[n];
+  }
+
+  reference operator[](size_type n) {
+    assert(n < size());
+    return *seq_iterator_at(n);
+  }
+
+  const_reference operator[](size_type n) const {
+    assert(n < size());
+    return *seq_iterator_at(n);
+  }
+
+  reference front() {
+    assert(! empty());
+    return seq.front();
+  }
+
+  const_reference front() const {
+    assert(! empty());
+    return seq.front();
+  }
+
+  reference back() {
+    assert(! empty());
+    return seq.back();
+  }
+
+  const_reference back() const {
+    assert(! empty());
+    return seq.back();
+  }
+  ///@}
+
+  /*---------------------------------------------------------------------*/
+  /** @name Iterators
+   */
+  ///@{
+
+  iterator begin() {
+    return iterator(seq.begin());
+  }
+
+  const_iterator begin() const {
+    return const_iterator(seq.begin());
+  }
+
+  const_iterator cbegin() const {
+    return begin();
+  }
+
+  iterator end() {
+    return iterator(seq.end());
+  }
+
+  const_iterator end() const {
+    return const_iterator(seq.end());
+  }
+
+  const_iterator cend() const {
+    return end();
+  }
+
+  reverse_iterator rbegin() {
+    return reverse_iterator(end());
+  }
+
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+
+  const_reverse_iterator crbegin() const {
+    return rbegin();
+  }
+
+  reverse_iterator rend() {
+    return reverse_iterator(begin());
+  }
+
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+
+  const_reverse_iterator crend() const {
+    return rend();
+  }
+  ///@}
+
+  /*---------------------------------------------------------------------*/
+  /** @name Capacity
+   */
+  ///@{
+
+  bool empty() const {
+    return seq.empty();
+  }
+
+  size_type size() const {
+    return seq.size();
+  }
+
+  size_type max_size() const {
+    return std::min<size_type>(alloc_traits::max_size(alloc),
+                               std::numeric_limits<difference_type>::max());
+  }
+
+  // repacks the items into full chunks (see `chunkedseqbase::compact`)
+  void shrink_to_fit() {
+    seq.compact();
+  }
+  ///@}
+
+  /*---------------------------------------------------------------------*/
+  /** @name Modifiers
+   */
+  ///@{
+
+  void clear() {
+    seq.clear();
+  }
+
+  iterator insert(const_iterator position, const value_type& val) {
+    return emplace(position, val);
+  }
+
+  iterator insert(const_iterator position, value_type&& val) {
+    return emplace(position, std::move(val));
+  }
+
+  iterator insert(const_iterator position, size_type n, const value_type& val) {
+    size_type i = index_of(position);
+    if (n == 0)
+      return iterator_at(i);
+    // `val` may be an item of the container, which the split may move
+    value_type x(val);
+    return insert_by(i, [&] {
+      for (size_type k = 0; k < n; k++)
+        seq.push_back(x);
+    });
+  }
+
+  template <class Input_iterator,
+            class = typename std::enable_if<! std::is_integral<Input_iterator>::value>::type>
+  iterator insert(const_iterator position, Input_iterator first, Input_iterator last) {
+    size_type i = index_of(position);
+    if (first == last)
+      return iterator_at(i);
+    return insert_by(i, [&] {
+      for (; first != last; ++first)
+        seq.emplace_back(*first);
+    });
+  }
+
+  iterator insert(const_iterator position, std::initializer_list<value_type> l) {
+    return insert(position, l.begin(), l.end());
+  }
+
+  template <class... Args>
+  iterator emplace(const_iterator position, Args&&... args) {
+    size_type i = index_of(position);
+    if (i == size()) {
+      seq.emplace_back(std::forward<Args>(args)...);
+      return iterator_at(i);
+    }
+    if (i == 0) {
+      seq.emplace_front(std::forward<Args>(args)...);
+      return begin();
+    }
+    // the arguments may refer to items of the container, which the
+    // split may move
+    value_type x(std::forward<Args>(args)...);
+    return insert_by(i, [&] {
+      seq.push_back(std::move(x));
+    });
+  }
+
+  iterator erase(const_iterator position) {
+    assert(index_of(position) < size());
+    return erase(position, std::next(position));
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    size_type i = index_of(first);
+    size_type j = index_of(last);
+    assert(i <= j && j <= size());
+    if (i == j) {
+      // nothing to erase
+    } else if (j == size()) {
+      seq.popn_back(j - i);
+    } else if (i == 0) {
+      seq.popn_front(j);
+    } else {
+      sequence_type erased, tail;
+      seq.split(i, erased);
+      erased.split(j - i, tail);
+      seq.concat(tail);
+    }
+    return iterator_at(i);
+  }
+
+  void push_back(const value_type& val) {
+    seq.push_back(val);
+  }
+
+  void push_back(value_type&& val) {
+    seq.push_back(std::move(val));
+  }
+
+  template <class... Args>
+  reference emplace_back(Args&&... args) {
+    seq.emplace_back(std::forward<Args>(args)...);
+    return seq.back();
+  }
+
+  void pop_back() {
+    assert(! empty());
+    seq.pop_back();
+  }
+
+  void push_front(const value_type& val) {
+    seq.push_front(val);
+  }
+
+  void push_front(value_type&& val) {
+    seq.push_front(std::move(val));
+  }
+
+  template <class... Args>
+  reference emplace_front(Args&&... args) {
+    seq.emplace_front(std::forward<Args>(args)...);
+    return seq.front();
+  }
+
+  void pop_front() {
+    assert(! empty());
+    seq.pop_front();
+  }
+
+  void resize(size_type n) {
+    size_type sz = size();
+    if (n < sz) {
+      seq.popn_back(sz - n);
+    } else {
+      try {
+        while (seq.size() < n)
+          seq.emplace_back();
+      } catch (...) {
+        seq.popn_back(seq.size() - sz);
+        throw;
+      }
+    }
+  }
+
+  void resize(size_type n, const value_type& val) {
+    size_type sz = size();
+    if (n < sz)
+      seq.popn_back(sz - n);
+    else
+      insert(end(), n - sz, val);
+  }
+
+  void swap(deque& other) {
+    seq.swap(other.seq);
+  }
+  ///@}
+
+};
+
+/*---------------------------------------------------------------------*/
+/* Comparisons */
+
+template <class T, class Allocator>
+bool operator==(const deque<T, Allocator>& x, const deque<T, Allocator>& y) {
+  return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin());
+}
+
+template <class T, class Allocator>
+bool operator!=(const deque<T, Allocator>& x, const deque<T, Allocator>& y) {
+  return ! (x == y);
+}
+
+template <class T, class Allocator>
+bool operator<(const deque<T, Allocator>& x, const deque<T, Allocator>& y) {
+  return std::lexicographical_compare(x.begin(), x.end(), y.begin(), y.end());
+}
+
+template <class T, class Allocator>
+bool operator>(const deque<T, Allocator>& x, const deque<T, Allocator>& y) {
+  return y < x;
+}
+
+template <class T, class Allocator>
+bool operator<=(const deque<T, Allocator>& x, const deque<T, Allocator>& y) {
+  return ! (y < x);
+}
+
+template <class T, class Allocator>
+bool operator>=(const deque<T, Allocator>& x, const deque<T, Allocator>& y) {
+  return ! (x < y);
+}
+
+template <class T, class Allocator>
+void swap(deque<T, Allocator>& x, deque<T, Allocator>& y) {
+  x.swap(y);
+}
+
+/***********************************************************************/
+
+} // end namespace
+
+#endif /*! _PASL_DATA_STLDEQUE_H_ */
@@ -0,0 +1,390 @@
+/*!
+ * \author Umut A. Acar
+ * \author Arthur Chargueraud
+ * \author Mike Rainey
+ * \date 2013-2018
+ * \copyright 2014 Umut A. Acar, Arthur Chargueraud, Mike Rainey
+ *
+ * \brief Conformance tests for pasl::deque, against std::deque
+ * \file test_stldeque.cpp
+ *
+ */
+
+#undef NDEBUG
+
+#include <assert.h>
+#include <stdio.h>
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "cmdline.hpp"
+#include "stldeque.hpp"
+
+/***********************************************************************/
+
+using item_type = std::string;
+using test_deque = pasl::deque<item_type>;
+using ref_deque = std::deque<item_type>;
+
+template <class D1, class D2>
+void check_same(const D1& d1, const D2& d2) {
+  assert(d1.size() == d2.size());
+  assert(d1.empty() == d2.empty());
+  assert(std::equal(d1.begin(), d1.end(), d2.begin()));
+  assert(std::equal(d1.rbegin(), d1.rend(), d2.rbegin()));
+  assert(d1.end() - d1.begin() == (ptrdiff_t)d1.size());
+  if (! d1.empty()) {
+    assert(d1.front() == d2.front());
+    assert(d1.back() == d2.back());
+    size_t i = d1.size() / 3;
+    assert(d1[i] == d2[i]);
+    assert(d1.at(i) == d2.at(i));
+    assert(*(d1.begin() + i) == d2[i]);
+    assert(*(d1.end() - (ptrdiff_t)(d1.size() - i)) == d2[i]);
+  }
+}
+
+/*---------------------------------------------------------------------*/
+/* Random sequences of operations, compared with std::deque */
+
+void test_random_operations(std::mt19937& gen, int nb_ops, int max_size) {
+  test_deque d;
+  ref_deque r;
+  auto rand = [&] (size_t n) { return (n == 0) ? 0 : size_t(gen() % n); };
+  for (int k = 0; k < nb_ops; k++) {
+    std::string x = std::to_string(gen() % 1000000);
+    int op = (int)rand(12);
+    if ((int)r.size() > max_size)
+      op = 4;
+    switch (op) {
+      case 0: {
+        d.push_back(x);
+        r.push_back(x);
+        break;
+      }
+      case 1: {
+        d.emplace_front(x);
+        r.emplace_front(x);
+        break;
+      }
+      case 2: {
+        if (! r.empty()) {
+          d.pop_back();
+          r.pop_back();
+        }
+        break;
+      }
+      case 3: {
+        if (! r.empty()) {
+          d.pop_front();
+          r.pop_front();
+        }
+        break;
+      }
+      case 4: {
+        size_t i = rand(r.size() + 1);
+        size_t j = i + rand(r.size() - i + 1);
+        auto it = d.erase(d.cbegin() + i, d.cbegin() + j);
+        auto rit = r.erase(r.cbegin() + i, r.cbegin() + j);
+        assert(it - d.begin() == rit - r.begin());
+        break;
+      }
+      case 5: {
+        size_t i = rand(r.size() + 1);
+        auto it = d.insert(d.cbegin() + i, x);
+        auto rit = r.insert(r.cbegin() + i, x);
+        assert(it - d.begin() == rit - r.begin() && *it == x);
+        break;
+      }
+      case 6: {
+        size_t i = rand(r.size() + 1);
+        size_t n = rand(2000);
+        d.insert(d.begin() + i, n, x);
+        r.insert(r.begin() + i, n, x);
+        break;
+      }
+      case 7: {
+        size_t i = rand(r.size() + 1);
+        std::vector<std::string> xs(rand(1500));
+        for (auto& y : xs)
+          y = std::to_string(gen());
+        d.insert(d.begin() + i, xs.begin(), xs.end());
+        // some versions of libstdc++ corrupt a std::deque on the
+        // insertion of an empty range
+        if (! xs.empty())
+          r.insert(r.begin() + i, xs.begin(), xs.end());
+        break;
+      }
+      case 8: {
+        // the inserted value is an item of the container
+        if (! r.empty()) {
+          size_t i = rand(r.size() + 1);
+          size_t j = rand(r.size());
+          d.insert(d.begin() + i, d[j]);
+          r.insert(r.begin() + i, r[j]);
+        }
+        break;
+      }
+      case 9: {
+        if (! r.empty()) {
+          size_t i = rand(r.size());
+          d.erase(d.begin() + i);
+          r.erase(r.begin() + i);
+        }
+        break;
+      }
+      case 10: {
+        size_t n = rand(2 * r.size() + 10);
+        d.resize(n, x);
+        r.resize(n, x);
+        break;
+      }
+      case 11: {
+        if (! r.empty()) {
+          size_t i = rand(r.size());
+          d[i] = x;
+          r[i] = x;
+        }
+        break;
+      }
+    }
+    check_same(d, r);
+  }
+}
+
+/*---------------------------------------------------------------------*/
+/* Constructors, assignment and comparisons */
+
+void test_constructors() {
+  test_deque a;
+  assert(a.empty() && a.begin() == a.end());
+  test_deque b(5, "x");
+  check_same(b, ref_deque(5, "x"));
+  test_deque c(7);
+  check_same(c, ref_deque(7));
+  test_deque d = { "a", "b", "c" };
+  check_same(d, ref_deque({ "a", "b", "c" }));
+  ref_deque rs;
+  for (int i = 0; i < 5000; i++)
+    rs.push_back(std::to_string(i));
+  test_deque e(rs.begin(), rs.end());
+  check_same(e, rs);
+  test_deque f(e);
+  check_same(f, rs);
+  test_deque g(std::move(f));
+  check_same(g, rs);
+  assert(f.empty());
+  a = g;
+  check_same(a, rs);
+  a = a;
+  check_same(a, rs);
+  b = std::move(a);
+  check_same(b, rs);
+  assert(a.empty());
+  b = { "u", "v" };
+  check_same(b, ref_deque({ "u", "v" }));
+  b.assign(3, "w");
+  check_same(b, ref_deque(3, "w"));
+  b.assign(rs.begin(), rs.begin() + 10);
+  check_same(b, ref_deque(rs.begin(), rs.begin() + 10));
+  b.swap(g);
+  check_same(g, ref_deque(rs.begin(), rs.begin() + 10));
+  check_same(b, rs);
+  swap(b, g);
+  check_same(g, rs);
+  assert(b == test_deque(rs.begin(), rs.begin() + 10));
+  assert(b != g);
+  assert(test_deque({ "a", "b" }) < test_deque({ "a", "c" }));
+  assert(test_deque({ "a" }) < test_deque({ "a", "a" }));
+  assert(test_deque({ "b" }) > test_deque({ "a", "z" }));
+  assert(test_deque({ "a" }) <= test_deque({ "a" }));
+  assert(test_deque({ "a" }) >= test_deque({ "a" }));
+  assert(g.get_allocator() == std::allocator<item_type>());
+  assert(g.max_size() > 0);
+  bool thrown = false;
+  try {
+    g.at(g.size());
+  } catch (std::out_of_range&) {
+    thrown = true;
+  }
+  assert(thrown);
+  g.shrink_to_fit();
+  check_same(g, rs);
+  g.clear();
+  assert(g.empty() && g.size() == 0);
+}
+
+/*---------------------------------------------------------------------*/
+/* Iterators and standard algorithms */
+
+void test_iterators() {
+  using it_traits = std::iterator_traits<test_deque::iterator>;
+  static_assert(std::is_same<it_traits::iterator_category, std::random_access_iterator_tag>::value, "");
+  static_assert(std::is_same<it_traits::reference, item_type&>::value, "");
+  static_assert(std::is_same<std::iterator_traits<test_deque::const_iterator>::reference,
+                             const item_type&>::value, "");
+  static_assert(! std::is_convertible<test_deque::const_iterator, test_deque::iterator>::value, "");
+  pasl::deque<int> d;
+  std::deque<int> r;
+  for (int i = 0; i < 100000; i++) {
+    int x = (i * 7919) % 100003;
+    d.push_back(x);
+    r.push_back(x);
+  }
+  std::sort(d.begin(), d.end());
+  std::sort(r.begin(), r.end());
+  assert(std::equal(d.begin(), d.end(), r.begin()));
+  assert(std::binary_search(d.begin(), d.end(), r[500]));
+  std::reverse(d.begin(), d.end());
+  std::reverse(r.begin(), r.end());
+  assert(std::equal(d.cbegin(), d.cend(), r.begin()));
+  assert(std::accumulate(d.begin(), d.end(), 0L) == std::accumulate(r.begin(), r.end(), 0L));
+  pasl::deque<int>::const_iterator ci = d.begin();
+  assert(ci == d.begin() && d.begin() == ci);
+  ci += 1000;
+  assert(*ci == r[1000] && ci[-10] == r[990] && ci[10] == r[1010]);
+  ci -= 1000;
+  assert(ci == d.cbegin());
+  auto it = d.end();
+  --it;
+  assert(*it == r.back() && it + 1 == d.end() && it - d.begin() == (ptrdiff_t)r.size() - 1);
+  assert(d.begin() < it && it > d.begin() && d.begin() <= d.begin() && it >= it);
+  int k = 0;
+  for (auto jt = d.rbegin(); jt != d.rend(); jt++, k++)
+    assert(*jt == r[r.size() - 1 - k]);
+  struct pair_type { int a; int b; };
+  pasl::deque<pair_type> p(3, pair_type{ 1, 2 });
+  assert(p.begin()->b == 2);
+}
+
+/*---------------------------------------------------------------------*/
+/* Move-only items */
+
+void test_move_only() {
+  pasl::deque<std::unique_ptr<int>> d;
+  for (int i = 0; i < 3000; i++)
+    d.emplace_back(new int(i));
+  d.emplace_front(new int(-1));
+  d.push_back(std::unique_ptr<int>(new int(3000)));
+  d.emplace(d.begin() + 1500, new int(42));
+  d.insert(d.begin() + 10, std::unique_ptr<int>(new int(43)));
+  assert(d.size() == 3004);
+  assert(*d.front() == -1 && *d.back() == 3000 && *d[1501] == 42 && *d[10] == 43);
+  d.erase(d.begin() + 10);
+  d.erase(d.begin() + 1500);
+  for (int i = 0; i < 3000; i++)
+    assert(*d[i + 1] == i);
+  pasl::deque<std::unique_ptr<int>> e(std::move(d));
+  assert(e.size() == 3002 && d.empty());
+}
+
+/*---------------------------------------------------------------------*/
+/* Exception safety */
+
+class throwing {
+public:
+  static int nb_live;
+  static int countdown; // the constructor throws when it reaches zero
+  int v;
+  throwing() : v(0) {
+    nb_live++;
+  }
+  throwing(int v) : v(v) {
+    tick();
+    nb_live++;
+  }
+  throwing(const throwing& other) : v(other.v) {
+    tick();
+    nb_live++;
+  }
+  throwing(throwing&& other) : v(other.v) {
+    nb_live++;
+  }
+  throwing& operator=(const throwing& other) = default;
+  ~throwing() {
+    nb_live--;
+  }
+  static void tick() {
+    if (countdown > 0 && --countdown == 0)
+      throw std::runtime_error("throwing");
+  }
+  bool operator==(const throwing& other) const {
+    return v == other.v;
+  }
+};
+
+int throwing::nb_live = 0;
+int throwing::countdown = 0;
+
+template <class Body>
+void check_throws(const Body& body) {
+  bool thrown = false;
+  try {
+    body();
+  } catch (std::runtime_error&) {
+    thrown = true;
+  }
+  assert(thrown);
+}
+
+void test_exception_safety() {
+  {
+    pasl::deque<throwing> d;
+    std::deque<throwing> r;
+    for (int i = 0; i < 5000; i++) {
+      d.emplace_back(i);
+      r.emplace_back(i);
+    }
+    throwing x(-1);
+    throwing::countdown = 1;
+    check_throws([&] { d.push_back(x); });
+    check_same(d, r);
+    throwing::countdown = 1;
+    check_throws([&] { d.emplace_front(-2); });
+    check_same(d, r);
+    throwing::countdown = 1;
+    check_throws([&] { d.insert(d.begin() + 2500, x); });
+    check_same(d, r);
+    throwing::countdown = 700;
+    check_throws([&] { d.insert(d.begin() + 1234, 1000, x); });
+    check_same(d, r);
+    std::vector<throwing> xs(800, x);
+    throwing::countdown = 600;
+    check_throws([&] { d.insert(d.begin() + 4321, xs.begin(), xs.end()); });
+    check_same(d, r);
+    throwing::countdown = 300;
+    check_throws([&] { d.resize(6000, x); });
+    check_same(d, r);
+    throwing::countdown = 100;
+    pasl::deque<throwing> e(10, x);
+    check_throws([&] { e = d; });
+    assert(e.size() == 10);
+    throwing::countdown = 0;
+  }
+  assert(throwing::nb_live == 0);
+}
+
+/*---------------------------------------------------------------------*/
+
+int main(int argc, char** argv) {
+  pasl::util::cmdline::set(argc, argv);
+  int nb_ops = pasl::util::cmdline::parse_or_default_int("nb_ops", 3000);
+  int max_size = pasl::util::cmdline::parse_or_default_int("max_size", 20000);
+  int seed = pasl::util::cmdline::parse_or_default_int("seed", 1);
+  std::mt19937 gen(seed);
+  test_constructors();
+  test_iterators();
+  test_move_only();
+  test_exception_safety();
+  test_random_operations(gen, nb_ops, max_size);
+  printf("OK\n");
+  return 0;
+}
+
+/***********************************************************************/
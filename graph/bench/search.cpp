@@ -38,6 +38,13 @@ using chunkedseq_deque = data::pcontainer::deque<typename Adjlist::vtxid_type>;
 template <class Adjlist>
 using chunkedseq_bag = data::pcontainer::bag<typename Adjlist::vtxid_type>;
 
+template <class Adjlist>
+using chunkedseq_compressed = data::pcontainer::compressed_deque<typename Adjlist::vtxid_type>;
+
+template <class Adjlist>
+using chunkedseq_bitpacked = data::pcontainer::compressed_deque<typename Adjlist::vtxid_type,
+  data::chunkedseq::compressed::bitpacked<typename Adjlist::vtxid_type>>;
+
 template <class Adjlist>
 using chunkedftree_stack = data::pcontainer::ftree_stack<typename Adjlist::vtxid_type>;
 
@@ -69,6 +76,7 @@ using ls_bag = data::Bag<typename Adjlist::vtxid_type>;
 int our_pseudodfs_cutoff = 10000;
 int ls_pbfs_cutoff = 10000;
 int ls_pbfs_loop_cutoff = 10000;
+int weighted_pbfs_cutoff = 10000;
 int our_bfs_cutoff = 10000;
 int our_lazy_bfs_cutoff = 10000;
 
@@ -247,6 +255,9 @@ void search_benchmark_parallel_select_algo() {
   m.add("our_lazy_pbfs",    [&] (const adjlist_type& graph, vtxid_type source) {
     our_lazy_bfs_cutoff = util::cmdline::parse_or_default_int("our_lazy_pbfs_cutoff", 1024);
     dists = our_lazy_bfs<idempotent>::template main<adjlist_type, frontiersegbag<adjlist_alias_type>>(graph, source); });
+  m.add("weighted_pbfs",    [&] (const adjlist_type& graph, vtxid_type source) {
+    weighted_pbfs_cutoff = util::cmdline::parse_or_default_int("weighted_pbfs_cutoff", 1024);
+    dists = weighted_pbfs<idempotent>::template main<adjlist_seq_type>(graph, source); });
 #endif
   m.add("our_pseudodfs",   [&] (const adjlist_type& graph, vtxid_type source) {
     our_pseudodfs_cutoff = util::cmdline::parse_or_default_int("our_pseudodfs_cutoff", 1024);
@@ -319,6 +330,7 @@ static bool is_parallel_algo() {
   if (algo == "our_pbfs")              return true;
   if (algo == "our_pbfs_with_swap")    return true;
   if (algo == "our_lazy_pbfs")         return true;
+  if (algo == "weighted_pbfs")         return true;
   if (algo == "our_pseudodfs")         return true;
   if (algo == "cong_pseudodfs")        return true;
   if (algo == "pbbs_pbfs")             return true;
@@ -376,6 +388,10 @@ void search_benchmark_select_frontier() {
     search_benchmark_frontier_select_parallelism<Adjlist, chunkedseq_deque<Adjlist>>(); });
   c.add("chunkedseq_stack",       [&] {
     search_benchmark_frontier_select_parallelism<Adjlist, chunkedseq_stack<Adjlist>>(); });
+  c.add("chunkedseq_compressed",       [&] {
+    search_benchmark_frontier_select_parallelism<Adjlist, chunkedseq_compressed<Adjlist>>(); });
+  c.add("chunkedseq_bitpacked",       [&] {
+    search_benchmark_frontier_select_parallelism<Adjlist, chunkedseq_bitpacked<Adjlist>>(); });
   c.add("chunkedftree_stack",       [&] {
     search_benchmark_frontier_select_parallelism<Adjlist, chunkedftree_stack<Adjlist>>(); });
   c.add("chunkedftree",       [&] {
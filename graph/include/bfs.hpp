@@ -480,6 +480,139 @@ public:
 
 /*---------------------------------------------------------------------*/
 
+// Parallel BFS whose frontier is divided by out-degree:
+// same as ls_pbfs, except that the frontier caches the weights of its
+// vertices, and that each frontier is processed by a loop that divides
+// the frontier where half of the weight is reached (see
+// pcontainer::forkjoin_segments_by_weight), so that the pieces hold
+// the same number of out-edges, however skewed the degrees. The edges
+// of a vertex whose out-degree exceeds the cutoff are handled by a
+// parallel loop of their own.
+
+extern int weighted_pbfs_cutoff;
+
+template <bool idempotent = false>
+class weighted_pbfs {
+public:
+  
+  using self_type = weighted_pbfs<idempotent>;
+  
+  // the weight of a vertex is one plus its out-degree, the one counting
+  // for the visit of the vertex itself
+  template <class Adjlist_seq>
+  class out_degree_weight {
+  public:
+    
+    using vtxid_type = typename adjlist<Adjlist_seq>::vtxid_type;
+    
+    const adjlist<Adjlist_seq>* graph;
+    
+    out_degree_weight() : graph(nullptr) { }
+    out_degree_weight(const adjlist<Adjlist_seq>* graph) : graph(graph) { }
+    
+    long operator()(vtxid_type v) const {
+      return 1 + (long)graph->adjlists[v].get_out_degree();
+    }
+    
+  };
+  
+  template <class Adjlist_seq>
+  using frontier_type = data::pcontainer::weighted_deque<typename adjlist<Adjlist_seq>::vtxid_type,
+                                                         out_degree_weight<Adjlist_seq>>;
+  
+  template <class Adjlist_seq>
+  static void process_layer(const adjlist<Adjlist_seq>& graph,
+                            std::atomic<typename adjlist<Adjlist_seq>::vtxid_type>* dists,
+                            typename adjlist<Adjlist_seq>::vtxid_type dist_of_next,
+                            frontier_type<Adjlist_seq>& prev,
+                            frontier_type<Adjlist_seq>& next) {
+    using vtxid_type = typename adjlist<Adjlist_seq>::vtxid_type;
+    using frontier = frontier_type<Adjlist_seq>;
+    using edge_range_type = std::pair<vtxid_type, vtxid_type>;
+    vtxid_type unknown = graph_constants<vtxid_type>::unknown_vtxid;
+    auto append = [] (frontier& f1, frontier& f2) {
+      f1.concat(f2);
+    };
+    // the frontiers created by the loops compute weights on the same graph
+    auto set_env = [&prev] (frontier& f) {
+      prev.copy_measure_to(f);
+    };
+    auto visit = [&] (vtxid_type other, frontier& next) {
+      if (ls_pbfs<idempotent>::try_to_set_dist(other, unknown, dist_of_next, dists)) {
+        if (PUSH_ZERO_ARITY_VERTICES || graph.adjlists[other].get_out_degree() > 0)
+          next.push_back(other);
+      }
+    };
+    data::pcontainer::forkjoin_segments_by_weight(prev, next, append, set_env,
+                                                  [&] (vtxid_type* lo, vtxid_type* hi, frontier& next) {
+      for (vtxid_type* p = lo; p < hi; p++) {
+        vtxid_type degree = graph.adjlists[*p].get_out_degree();
+        vtxid_type* neighbors = graph.adjlists[*p].get_out_neighbors();
+        if (degree <= vtxid_type(weighted_pbfs_cutoff)) {
+          for (vtxid_type edge = 0; edge < degree; edge++)
+            visit(neighbors[edge], next);
+          continue;
+        }
+        auto cutoff = [] (const edge_range_type& r) {
+          return r.second - r.first <= vtxid_type(weighted_pbfs_cutoff);
+        };
+        auto split = [] (edge_range_type& src, edge_range_type& dst) {
+          vtxid_type mid = (src.first + src.second) / 2;
+          dst.first = mid;
+          dst.second = src.second;
+          src.second = mid;
+        };
+        auto set_in_env = [] (edge_range_type&) { };
+        edge_range_type edges(0, degree);
+        sched::native::forkjoin(edges, next, cutoff, split, append, set_in_env, set_env,
+                                [&] (edge_range_type& r, frontier& next) {
+          for (vtxid_type edge = r.first; edge < r.second; edge++)
+            visit(neighbors[edge], next);
+        });
+      }
+    }, long(weighted_pbfs_cutoff));
+    prev.clear();
+  }
+  
+  template <class Adjlist_seq>
+  static std::atomic<typename adjlist<Adjlist_seq>::vtxid_type>*
+  main(const adjlist<Adjlist_seq>& graph,
+       typename adjlist<Adjlist_seq>::vtxid_type source) {
+#ifdef GRAPH_SEARCH_STATS
+    peak_frontier_size = 0l;
+#endif
+    using vtxid_type = typename adjlist<Adjlist_seq>::vtxid_type;
+    using frontier = frontier_type<Adjlist_seq>;
+    using measure_type = typename frontier::measure_type;
+    vtxid_type unknown = graph_constants<vtxid_type>::unknown_vtxid;
+    vtxid_type nb_vertices = graph.get_nb_vertices();
+    std::atomic<vtxid_type>* dists = data::mynew_array<std::atomic<vtxid_type>>(nb_vertices);
+    fill_array_par(dists, nb_vertices, unknown);
+    LOG_BASIC(ALGO_PHASE);
+    out_degree_weight<Adjlist_seq> weight(&graph);
+    measure_type meas(weight);
+    frontier prev;
+    frontier next;
+    prev.set_measure(meas);
+    next.set_measure(meas);
+    vtxid_type dist = 0;
+    prev.push_back(source);
+    dists[source].store(dist);
+    while (! prev.empty()) {
+      dist++;
+      self_type::process_layer(graph, dists, dist, prev, next);
+      prev.swap(next);
+#ifdef GRAPH_SEARCH_STATS
+      peak_frontier_size = std::max((size_t)prev.size(), peak_frontier_size);
+#endif
+    }
+    return dists;
+  }
+  
+};
+
+/*---------------------------------------------------------------------*/
+
 // Parallel BFS using our frontier-segment-based algorithm:
 // Process each frontier by doing a parallel_for on the set of 
 // outgoing edges, which is represented using our "frontier" data
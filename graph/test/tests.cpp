@@ -280,6 +280,18 @@ void check_bfs() {
     typeof(get_visited_seq), typeof(get_visited_par), vtxid_type>;
     prop_pbfs (trusted_bfs, by_pbfs, get_visited_seq, get_visited_par).check(nb_tests);
   });
+  c.add("weighted_pbfs", [&] {
+    auto by_pbfs = [&] (const adjlist_type& graph, vtxid_type source) -> std::atomic<vtxid_type>* {
+      vtxid_type nb_vertices = graph.get_nb_vertices();
+      if (nb_vertices == 0)
+        return NULL;
+      return weighted_pbfs<false>::main<Adjlist_seq>(graph, source);
+    };
+    using prop_pbfs =
+    prop_search_same<adjlist_type, typeof(trusted_bfs), typeof(by_pbfs),
+    typeof(get_visited_seq), typeof(get_visited_par), vtxid_type>;
+    prop_pbfs (trusted_bfs, by_pbfs, get_visited_seq, get_visited_par).check(nb_tests);
+  });
   c.add("our_pbfs", [&] {
     auto by_fpbfs = [&] (const adjlist_type& graph, vtxid_type source) -> std::atomic<vtxid_type>* {
       vtxid_type nb_vertices = graph.get_nb_vertices();
@@ -427,6 +439,7 @@ int cong_pdfs_cutoff = 16;
 int our_pseudodfs_cutoff = 16;
 int ls_pbfs_cutoff = 256;
 int ls_pbfs_loop_cutoff = 256;
+int weighted_pbfs_cutoff = 8;
 int our_bfs_cutoff = 8;
 int our_lazy_bfs_cutoff = 8;
 
@@ -175,9 +175,9 @@ void cstmt_sequential_with_reporting(cmeasure_type m,
 
   if (m < 0)
     pasl::util::atomic::fatal([] { std::cout << "error" << std::endl; });
-  cost_type start = util::ticks::now();
+  util::ticks::ticks_t start = util::ticks::now_begin();
   execmode.mine().block(Sequential, seq_body_fct);
-  cost_type elapsed = util::ticks::since(start);
+  cost_type elapsed = util::ticks::diff(start, util::ticks::now_end());
   estimator.report(std::max(1l, m), elapsed);
   STAT_COUNT(MEASURED_RUN);
 }
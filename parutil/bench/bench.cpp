@@ -0,0 +1,266 @@
+/* COPYRIGHT (c) 2014 Umut Acar, Arthur Chargueraud, and Michael
+ * Rainey
+ * All rights reserved.
+ *
+ * \file bench.cpp
+ * \brief Benchmarking driver for parallel containers
+ *
+ */
+
+#include <functional>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "pcontainer.hpp"
+#include "samplesort.hpp"
+
+/***********************************************************************/
+
+namespace par = pasl::sched::native;
+namespace pcontainer = pasl::data::pcontainer;
+namespace cmdline = pasl::util::cmdline;
+
+/*---------------------------------------------------------------------*/
+/* Benchmark framework */
+
+using thunk_type = std::function<void ()>;
+
+using benchmark_type =
+  std::pair<std::pair<thunk_type,thunk_type>,
+            std::pair<thunk_type, thunk_type>>;
+
+benchmark_type make_benchmark(thunk_type init, thunk_type bench,
+                              thunk_type output, thunk_type destroy) {
+  return std::make_pair(std::make_pair(init, bench),
+                        std::make_pair(output, destroy));
+}
+
+void bench_init(const benchmark_type& b) {
+  b.first.first();
+}
+
+void bench_run(const benchmark_type& b) {
+  b.first.second();
+}
+
+void bench_output(const benchmark_type& b) {
+  b.second.first();
+}
+
+void bench_destroy(const benchmark_type& b) {
+  b.second.second();
+}
+
+/*---------------------------------------------------------------------*/
+/* Workload */
+
+using value_type = long;
+
+static inline value_type gen(long i) {
+  uint64_t x = (uint64_t)i * 0x9E3779B97F4A7C15ull;
+  return (value_type)((x ^ (x >> 29)) & 0xffffffl);
+}
+
+static inline value_type f(value_type x) {
+  return 3 * x + 1;
+}
+
+static inline bool pred(value_type x) {
+  return (x & 1) == 0;
+}
+
+static inline value_type plus(value_type x, value_type y) {
+  return x + y;
+}
+
+using compare_type = std::less<value_type>;
+
+template <class Sequence>
+void check_sorted(const Sequence& seq) {
+  for (long i = 1; i < (long)seq.size(); i++)
+    if (compare_type()(seq[i], seq[i-1]))
+      pasl::util::atomic::die("output is not sorted at index %ld\n", i);
+}
+
+/*---------------------------------------------------------------------*/
+/* Chunked sequence */
+
+using sequence_type = pcontainer::deque<value_type>;
+
+template <class Sequence>
+value_type checksum(const Sequence& seq) {
+  return pcontainer::reduce(seq, 0l, plus) + (value_type)seq.size();
+}
+
+benchmark_type chunkedseq_bench(std::string op, long n) {
+  sequence_type* srcp = new sequence_type;
+  sequence_type* dstp = new sequence_type;
+  value_type* resultp = new value_type;
+  auto init = [=] {
+    if (op != "tabulate")
+      pcontainer::tabulate(n, gen, *srcp);
+  };
+  auto bench = [=] {
+    if (op == "tabulate") {
+      pcontainer::tabulate(n, gen, *dstp);
+    } else if (op == "reduce") {
+      *resultp = pcontainer::reduce(*srcp, 0l, plus);
+    } else if (op == "map") {
+      pcontainer::map(*srcp, *dstp, f);
+    } else if (op == "filter") {
+      pcontainer::filter(*srcp, *dstp, pred);
+    } else if (op == "sort") {
+      pcontainer::sort(*srcp, compare_type());
+      dstp->swap(*srcp);
+    } else {
+      pasl::util::atomic::die("bogus operation %s\n", op.c_str());
+    }
+  };
+  auto output = [=] {
+    if (op == "sort")
+      check_sorted(*dstp);
+    value_type result = (op == "reduce") ? *resultp : checksum(*dstp);
+    std::cout << "result " << result << std::endl;
+  };
+  auto destroy = [=] {
+    delete srcp;
+    delete dstp;
+    delete resultp;
+  };
+  return make_benchmark(init, bench, output, destroy);
+}
+
+/*---------------------------------------------------------------------*/
+/* Baseline: array and parallel-for loops */
+
+using array_type = std::vector<value_type>;
+
+// sums of blocks computed in parallel, then added sequentially
+value_type array_sum(const array_type& xs) {
+  long n = (long)xs.size();
+  long block = std::max(1, par::loop_cutoff);
+  long nb_blocks = (n + block - 1) / block;
+  std::vector<value_type> sums(nb_blocks, 0l);
+  par::parallel_for(0l, nb_blocks, [&] (long b) {
+    long lo = b * block;
+    long hi = std::min(n, lo + block);
+    value_type s = 0l;
+    for (long i = lo; i < hi; i++)
+      s += xs[i];
+    sums[b] = s;
+  });
+  value_type res = 0l;
+  for (long b = 0; b < nb_blocks; b++)
+    res += sums[b];
+  return res;
+}
+
+// two passes over blocks: one to count the selected items of each
+// block, and one to copy them after a prefix sum of the counts
+void array_filter(const array_type& src, array_type& dst) {
+  long n = (long)src.size();
+  long block = std::max(1, par::loop_cutoff);
+  long nb_blocks = (n + block - 1) / block;
+  std::vector<long> offsets(nb_blocks + 1, 0l);
+  par::parallel_for(0l, nb_blocks, [&] (long b) {
+    long lo = b * block;
+    long hi = std::min(n, lo + block);
+    long nb = 0;
+    for (long i = lo; i < hi; i++)
+      if (pred(src[i]))
+        nb++;
+    offsets[b + 1] = nb;
+  });
+  for (long b = 0; b < nb_blocks; b++)
+    offsets[b + 1] += offsets[b];
+  dst.resize(offsets[nb_blocks]);
+  par::parallel_for(0l, nb_blocks, [&] (long b) {
+    long lo = b * block;
+    long hi = std::min(n, lo + block);
+    long j = offsets[b];
+    for (long i = lo; i < hi; i++)
+      if (pred(src[i]))
+        dst[j++] = src[i];
+  });
+}
+
+benchmark_type array_bench(std::string op, long n) {
+  array_type* srcp = new array_type;
+  array_type* dstp = new array_type;
+  value_type* resultp = new value_type;
+  auto init = [=] {
+    if (op != "tabulate") {
+      srcp->resize(n);
+      par::parallel_for(0l, n, [&] (long i) {
+        (*srcp)[i] = gen(i);
+      });
+    }
+  };
+  auto bench = [=] {
+    array_type& src = *srcp;
+    array_type& dst = *dstp;
+    if (op == "tabulate") {
+      dst.resize(n);
+      par::parallel_for(0l, n, [&] (long i) {
+        dst[i] = gen(i);
+      });
+    } else if (op == "reduce") {
+      *resultp = array_sum(src);
+    } else if (op == "map") {
+      dst.resize(n);
+      par::parallel_for(0l, n, [&] (long i) {
+        dst[i] = f(src[i]);
+      });
+    } else if (op == "filter") {
+      array_filter(src, dst);
+    } else if (op == "sort") {
+      pbbs::sampleSort(src.data(), n, compare_type());
+      dst.swap(src);
+    } else {
+      pasl::util::atomic::die("bogus operation %s\n", op.c_str());
+    }
+  };
+  auto output = [=] {
+    if (op == "sort")
+      check_sorted(*dstp);
+    value_type result = (op == "reduce") ? *resultp
+                                         : array_sum(*dstp) + (value_type)dstp->size();
+    std::cout << "result " << result << std::endl;
+  };
+  auto destroy = [=] {
+    delete srcp;
+    delete dstp;
+    delete resultp;
+  };
+  return make_benchmark(init, bench, output, destroy);
+}
+
+/*---------------------------------------------------------------------*/
+/* PASL Driver */
+
+int main(int argc, char** argv) {
+
+  benchmark_type bench;
+
+  auto init = [&] {
+    long n = cmdline::parse_or_default_long("n", 10000000);
+    std::string op = cmdline::parse_or_default_string("bench", "reduce");
+    cmdline::argmap<std::function<benchmark_type()>> m;
+    m.add("chunkedseq", [&] { return chunkedseq_bench(op, n); });
+    m.add("array",      [&] { return array_bench(op, n); });
+    bench = m.find_by_arg_or_default_key("structure", "chunkedseq")();
+    bench_init(bench);
+  };
+  auto run = [&] (bool) {
+    bench_run(bench);
+  };
+  auto output = [&] {
+    bench_output(bench);
+  };
+  auto destroy = [&] {
+    bench_destroy(bench);
+  };
+  pasl::sched::launch(argc, argv, init, run, output, destroy);
+}
+
+/***********************************************************************/
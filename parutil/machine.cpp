@@ -9,7 +9,12 @@
 #include <sys/sysctl.h>
 #endif
 #include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <vector>
+#ifdef USE_LIBNUMA
+#include <numa.h>
+#endif
 
 #include "machine.hpp"
 #include "worker.hpp"
@@ -142,7 +147,7 @@ void init(hyperthreading_mode_t _htmode) {
   struct cpuinfo_t cpuinfo = mine_cpuinfo ();
   cache_line_szb = cpuinfo.cache_line_szb;
   cpu_frequency_ghz = (double)(cpuinfo.cpu_frequency_mhz / 1000.0);
-  ticks::set_ticks_per_seconds(cpuinfo.cpu_frequency_mhz * 1000000.);
+  ticks::init();
 
 #ifdef HAVE_HWLOC
   hwloc_topology_init (&topology);
@@ -458,14 +463,17 @@ void numa::init(int nb_workers) {
   for (machine::node_id_t node = 0; node < nb_nodes; node++)
     for (int i = 0; i < (int)node_info[node].size(); i++)
       assert(rank_of_worker(worker_of_rank(node, i)) == i);
+  initialized = true;
 }
 
 numa::numa() {
   this->bpol = &the_bindpolicy;
+  initialized = false;
 }
 
 numa::numa(binding_policy_p bpol) {
   this->bpol = bpol;
+  initialized = false;
 }
 
 numa::~numa() {
@@ -508,6 +516,51 @@ worker_id_t numa::set_leader_of_node(node_id_t node, worker_id_t id) {
 
 numa the_numa;
 
+/*---------------------------------------------------------------------*/
+
+static size_t round_up_to_pages(size_t szb) {
+  size_t page_szb = (size_t)sysconf(_SC_PAGESIZE);
+  return ((szb + page_szb - 1) / page_szb) * page_szb;
+}
+
+void* alloc_on_node(size_t szb, node_id_t node) {
+  szb = round_up_to_pages(szb);
+  void* p = NULL;
+#if defined(HAVE_HWLOC)
+  if (node != node_undef) {
+    hwloc_nodeset_t nodeset = hwloc_bitmap_alloc();
+    hwloc_bitmap_only(nodeset, (unsigned)node);
+    p = hwloc_alloc_membind_nodeset(topology, szb, nodeset, HWLOC_MEMBIND_BIND, 0);
+    hwloc_bitmap_free(nodeset);
+  }
+  if (p == NULL)
+    p = hwloc_alloc(topology, szb);
+#elif defined(USE_LIBNUMA)
+  if (node != node_undef && numa_available() != -1)
+    p = numa_alloc_onnode(szb, node);
+  else
+    p = numa_alloc(szb);
+#else
+  p = mmap(NULL, szb, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED)
+    p = NULL;
+#endif
+  if (p == NULL)
+    atomic::die("alloc_on_node: failed to allocate %lu bytes\n", (unsigned long)szb);
+  return p;
+}
+
+void free_on_node(void* p, size_t szb) {
+  szb = round_up_to_pages(szb);
+#if defined(HAVE_HWLOC)
+  hwloc_free(topology, p, szb);
+#elif defined(USE_LIBNUMA)
+  numa_free(p, szb);
+#else
+  munmap(p, szb);
+#endif
+}
+
 /***********************************************************************/
 
 } // end namespace
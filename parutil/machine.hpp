@@ -129,6 +129,7 @@ const node_id_t node_undef = -1;
 class numa {
 private:
   binding_policy_p bpol;
+  bool initialized;
   int nb_nodes;
   //! \todo use std::vector instead of arrays
   node_id_t* nodes;
@@ -145,6 +146,10 @@ public:
   numa(binding_policy_p bpol);
   ~numa();
   void init(int nb_workers);
+  //! Returns true if `init()` has been called
+  bool is_initialized() const {
+    return initialized;
+  }
   //! Returns the number of nodes that are allocated to workers
   int get_nb_nodes();
   /*! \brief Returns one of multiple nodes to which the given worker
@@ -181,6 +186,25 @@ public:
   
 extern numa the_numa;
 
+/*---------------------------------------------------------------------*/
+/* NUMA-aware allocation */
+
+/*! \brief Allocates a block of at least `szb` bytes whose pages are
+ *  placed on NUMA node `node`.
+ *
+ * The block is page aligned and its size is rounded up to a whole
+ * number of pages, so that no two blocks share a page.
+ *
+ * If `node` is `node_undef`, or if the binary is built without hwloc
+ * and without libnuma, the pages are not touched by this function and
+ * are therefore placed by the OS on the node of the first thread that
+ * writes to them.
+ */
+void* alloc_on_node(size_t szb, node_id_t node);
+  
+//! Releases a block allocated by `alloc_on_node(szb, ...)`
+void free_on_node(void* p, size_t szb);
+
 /***********************************************************************/
 
 } // namespace
@@ -2,13 +2,15 @@
  * Rainey
  * All rights reserved.
  *
- * Producer-consumer buffers (built on top of linked lists)
+ * Producer-consumer buffers
  *
  */
 
 #ifndef _PCB_H_
 #define _PCB_H_
 
+#include <assert.h>
+#include <stdint.h>
 #include <atomic>
 
 namespace pasl {
@@ -58,7 +60,7 @@ class linked : public pcb::signature<Item> {
   
 private:
   struct item_s {
-    std::atomic<Item> msg;
+    Item msg;
     std::atomic<struct item_s*> next;
   };
   
@@ -97,28 +99,22 @@ public:
   }
 
   bool empty() {
-    return head->next == NULL;
+    return head->next.load(std::memory_order_acquire) == NULL;
   }
   
   void push(Item m) {
-    assert(false);
-    /*
     item_p item = item_create();
-    tail->msg.store(m);
-    // need store-store barrier
-    tail->next.store(item);
+    tail->msg = m;
+    tail->next.store(item, std::memory_order_release);
     tail = item;
-    */
   }
   
   void pop(Item& m) {
-    /*
-   assert(! empty());
-    m = head->msg.load();
+    assert(! empty());
+    m = head->msg;
     item_p tmp = head;
-    head = head->next.load();
+    head = head->next.load(std::memory_order_acquire);
     delete tmp;
-    */
   }
   
   bool try_pop(Item& m) {
@@ -131,6 +127,124 @@ public:
   }
 };
   
+
+/*---------------------------------------------------------------------*/
+/**
+ * \class ring
+ * \ingroup pcb
+ * \brief Bounded PCB implemented with a ring buffer
+ * \tparam Item type of the items
+ * \tparam capacity maximum number of items stored by the buffer; must
+ * be a power of two
+ *
+ * Unlike `linked`, this buffer admits multiple concurrent producers,
+ * so that a single buffer can collect the items sent to one consumer
+ * by all other threads, and it performs no allocation after `init()`.
+ *
+ * Each cell carries a sequence number that tells whether the cell is
+ * ready to be written by the producer that claims the position, or
+ * ready to be read by the consumer. Producers claim positions by a
+ * compare-and-swap on the tail index; the consumer owns the head
+ * index and needs no atomic read-modify-write operation.
+ *
+ * When the buffer is full, `try_push` returns false; it is up to the
+ * producer to apply backpressure, for instance by doing other work
+ * before trying again.
+ */
+template <typename Item, int capacity = 256>
+class ring : public pcb::signature<Item> {
+  
+  static_assert((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+  
+private:
+  
+  static constexpr uint64_t mask = capacity - 1;
+  
+  struct cell_s {
+    std::atomic<uint64_t> seq;
+    Item msg;
+  };
+  
+  typedef struct cell_s cell_t;
+  
+  cell_t* cells;
+  __attribute__ ((aligned (64))) std::atomic<uint64_t> tail;
+  __attribute__ ((aligned (64))) uint64_t head;
+  
+public:
+  
+  ring() : cells(NULL) { }
+  
+  ring(const ring& src) : cells(NULL) {
+    init();
+  }
+  
+  void init() {
+    cells = new cell_t[capacity];
+    for (uint64_t i = 0; i < capacity; i++)
+      cells[i].seq.store(i, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+    head = 0;
+  }
+  
+  void destroy() {
+    delete [] cells;
+    cells = NULL;
+  }
+  
+  bool empty() {
+    cell_t& cell = cells[head & mask];
+    return cell.seq.load(std::memory_order_acquire) != head + 1;
+  }
+  
+  /*! \brief Tries to push item `m` on the PCB
+   *  \return false if the buffer is full and true otherwise
+   */
+  bool try_push(const Item& m) {
+    uint64_t pos = tail.load(std::memory_order_relaxed);
+    cell_t* cell;
+    while (true) {
+      cell = &cells[pos & mask];
+      uint64_t seq = cell->seq.load(std::memory_order_acquire);
+      int64_t diff = (int64_t)seq - (int64_t)pos;
+      if (diff == 0) {
+        if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail.load(std::memory_order_relaxed);
+      }
+    }
+    cell->msg = m;
+    cell->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+  
+  //! Pushes item `m` on the PCB, spinning as long as the buffer is full
+  void push(Item m) {
+    while (! try_push(m)) { }
+  }
+  
+  void pop(Item& m) {
+    assert(! empty());
+    cell_t& cell = cells[head & mask];
+    m = cell.msg;
+    cell.seq.store(head + capacity, std::memory_order_release);
+    head++;
+  }
+  
+  bool try_pop(Item& m) {
+    if (empty()) {
+      return false;
+    } else {
+      pop(m);
+      return true;
+    }
+  }
+  
+};
+  
   
 /***********************************************************************/
   
@@ -7,12 +7,17 @@
  *
  */
 
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "native.hpp"
 #include "container.hpp"
 #include "chunkedseq.hpp"
 #include "chunkedbag.hpp"
+#include "orderedmap.hpp"
+#include "rope.hpp"
+#include "compressedseq.hpp"
 
 #ifndef _PASL_PCONTAINER_H_
 #define _PASL_PCONTAINER_H_
@@ -40,6 +45,39 @@ using stack = chunkedseq::bootstrapped::stack<Item, chunk_capacity>;
 template <class Item>
 using bag = chunkedseq::bootstrapped::bagopt<Item, chunk_capacity>;
 
+//! Deque whose chunk capacity is read at run time from chunkedseq::chunkcapacity
+template <class Item>
+using tunable_deque = chunkedseq::bootstrapped::tunable_deque<Item>;
+
+//! Deque of integers whose inner chunks are compressed by `Codec`
+template <class Item, class Codec = chunkedseq::compressed::delta_varint<Item>>
+using compressed_deque = chunkedseq::compressed::deque<Item, chunk_capacity, Codec>;
+
+/*! \brief Deque whose chunks cache the total weight of their items, as
+ *  given by `Weight_fct` (see the loops by weight below)
+ */
+template <class Item, class Weight_fct, class Weight = long>
+using weighted_deque =
+  chunkedseq::bootstrapped::deque<Item, chunk_capacity,
+                                  cachedmeasure::weight<Item, Weight, size_t, Weight_fct>>;
+
+//! Runs the two branches of bulk operations on ordered containers in parallel
+class native_fork2 {
+public:
+  template <class Body1, class Body2>
+  static void fork2(const Body1& b1, const Body2& b2) {
+    native::fork2(b1, b2);
+  }
+};
+
+template <class Key, class Compare = std::less<Key>>
+using ordered_set = chunkedseq::ordered::set<Key, Compare, 128, native_fork2>;
+
+template <class Key, class Item, class Compare = std::less<Key>>
+using ordered_map = chunkedseq::ordered::map<Key, Item, Compare, 128, native_fork2>;
+
+using rope = chunkedseq::rope<4096, native_fork2>;
+
 //--------------------------
 // for benchmarking purposes
   
@@ -91,7 +129,7 @@ void for_each(const Container& cont, const Body& body) {
   using value_type = typename Container::value_type;
   using segment_type = typename Container::segment_type;
   for_each_segment(cont, [&] (value_type* lo, value_type* hi) {
-    for (value_type* p = lo; lo < hi; p++)
+    for (value_type* p = lo; p < hi; p++)
       body(*p);
   });
 }
@@ -110,6 +148,414 @@ void combine(Number lo, Number hi, Container& dst, const Body& body,
   native::combine(lo, hi, dst, join, body, cutoff);
 }
 
+/*---------------------------------------------------------------------*/
+/* Parallel bulk operations */
+
+/* The operations below divide the input range in halves until the
+ * cutoff is reached. Each split point is found by a search on the
+ * item count, which is a cached measurement of the chunks and of the
+ * middle sequence, so that both halves have the same number of items
+ * and a split costs logarithmic time. Output containers built by the
+ * two halves are joined by `concat`.
+ */
+
+template <class Container, class Output, class Join_output, class Set_out_env, class Body>
+void forkjoin_segments(const Container& cont, Output& out, const Join_output& join,
+                       const Set_out_env& set_out_env, const Body& body,
+                       int cutoff = native::loop_cutoff) {
+  using size_type = typename Container::size_type;
+  using iterator_type = typename Container::iterator;
+  using input_type = std::pair<iterator_type, iterator_type>;
+  auto cutoff_fct = [cutoff] (const input_type& in) {
+    return in.second.size() - in.first.size() <= size_type(cutoff);
+  };
+  auto split = [] (input_type& src, input_type& dst) {
+    size_type half = (src.second.size() - src.first.size()) / 2;
+    iterator_type mid = src.first + half;
+    dst.first = mid;
+    dst.second = src.second;
+    src.second = mid;
+  };
+  auto _body = [&] (input_type& in, Output& out) {
+    cont.for_each_segment(in.first, in.second, [&] (typename Container::value_type* lo,
+                                                    typename Container::value_type* hi) {
+      body(lo, hi, out);
+    });
+  };
+  auto set_in_env = [] (input_type&) { };
+  input_type in(cont.begin(), cont.end());
+  native::forkjoin(in, out, cutoff_fct, split, join, set_in_env, set_out_env, _body);
+}
+
+template <class Container, class Output, class Join_output, class Body>
+void forkjoin_segments(const Container& cont, Output& out,
+                       const Join_output& join, const Body& body) {
+  auto set_out_env = [] (Output&) { };
+  forkjoin_segments(cont, out, join, set_out_env, body);
+}
+
+/*---------------------------------------------------------------------*/
+/* Parallel loops balanced by weight */
+
+/* The loops below apply to containers whose cached measure is the
+ * weight of the items (see cachedmeasure::weight), such as
+ * weighted_deque, where the weight of an item is an estimate of the
+ * work it takes to process it (e.g., the out-degree of a vertex). The
+ * input range is divided where the running weight reaches the middle
+ * of the weight of the range, so that both halves carry the same
+ * amount of work even when the cost per item is irregular. Each split
+ * point is found by a search on the cached weights, in logarithmic
+ * time. A range is processed sequentially once its weight is at most
+ * the cutoff, or once it holds a single item, which cannot be divided
+ * further. Weights must be nonnegative.
+ */
+
+namespace weightedimpl {
+
+/* A range holds the items from `beg` to `end`. Except at the ends of
+ * the container, the bounds are found by searching for the first item
+ * whose running weight (including the item itself) exceeds `lo` and
+ * `hi`, respectively, so that items of weight zero go along with the
+ * next item of nonzero weight.
+ */
+template <class Iterator, class Weight>
+class range {
+public:
+  Iterator beg;
+  Iterator end;
+  Weight lo;
+  Weight hi;
+};
+
+} // end namespace
+
+template <class Container, class Output, class Join_output, class Set_out_env, class Body>
+void forkjoin_segments_by_weight(const Container& cont, Output& out, const Join_output& join,
+                                 const Set_out_env& set_out_env, const Body& body,
+                                 typename Container::measured_type cutoff = native::loop_cutoff) {
+  using size_type = typename Container::size_type;
+  using weight_type = typename Container::measured_type;
+  using iterator_type = typename Container::iterator;
+  using input_type = weightedimpl::range<iterator_type, weight_type>;
+  // below a weight of two, a split could leave one of the halves unchanged
+  weight_type w_cutoff = std::max(cutoff, weight_type(1));
+  auto cutoff_fct = [w_cutoff] (const input_type& in) {
+    return in.hi - in.lo <= w_cutoff
+        || in.end.size() - in.beg.size() <= size_type(1);
+  };
+  auto split = [&] (input_type& src, input_type& dst) {
+    weight_type mid_weight = src.lo + (src.hi - src.lo) / 2;
+    iterator_type mid = cont.begin();
+    mid.search_by([mid_weight] (weight_type w) { return w > mid_weight; });
+    dst.beg = mid;
+    dst.end = src.end;
+    dst.lo = mid_weight;
+    dst.hi = src.hi;
+    src.end = mid;
+    src.hi = mid_weight;
+  };
+  auto _body = [&] (input_type& in, Output& out) {
+    cont.for_each_segment(in.beg, in.end, [&] (typename Container::value_type* lo,
+                                               typename Container::value_type* hi) {
+      body(lo, hi, out);
+    });
+  };
+  auto set_in_env = [] (input_type&) { };
+  input_type in;
+  in.beg = cont.begin();
+  in.end = cont.end();
+  in.lo = weight_type(0);
+  in.hi = cont.get_cached();
+  native::forkjoin(in, out, cutoff_fct, split, join, set_in_env, set_out_env, _body);
+}
+
+template <class Container, class Output, class Join_output, class Body>
+void forkjoin_segments_by_weight(const Container& cont, Output& out,
+                                 const Join_output& join, const Body& body) {
+  auto set_out_env = [] (Output&) { };
+  forkjoin_segments_by_weight(cont, out, join, set_out_env, body);
+}
+
+/*! \brief Applies `body` to the segments of `cont`, in parallel, where
+ *  the segments processed by each task have about `cutoff` in weight
+ */
+template <class Container, class Body>
+void for_each_segment_by_weight(const Container& cont, const Body& body,
+                                typename Container::measured_type cutoff = native::loop_cutoff) {
+  using value_type = typename Container::value_type;
+  struct { } dummy;
+  using dummy_type = typeof(dummy);
+  auto join = [] (dummy_type&, dummy_type&) { };
+  auto set_out_env = [] (dummy_type&) { };
+  forkjoin_segments_by_weight(cont, dummy, join, set_out_env,
+                              [&] (value_type* lo, value_type* hi, dummy_type&) {
+    body(lo, hi);
+  }, cutoff);
+}
+
+//! \brief Applies `body` to the items of `cont`, in parallel, balanced by weight
+template <class Container, class Body>
+void for_each_by_weight(const Container& cont, const Body& body,
+                        typename Container::measured_type cutoff = native::loop_cutoff) {
+  using value_type = typename Container::value_type;
+  for_each_segment_by_weight(cont, [&] (value_type* lo, value_type* hi) {
+    for (value_type* p = lo; p < hi; p++)
+      body(*p);
+  }, cutoff);
+}
+
+/*! \brief Appends to `dst` the items `gen(0), ..., gen(n-1)`
+ *
+ * Each leaf of the computation fills a container of its own, and the
+ * containers are joined by `concat`.
+ */
+template <class Container, class Generator>
+void tabulate(typename Container::size_type n, const Generator& gen, Container& dst,
+              int cutoff = sched::native::loop_cutoff) {
+  using size_type = typename Container::size_type;
+  Container res;
+  combine(size_type(0), n, res, [&] (size_type i, Container& c) {
+    c.push_back(gen(i));
+  }, cutoff);
+  dst.concat(res);
+}
+
+/*! \brief Combines, using the associative operator `comb`, the values
+ *  `lift(x)` for all items `x` of `cont`
+ *
+ * The value `id` must be an identity for `comb`.
+ */
+template <class Container, class Result, class Combine, class Lift>
+Result reduce(const Container& cont, const Result& id,
+              const Combine& comb, const Lift& lift) {
+  using value_type = typename Container::value_type;
+  Result res = id;
+  auto join = [&] (Result& r1, Result& r2) {
+    r1 = comb(r1, r2);
+  };
+  auto set_out_env = [&] (Result& r) {
+    r = id;
+  };
+  auto body = [&] (value_type* lo, value_type* hi, Result& r) {
+    for (value_type* p = lo; p < hi; p++)
+      r = comb(r, lift(*p));
+  };
+  forkjoin_segments(cont, res, join, set_out_env, body);
+  return res;
+}
+
+template <class Container, class Combine>
+typename Container::value_type reduce(const Container& cont,
+                                      const typename Container::value_type& id,
+                                      const Combine& comb) {
+  using value_type = typename Container::value_type;
+  return reduce(cont, id, comb, [] (const value_type& x) { return x; });
+}
+
+/*! \brief Appends to `dst` the items `f(x)` for all items `x` of `src`,
+ *  in order
+ *
+ * The output is collected by a reducer (see reducer.hpp), so that a
+ * new container is created only for a branch that is stolen.
+ */
+template <class Container_src, class Container_dst, class Function>
+void map(const Container_src& src, Container_dst& dst, const Function& f) {
+  using value_type = typename Container_src::value_type;
+  native::reducer<native::concat_monoid<Container_dst>> res;
+  for_each_segment(src, [&] (value_type* lo, value_type* hi) {
+    Container_dst& c = res.view();
+    for (value_type* p = lo; p < hi; p++)
+      c.push_back(f(*p));
+  });
+  dst.concat(res.get_value());
+}
+
+/*! \brief Appends to `dst` the items `x` of `src` that satisfy `pred`,
+ *  in order
+ *
+ * The output is collected as by `map`.
+ */
+template <class Container_src, class Container_dst, class Predicate>
+void filter(const Container_src& src, Container_dst& dst, const Predicate& pred) {
+  using value_type = typename Container_src::value_type;
+  native::reducer<native::concat_monoid<Container_dst>> res;
+  for_each_segment(src, [&] (value_type* lo, value_type* hi) {
+    Container_dst& c = res.view();
+    for (value_type* p = lo; p < hi; p++)
+      if (pred(*p))
+        c.push_back(*p);
+  });
+  dst.concat(res.get_value());
+}
+
+/*---------------------------------------------------------------------*/
+/* Parallel sort and merge */
+
+/* Sorting is a parallel mergesort. Containers are halved by `split`
+ * down to the cutoff, the halves are sorted in parallel, and the
+ * results are merged by a parallel merge that also proceeds by
+ * `split`: the middle item of the larger input is taken as a pivot,
+ * the position of the pivot in the other input is found by binary
+ * search, and the two pairs of pieces are merged in parallel before
+ * being joined by `concat`. No flat temporary of the size of the
+ * input is ever allocated; only the leaves copy their items, at most
+ * `cutoff` of them, into a local buffer.
+ *
+ * All merges are stable: among equivalent items, the items of the
+ * first input come first.
+ */
+
+namespace sortimpl {
+
+template <class Container, class Compare>
+typename Container::size_type lower_bound(const Container& c,
+                                          const typename Container::value_type& x,
+                                          const Compare& cmp) {
+  using size_type = typename Container::size_type;
+  size_type lo = 0;
+  size_type hi = c.size();
+  while (lo < hi) {
+    size_type mid = lo + (hi - lo) / 2;
+    if (cmp(c[mid], x))
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+template <class Container, class Compare>
+typename Container::size_type upper_bound(const Container& c,
+                                          const typename Container::value_type& x,
+                                          const Compare& cmp) {
+  using size_type = typename Container::size_type;
+  size_type lo = 0;
+  size_type hi = c.size();
+  while (lo < hi) {
+    size_type mid = lo + (hi - lo) / 2;
+    if (cmp(x, c[mid]))
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  return lo;
+}
+
+template <class Container, class Compare>
+void merge_seq(Container& src1, Container& src2, Container& dst, const Compare& cmp) {
+  using value_type = typename Container::value_type;
+  size_t n1 = src1.size();
+  size_t n2 = src2.size();
+  std::vector<value_type> buf1(n1);
+  std::vector<value_type> buf2(n2);
+  std::vector<value_type> res(n1 + n2);
+  src1.popn_back(buf1.data(), n1);
+  src2.popn_back(buf2.data(), n2);
+  std::merge(buf1.begin(), buf1.end(), buf2.begin(), buf2.end(), res.begin(), cmp);
+  dst.pushn_back(res.data(), n1 + n2);
+}
+
+template <class Container, class Compare>
+void merge_rec(Container& src1, Container& src2, Container& dst,
+               const Compare& cmp, int cutoff) {
+  using size_type = typename Container::size_type;
+  using value_type = typename Container::value_type;
+  size_type n1 = src1.size();
+  size_type n2 = src2.size();
+  if (n1 == 0) {
+    dst.concat(src2);
+    return;
+  }
+  if (n2 == 0) {
+    dst.concat(src1);
+    return;
+  }
+  // below two items, the pivot would leave one side empty
+  if (n1 + n2 <= std::max(size_type(cutoff), size_type(2))) {
+    merge_seq(src1, src2, dst, cmp);
+    return;
+  }
+  Container src1_hi;
+  Container src2_hi;
+  if (n1 >= n2) {
+    // items of src2 equivalent to the pivot go after it
+    size_type m = n1 / 2;
+    value_type pivot = src1[m];
+    src1.split(m, src1_hi);
+    size_type k = lower_bound(src2, pivot, cmp);
+    if (k < n2)
+      src2.split(k, src2_hi);
+  } else {
+    // items of src1 equivalent to the pivot go before it
+    size_type m = n2 / 2;
+    value_type pivot = src2[m];
+    src2.split(m, src2_hi);
+    size_type k = upper_bound(src1, pivot, cmp);
+    if (k < n1)
+      src1.split(k, src1_hi);
+  }
+  Container dst_hi;
+  native::fork2([&] { merge_rec(src1, src2, dst, cmp, cutoff); },
+                [&] { merge_rec(src1_hi, src2_hi, dst_hi, cmp, cutoff); });
+  dst.concat(dst_hi);
+}
+
+template <class Container, class Compare, class Sort_leaf>
+void sort_rec(Container& seq, const Compare& cmp, const Sort_leaf& sort_leaf, int cutoff) {
+  using size_type = typename Container::size_type;
+  using value_type = typename Container::value_type;
+  size_type n = seq.size();
+  if (n <= std::max(size_type(cutoff), size_type(1))) {
+    std::vector<value_type> buf(n);
+    seq.popn_back(buf.data(), n);
+    sort_leaf(buf.begin(), buf.end(), cmp);
+    seq.pushn_back(buf.data(), n);
+    return;
+  }
+  Container seq_hi;
+  seq.split(n / 2, seq_hi);
+  native::fork2([&] { sort_rec(seq, cmp, sort_leaf, cutoff); },
+                [&] { sort_rec(seq_hi, cmp, sort_leaf, cutoff); });
+  Container res;
+  merge_rec(seq, seq_hi, res, cmp, cutoff);
+  seq.concat(res);
+}
+
+} // end namespace
+
+/*! \brief Appends to `dst` the result of merging the sorted
+ *  containers `src1` and `src2`, leaving both of them empty
+ *
+ * The merge is stable.
+ */
+template <class Container, class Compare>
+void merge(Container& src1, Container& src2, Container& dst, const Compare& cmp,
+           int cutoff = native::loop_cutoff) {
+  sortimpl::merge_rec(src1, src2, dst, cmp, cutoff);
+}
+
+//! \brief Sorts the items of `seq` in place, with respect to `cmp`
+template <class Container, class Compare>
+void sort(Container& seq, const Compare& cmp, int cutoff = native::loop_cutoff) {
+  using iterator = typename std::vector<typename Container::value_type>::iterator;
+  sortimpl::sort_rec(seq, cmp, [] (iterator lo, iterator hi, const Compare& cmp) {
+    std::sort(lo, hi, cmp);
+  }, cutoff);
+}
+
+/*! \brief Sorts the items of `seq` in place, with respect to `cmp`,
+ *  preserving the order of equivalent items
+ */
+template <class Container, class Compare>
+void stable_sort(Container& seq, const Compare& cmp, int cutoff = native::loop_cutoff) {
+  using iterator = typename std::vector<typename Container::value_type>::iterator;
+  sortimpl::sort_rec(seq, cmp, [] (iterator lo, iterator hi, const Compare& cmp) {
+    std::stable_sort(lo, hi, cmp);
+  }, cutoff);
+}
+
+/*---------------------------------------------------------------------*/
+
 template <class Container_src, class Pointer>
 void transfer_contents_to_array(Container_src& src, Pointer dst) {
   using size_type = typename Container_src::size_type;
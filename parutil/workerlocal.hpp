@@ -11,6 +11,8 @@
 #define _PASL_DATA_PERWORKER_H_
 
 #include <assert.h>
+#include <atomic>
+#include <new>
 #include <initializer_list>
 
 #include "callback.hpp"
@@ -167,6 +169,185 @@ public:
   
 };
   
+/*---------------------------------------------------------------------*/
+/*! \class numa_array
+ *  \brief Array indexed by worker id whose cells are placed on the
+ *  NUMA nodes of their workers
+ *  \tparam Item type of the items to be stored in the container
+ *  \tparam max_nb_workers one plus the highest worker id to be
+ *  addressed by the container
+ *  \ingroup data
+ *  \ingroup perworker
+ *
+ * This container has the same interface as `array`, but, instead of
+ * storing all cells in one contiguous block, it stores each cell in a
+ * separate block of whole pages. The block of the cell at position
+ * `id` is allocated on the first access to that cell and is placed on
+ * the NUMA node of the worker `id`, as reported by
+ * `util::machine::the_numa`.
+ *
+ * If the NUMA information is not yet available, or if the binary is
+ * built without hwloc and without libnuma, the placement falls back to
+ * first touch: the pages of the cell land on the node of the thread
+ * that first accesses the cell, typically its own worker.
+ *
+ * Because cells never share a page, no padding is needed to avoid
+ * false sharing. The price is one page per accessed cell.
+ *
+ * Access to this container is not synchronized, except for the
+ * allocation of the cells, which is thread safe.
+ *
+ */
+template <class Item,
+          int max_nb_workers = default_max_nb_workers>
+class numa_array {
+public:
+  
+  using value_type = Item;
+  using index_type = worker_id_t;
+  
+private:
+  
+  std::atomic<value_type*> cells[max_nb_workers];
+  
+  void check_index(index_type id) const {
+    assert(id >= 0);
+    assert(id <= max_nb_workers);
+    util::worker::the_group.check_worker_id(worker_id_t(id));
+  }
+  
+  static util::machine::node_id_t node_of(index_type id) {
+    if (! util::machine::the_numa.is_initialized())
+      return util::machine::node_undef;
+    return util::machine::the_numa.node_of_worker(id);
+  }
+  
+  value_type* create_cell(index_type id) {
+    void* p = util::machine::alloc_on_node(sizeof(value_type), node_of(id));
+    value_type* c = new (p) value_type();
+    value_type* orig = nullptr;
+    if (cells[id].compare_exchange_strong(orig, c))
+      return c;
+    // another thread has already created the cell
+    c->~value_type();
+    util::machine::free_on_node(p, sizeof(value_type));
+    return orig;
+  }
+  
+  value_type& cell_of(index_type id) {
+    value_type* c = cells[id].load(std::memory_order_acquire);
+    if (c == nullptr)
+      c = create_cell(id);
+    return *c;
+  }
+  
+public:
+  
+  numa_array() {
+    for (int i = 0; i < max_nb_workers; i++)
+      cells[i].store(nullptr, std::memory_order_relaxed);
+  }
+  
+  numa_array(std::initializer_list<value_type> l)
+  : numa_array() {
+    if (l.size() != 1)
+      util::atomic::fatal([] { std::cout << "perworker given bogus initializer list"; });
+    init(*(l.begin()));
+  }
+  
+  numa_array(const numa_array&) = delete;
+  numa_array& operator=(const numa_array&) = delete;
+  
+  ~numa_array() {
+    for (int i = 0; i < max_nb_workers; i++) {
+      value_type* c = cells[i].load();
+      if (c == nullptr)
+        continue;
+      c->~value_type();
+      util::machine::free_on_node(c, sizeof(value_type));
+    }
+  }
+  
+  //! \brief Returns reference to the contents of the cell at position `id` in the array
+  value_type& operator[](const index_type id) {
+    check_index(id);
+    return cell_of(id);
+  }
+  
+  //! \brief Returns reference to the contents of the cell at position `id` in the array
+  value_type& operator[](const int id) {
+    return operator[](index_type(id));
+  }
+  
+  //! \brief Returns a reference to the cell of the calling worker thread
+  value_type& mine() {
+    return mine(util::worker::get_my_id());
+  }
+  
+  /*! \brief Returns a reference to the cell of the calling worker thread
+   *
+   * \pre `my_id` equals the id of the calling worker thread
+   */
+  value_type& mine(worker_id_t my_id) {
+    assert(my_id == util::worker::get_my_id());
+    return operator[](my_id);
+  }
+  
+  //! \brief Applies `body[operator[](i)]` for each `i` in [0, ... nb_workers-1]`
+  template <class Body>
+  void for_each(const Body& body) {
+    auto b = [&] (index_type id) {
+      body(id, (*this)[id]);
+    };
+    util::worker::the_group.for_each_worker(b);
+  }
+  
+  //! \brief Same as `for_each`, except with const access to cells of the array
+  template <class Body>
+  void cfor_each(const Body& body) const {
+    numa_array& self = const_cast<numa_array&>(*this);
+    auto b = [&] (index_type id) {
+      const value_type& v = self[id];
+      body(id, v);
+    };
+    util::worker::the_group.for_each_worker(b);
+  }
+  
+  //! \brief Same as `array::combine`
+  template <class Combiner>
+  value_type combine(value_type identity, const Combiner& comb) const {
+    value_type res = identity;
+    cfor_each([&] (index_type id, value_type v) {
+      res = comb(res, v);
+    });
+    return res;
+  }
+  
+  //! \brief Writes given value into each cell of the array
+  void init(const value_type& v) {
+    for_each([&] (index_type, value_type& dst) {
+      dst = v;
+    });
+  }
+  
+};
+
+/*---------------------------------------------------------------------*/
+/*! \brief Per-worker array for hot scheduler state
+ *
+ * Builds that define `USE_PERWORKER_NUMA` place each cell on the
+ * NUMA node of its worker (see `numa_array`); other builds use the
+ * contiguous padded layout of `array`.
+ *
+ */
+#ifdef USE_PERWORKER_NUMA
+template <class Item>
+using local_array = numa_array<Item>;
+#else
+template <class Item>
+using local_array = array<Item>;
+#endif
+  
 /*---------------------------------------------------------------------*/
 /*! \class with_undefined
  *  \brief Per-worker array that can index the undefined worker id
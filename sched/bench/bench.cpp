@@ -0,0 +1,309 @@
+/* COPYRIGHT (c) 2014 Umut Acar, Arthur Chargueraud, and Michael
+ * Rainey
+ * All rights reserved.
+ *
+ * \file bench.cpp
+ * \brief Benchmarking driver for scheduler internals
+ *
+ */
+
+#include <thread>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "workerlocal.hpp"
+#include "pcb.hpp"
+
+/***********************************************************************/
+
+namespace par = pasl::sched::native;
+namespace perworker = pasl::data::perworker;
+namespace cmdline = pasl::util::cmdline;
+
+using worker_id_t = pasl::worker_id_t;
+
+/*---------------------------------------------------------------------*/
+/* Benchmark framework */
+
+using thunk_type = std::function<void ()>;
+
+using benchmark_type =
+  std::pair<std::pair<thunk_type,thunk_type>,
+            std::pair<thunk_type, thunk_type>>;
+
+benchmark_type make_benchmark(thunk_type init, thunk_type bench,
+                              thunk_type output, thunk_type destroy) {
+  return std::make_pair(std::make_pair(init, bench),
+                        std::make_pair(output, destroy));
+}
+
+void bench_init(const benchmark_type& b) {
+  b.first.first();
+}
+
+void bench_run(const benchmark_type& b) {
+  b.first.second();
+}
+
+void bench_output(const benchmark_type& b) {
+  b.second.first();
+}
+
+void bench_destroy(const benchmark_type& b) {
+  b.second.second();
+}
+
+/*---------------------------------------------------------------------*/
+/* Per-worker storage */
+
+// Mimics the access pattern of scheduler state: each worker makes
+// many updates to its own cell and, once in a while, polls the cell
+// of another worker, as a thief does.
+class perworker_cell_type {
+public:
+  long nb_updates = 0;
+  long nb_polls = 0;
+  long polled = 0;
+};
+
+template <class Array>
+benchmark_type perworker_bench() {
+  long n = cmdline::parse_or_default_long("n", 100000000);
+  long poll_period = cmdline::parse_or_default_long("poll_period", 64);
+  Array* cellsp = new Array;
+  long* resultp = new long;
+  auto init = [=] {
+    cellsp->init(perworker_cell_type());
+  };
+  auto bench = [=] {
+    Array& cells = *cellsp;
+    int nb_workers = pasl::util::worker::get_nb();
+    par::parallel_for(0l, n, [&] (long i) {
+      perworker_cell_type& c = cells.mine();
+      c.nb_updates++;
+      if (i % poll_period == 0 && nb_workers > 1) {
+        worker_id_t other = (pasl::util::worker::get_my_id() + 1) % nb_workers;
+        c.polled += cells[other].nb_updates;
+        c.nb_polls++;
+      }
+    });
+    long nb_updates = 0;
+    cells.for_each([&] (worker_id_t, perworker_cell_type& c) {
+      nb_updates += c.nb_updates;
+    });
+    *resultp = nb_updates;
+  };
+  auto output = [=] {
+    std::cout << "result " << *resultp << std::endl;
+  };
+  auto destroy = [=] {
+    delete cellsp;
+    delete resultp;
+  };
+  return make_benchmark(init, bench, output, destroy);
+}
+
+benchmark_type perworker_bench() {
+  cmdline::argmap<std::function<benchmark_type()>> m;
+  m.add("contiguous", [&] { return perworker_bench<perworker::array<perworker_cell_type>>(); });
+  m.add("numa",       [&] { return perworker_bench<perworker::numa_array<perworker_cell_type>>(); });
+  return m.find_by_arg_or_default_key("layout", "contiguous")();
+}
+
+/*---------------------------------------------------------------------*/
+/* Message channels */
+
+// Same size as the messages of the message strategies
+class message_type {
+public:
+  long tag;
+  long data[3];
+};
+
+static constexpr int message_batch_capacity = 8;
+
+class message_batch_type {
+public:
+  int nb;
+  message_type msgs[message_batch_capacity];
+};
+
+// Runs `nb_producers` threads, each of which sends `n` messages to
+// one consumer thread; returns the sum of the tags of the messages
+// received, for checking.
+template <class Send, class Receive>
+long run_message_channel(int nb_producers, long n,
+                         const Send& send, const Receive& receive) {
+  std::atomic<int> nb_done(0);
+  std::vector<std::thread> producers;
+  for (int p = 0; p < nb_producers; p++)
+    producers.push_back(std::thread([&, p] {
+      for (long i = 0; i < n; i++) {
+        message_type msg;
+        msg.tag = 1;
+        send(p, msg);
+      }
+      nb_done++;
+    }));
+  long total = 0;
+  while (true) {
+    bool done = (nb_done.load() == nb_producers);
+    long nb = receive();
+    total += nb;
+    if (done && nb == 0)
+      break;
+  }
+  for (auto& t : producers)
+    t.join();
+  return total;
+}
+
+benchmark_type message_channel_bench() {
+  long n = cmdline::parse_or_default_long("n", 10000000);
+  int nb_producers = cmdline::parse_or_default_int("nb_producers", 1);
+  std::string channel = cmdline::parse_or_default_string("channel", "ring");
+  long* resultp = new long;
+  auto init = [=] {
+  };
+  auto bench = [=] {
+    if (channel == "linked") {
+      // one single-producer buffer per producer, as the pcb strategy
+      std::vector<pasl::data::pcb::linked<message_type>> channels(nb_producers);
+      for (auto& c : channels)
+        c.init();
+      *resultp = run_message_channel(nb_producers, n, [&] (int p, message_type msg) {
+        channels[p].push(msg);
+      }, [&] {
+        long nb = 0;
+        message_type msg;
+        for (auto& c : channels)
+          while (c.try_pop(msg))
+            nb += msg.tag;
+        return nb;
+      });
+      for (auto& c : channels)
+        c.destroy();
+    } else if (channel == "ring") {
+      // one multi-producer buffer, one message per push
+      pasl::data::pcb::ring<message_type> c;
+      c.init();
+      *resultp = run_message_channel(nb_producers, n, [&] (int, message_type msg) {
+        while (! c.try_push(msg))
+          std::this_thread::yield();
+      }, [&] {
+        long nb = 0;
+        message_type msg;
+        while (c.try_pop(msg))
+          nb += msg.tag;
+        return nb;
+      });
+      c.destroy();
+    } else if (channel == "ring_batched") {
+      // one multi-producer buffer, one batch of messages per push,
+      // as the ring strategy
+      pasl::data::pcb::ring<message_batch_type> c;
+      c.init();
+      std::vector<message_batch_type> batches(nb_producers);
+      for (auto& b : batches)
+        b.nb = 0;
+      *resultp = run_message_channel(nb_producers, n, [&] (int p, message_type msg) {
+        message_batch_type& b = batches[p];
+        b.msgs[b.nb++] = msg;
+        if (b.nb == message_batch_capacity) {
+          while (! c.try_push(b))
+            std::this_thread::yield();
+          b.nb = 0;
+        }
+      }, [&] {
+        long nb = 0;
+        message_batch_type b;
+        while (c.try_pop(b))
+          for (int i = 0; i < b.nb; i++)
+            nb += b.msgs[i].tag;
+        return nb;
+      });
+      // flush partial batches
+      long rest = 0;
+      for (auto& b : batches)
+        rest += b.nb;
+      *resultp += rest;
+      c.destroy();
+    } else {
+      pasl::util::atomic::die("bogus channel %s\n", channel.c_str());
+    }
+  };
+  auto output = [=] {
+    std::cout << "result " << *resultp << std::endl;
+  };
+  auto destroy = [=] {
+    delete resultp;
+  };
+  return make_benchmark(init, bench, output, destroy);
+}
+
+/*---------------------------------------------------------------------*/
+/* Finish: high fan-in join points */
+
+// Each of the `n` rounds opens a finish block in which `fanin` asyncs
+// are spawned from the same thread, so that all of them update the
+// join counter of the same continuation.
+
+benchmark_type finish_bench() {
+  long n = cmdline::parse_or_default_long("n", 1000);
+  long fanin = cmdline::parse_or_default_long("fanin", 1000);
+  perworker::array<long>* countsp = new perworker::array<long>;
+  auto init = [=] {
+    countsp->init(0l);
+  };
+  auto bench = [=] {
+    for (long r = 0; r < n; r++) {
+      par::finish([&] (par::multishot* join) {
+        for (long i = 0; i < fanin; i++)
+          par::async([=] {
+            countsp->mine()++;
+          }, join);
+      });
+    }
+  };
+  auto output = [=] {
+    long total = 0;
+    countsp->for_each([&] (worker_id_t, long& c) {
+      total += c;
+    });
+    std::cout << "result " << total << std::endl;
+  };
+  auto destroy = [=] {
+    delete countsp;
+  };
+  return make_benchmark(init, bench, output, destroy);
+}
+
+/*---------------------------------------------------------------------*/
+/* PASL Driver */
+
+int main(int argc, char** argv) {
+
+  benchmark_type bench;
+  
+  auto init = [&] {
+    cmdline::argmap<std::function<benchmark_type()>> m;
+    m.add("perworker",            [&] { return perworker_bench(); });
+    m.add("message_channel",      [&] { return message_channel_bench(); });
+    m.add("finish",               [&] { return finish_bench(); });
+    
+    bench = m.find_by_arg("bench")();
+    bench_init(bench);
+  };
+  auto run = [&] (bool) {
+    bench_run(bench);
+  };
+  auto output = [&] {
+    bench_output(bench);
+  };
+  auto destroy = [&] {
+    bench_destroy(bench);
+  };
+  pasl::sched::launch(argc, argv, init, run, output, destroy);
+}
+
+/***********************************************************************/
@@ -14,6 +14,15 @@
 #include <numa.h>
 #endif
 
+#ifdef USE_MALLOC_COUNT
+#include "malloc_count.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
 #include "pcmdline.hpp"
 #include "threaddag.hpp"
 #include "native.hpp"
@@ -49,23 +58,180 @@ void launch(const Body& body) {
 #endif
 }
 
+/*---------------------------------------------------------------------*/
+/* Measurements */
+
+/*! \class runs_summary
+ *  \brief Execution times of the repetitions of a benchmark, together
+ *  with their summary statistics.
+ */
+class runs_summary {
+public:
+  
+  std::vector<double> warmup_times;
+  std::vector<double> exec_times;
+  std::vector<size_t> malloc_peaks;
+  
+  double total() const {
+    double t = 0.0;
+    for (double e : exec_times)
+      t += e;
+    return t;
+  }
+  
+  double min() const {
+    return *std::min_element(exec_times.begin(), exec_times.end());
+  }
+  
+  double max() const {
+    return *std::max_element(exec_times.begin(), exec_times.end());
+  }
+  
+  double mean() const {
+    return total() / exec_times.size();
+  }
+  
+  double median() const {
+    std::vector<double> ts = exec_times;
+    std::sort(ts.begin(), ts.end());
+    size_t n = ts.size();
+    return (n % 2 == 1) ? ts[n / 2] : (ts[n / 2 - 1] + ts[n / 2]) / 2.0;
+  }
+  
+  double stddev() const {
+    size_t n = exec_times.size();
+    if (n < 2)
+      return 0.0;
+    double m = mean();
+    double acc = 0.0;
+    for (double e : exec_times)
+      acc += (e - m) * (e - m);
+    return std::sqrt(acc / (n - 1));
+  }
+  
+  void print(FILE* f) const {
+    fprintf(f, "nb_runs %d\n", (int)exec_times.size());
+    fprintf(f, "exectime_min %.3lf\n", min());
+    fprintf(f, "exectime_max %.3lf\n", max());
+    fprintf(f, "exectime_mean %.3lf\n", mean());
+    fprintf(f, "exectime_median %.3lf\n", median());
+    fprintf(f, "exectime_stddev %.3lf\n", stddev());
+  }
+  
+  template <class Item>
+  static void print_json_array(FILE* f, const std::vector<Item>& xs,
+                               const char* fmt) {
+    fprintf(f, "[");
+    for (size_t i = 0; i < xs.size(); i++) {
+      if (i > 0)
+        fprintf(f, ", ");
+      fprintf(f, fmt, xs[i]);
+    }
+    fprintf(f, "]");
+  }
+  
+  void print_json(FILE* f) const {
+    fprintf(f, "{\n");
+    fprintf(f, "  \"warmup_times\": ");
+    print_json_array(f, warmup_times, "%.6lf");
+    fprintf(f, ",\n  \"exec_times\": ");
+    print_json_array(f, exec_times, "%.6lf");
+    if (! malloc_peaks.empty()) {
+      fprintf(f, ",\n  \"malloc_peaks\": ");
+      print_json_array(f, malloc_peaks, "%zu");
+    }
+    fprintf(f, ",\n  \"nb_runs\": %d", (int)exec_times.size());
+    fprintf(f, ",\n  \"min\": %.6lf", min());
+    fprintf(f, ",\n  \"max\": %.6lf", max());
+    fprintf(f, ",\n  \"mean\": %.6lf", mean());
+    fprintf(f, ",\n  \"median\": %.6lf", median());
+    fprintf(f, ",\n  \"stddev\": %.6lf", stddev());
+    fprintf(f, "\n}\n");
+  }
+  
+};
+
+/*---------------------------------------------------------------------*/
+/* Launchers */
+
+/*! \brief Runs a benchmark.
+ *
+ * The `run` function is called `warmup` times without measurement, and
+ * then at least `repeat` times, and until the measured repetitions
+ * take at least `min_time` seconds in total. Each of the calls is a
+ * separate launch of the scheduler, so that the scheduler statistics
+ * are reset between repetitions; the statistics printed are those of
+ * the last repetition. Repetitions are performed on the same input:
+ * benchmarks that modify their input in place should pass `-reinit 1`,
+ * which calls `destroy` and then `init` between repetitions.
+ *
+ * With the default options (a single repetition and no warmup), the
+ * output is the same as that of a single run. Otherwise, the time of
+ * each repetition is printed as it completes, followed by a summary;
+ * `exectime` then reports the median. The summary is also written in
+ * JSON format to the file given by `-json`, if any.
+ */
 template <class Init, class Run, class Output, class Destroy>
 void launch(const Init& init, const Run& run, const Output& output,
             const Destroy& destroy) {
   bool sequential = (util::cmdline::parse_or_default_int("proc", 1, false) == 0);
   bool report_time = util::cmdline::parse_or_default_bool("report_time", true, false);
+  int warmup = util::cmdline::parse_or_default_int("warmup", 0, false);
+  int repeat = std::max(1, util::cmdline::parse_or_default_int("repeat", 1, false));
+  double min_time = util::cmdline::parse_or_default_double("min_time", 0.0, false);
+  bool reinit = util::cmdline::parse_or_default_bool("reinit", false, false);
+  std::string json = util::cmdline::parse_or_default_string("json", "", false);
+  bool single_run = (warmup == 0 && repeat == 1 && min_time <= 0.0);
 #ifdef USE_LIBNUMA
   numa_set_interleave_mask(numa_all_nodes_ptr);
 #endif
   threaddag::init();
   launch(init);
-  LOG_BASIC(ENTER_ALGO);
-  uint64_t start_time = util::microtime::now();
-  launch([&] { run(sequential); });
-  double exec_time = util::microtime::seconds_since(start_time);
-  LOG_BASIC(EXIT_ALGO);
-  if (report_time)
-    printf ("exectime %.3lf\n", exec_time);
+  runs_summary summary;
+  auto run_once = [&] {
+    if (reinit && ! (summary.warmup_times.empty() && summary.exec_times.empty())) {
+      launch(destroy);
+      launch(init);
+    }
+#ifdef USE_MALLOC_COUNT
+    malloc_count_reset_peak();
+#endif
+    LOG_BASIC(ENTER_ALGO);
+    uint64_t start_time = util::microtime::now();
+    launch([&] { run(sequential); });
+    double exec_time = util::microtime::seconds_since(start_time);
+    LOG_BASIC(EXIT_ALGO);
+    return exec_time;
+  };
+  for (int i = 0; i < warmup; i++) {
+    double exec_time = run_once();
+    summary.warmup_times.push_back(exec_time);
+    if (report_time)
+      printf ("warmup_exectime %.3lf\n", exec_time);
+  }
+  while ((int)summary.exec_times.size() < repeat || summary.total() < min_time) {
+    double exec_time = run_once();
+    summary.exec_times.push_back(exec_time);
+#ifdef USE_MALLOC_COUNT
+    summary.malloc_peaks.push_back(malloc_count_peak());
+#endif
+    if (report_time && ! single_run) {
+      printf ("run_exectime %.3lf\n", exec_time);
+      fflush(stdout);
+    }
+  }
+  if (report_time) {
+    if (! single_run)
+      summary.print(stdout);
+    printf ("exectime %.3lf\n", summary.median());
+  }
+  if (json != "") {
+    FILE* f = fopen(json.c_str(), "w");
+    if (f == NULL)
+      util::atomic::die("failed to open %s for writing\n", json.c_str());
+    summary.print_json(f);
+    fclose(f);
+  }
   STAT_IDLE(sum());
   STAT(dump(stdout));
   STAT_IDLE(print_idle(stdout));
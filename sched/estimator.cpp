@@ -30,7 +30,7 @@ static void try_write_constants_to_file();
 static void try_read_constants_from_file();
 
 void init() {
-  local_ticks_per_microsec = util::machine::cpu_frequency_ghz * 1000.;
+  local_ticks_per_microsec = util::ticks::get_ticks_per_microseconds();
   try_read_constants_from_file();
 }
 
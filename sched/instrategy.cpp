@@ -16,7 +16,81 @@ namespace sched {
 namespace instrategy {
 
 /***********************************************************************/
-  
+
+/*---------------------------------------------------------------------*/
+/* Scalable nonzero indicator */
+
+snzi::snzi()
+: root(1l), others(nullptr), width(1) {
+  first.count.store(1l);
+  max_width = 1;
+  while (max_width < util::worker::get_nb())
+    max_width *= 2;
+}
+
+snzi::~snzi() {
+  delete [] others.load();
+}
+
+void snzi::grow(int w) {
+  if (w >= max_width)
+    return;
+  if (others.load() == nullptr) {
+    node_type* nodes = new node_type[max_width - 1];
+    node_type* orig = nullptr;
+    if (! others.compare_exchange_strong(orig, nodes))
+      delete [] nodes;
+  }
+  width.compare_exchange_strong(w, 2 * w);
+}
+
+void snzi::arrive(worker_id_t my_id) {
+  while (true) {
+    int w = width.load();
+    node_type& n = leaf(my_id & (w - 1));
+    int64_t c = n.count.load();
+    if (c > 0) {
+      if (n.count.compare_exchange_strong(c, c + 1))
+        return;
+    } else {
+      // the root is incremented first, so that it never undercounts
+      // the number of nonzero leaves
+      root++;
+      if (n.count.compare_exchange_strong(c, 1l))
+        return;
+      // by the precondition, the counter is nonzero, so the undo
+      // cannot bring the root to zero
+      root--;
+    }
+    grow(w);
+  }
+}
+
+bool snzi::depart(worker_id_t my_id) {
+  while (true) {
+    int w = width.load();
+    for (int k = 0; k < w; k++) {
+      node_type& n = leaf((my_id + k) & (w - 1));
+      int64_t c = n.count.load();
+      while (c > 0) {
+        if (n.count.compare_exchange_strong(c, c - 1))
+          return (c == 1l) && (--root == 0l);
+        if (k == 0)
+          grow(w);
+      }
+    }
+  }
+}
+
+void snzi::delta(thread_p t, int64_t d) {
+  worker_id_t my_id = util::worker::get_my_id();
+  for (; d > 0; d--)
+    arrive(my_id);
+  for (; d < 0; d++)
+    if (depart(my_id))
+      start(t);
+}
+
 /***********************************************************************/
 
 } // end namespace
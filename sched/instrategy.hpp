@@ -270,6 +270,83 @@ public:
   
 };
   
+/*---------------------------------------------------------------------*/
+
+/*! \class snzi
+ *  \brief Join counter implemented as a scalable nonzero indicator
+ *  whose width adapts to contention.
+ *
+ * The counter is a tree of depth one: a root and a number of leaves,
+ * each leaf on its own cache line. An increment by worker `w` is
+ * applied to the leaf `w mod width`, and a decrement to the first
+ * leaf with a positive count, starting from the same leaf. The root
+ * stores the number of leaves whose count is nonzero, so that it is
+ * updated only when a leaf goes from zero to nonzero or back. The
+ * thread is started by the decrement that brings the root to zero.
+ *
+ * Initially, the width is one, and the only leaf is stored inline,
+ * so that a join point with little contention costs no more than a
+ * `fetch_add` counter and one allocation less than `distributed`.
+ * Every failed compare-and-swap on a leaf doubles the width, up to
+ * the number of workers rounded to the next power of two. The
+ * additional leaves are allocated once, on the first growth.
+ *
+ * Unlike the `distributed` in-strategy, the end of the join is
+ * detected as soon as it happens, without periodic checks.
+ *
+ * The counter is created holding one unit on behalf of the thread
+ * that owns the join point, which is released by `init`. This way,
+ * the count cannot drop to zero before the thread is added, even if
+ * the threads forked in the meantime have already completed.
+ *
+ * \pre An increment is performed only by a thread that is itself
+ * counted by the counter or before `init`, which is the case for the
+ * async/finish pattern.
+ *
+ * \ingroup instrategy
+ */
+class snzi : public common {
+protected:
+  
+  class node_type {
+  public:
+    std::atomic<int64_t> count;
+    char padding[64 - sizeof(std::atomic<int64_t>)];
+    node_type() : count(0l) { }
+  };
+  
+  __attribute__ ((aligned (64))) std::atomic<int64_t> root;
+  node_type first;
+  std::atomic<node_type*> others;
+  std::atomic<int> width;
+  int max_width;
+  
+  node_type& leaf(int i) {
+    return (i == 0) ? first : others.load()[i - 1];
+  }
+  
+  void grow(int w);
+  void arrive(worker_id_t my_id);
+  bool depart(worker_id_t my_id);
+  
+public:
+  
+  snzi();
+  ~snzi();
+  
+  void init(thread_p t) {
+    delta(t, -1l);
+  }
+  
+  void check(thread_p t) {
+    if (root.load() == 0l)
+      start(t);
+  }
+  
+  void delta(thread_p t, int64_t d);
+  
+};
+  
 /*---------------------------------------------------------------------*/
  
 const long READY_TAG = 1;
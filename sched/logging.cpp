@@ -36,9 +36,9 @@ void event_t::print_byte_descr(FILE* f) { }
 
 void event_t::print_text_descr(FILE* f) { }
 
-void event_t::record (microtime_t basetime) {
+void event_t::record (ticks_t basetime) {
   id = (int64_t) worker::get_my_id();
-  time = microtime::now() - basetime; // or (double) ticks::now()
+  time = ticks::microseconds(ticks::now() - basetime);
 // TEMP
 /*
   if (microtime::seconds(time) > 0.01) {
@@ -85,7 +85,7 @@ recorder_t::~recorder_t() {
 }
 
 void recorder_t::init() {
-  basetime = microtime::now();
+  basetime = ticks::now();
   real_time = cmdline::parse_or_default_bool("log_stdout", false);
   text_mode = cmdline::parse_or_default_bool("log_text", real_time);
   set_tracking_all(false); 
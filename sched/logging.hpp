@@ -161,7 +161,7 @@ public:
 
   virtual void print_text_descr(FILE* f);
 
-  virtual void record (microtime_t basetime);
+  virtual void record (ticks_t basetime);
 
   virtual void print_byte_header (FILE* f);
 
@@ -191,7 +191,7 @@ private:
   typedef data::perworker::extra<events_t> wi_events_t;
   wi_events_t events_for; 
   events_t all_events;
-  microtime_t basetime;
+  ticks_t basetime;
 
 private:
   events_t& get_my_events();
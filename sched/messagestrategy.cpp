@@ -88,6 +88,68 @@ void pcb::check() {
   target[my_id] = id;
 }
 
+/*---------------------------------------------------------------------*/
+/* Messagestrategy implemented with batched ring buffers */
+
+void ring::init() {
+  int nb_workers = util::worker::get_nb();
+  for (worker_id_t id = 0; id < nb_workers; id++) {
+    channels[id].init();
+    outbox_t& outbox = outboxes[id];
+    outbox.batches.resize(nb_workers);
+    for (worker_id_t tid = 0; tid < nb_workers; tid++)
+      outbox.batches[tid].nb = 0;
+  }
+}
+
+void ring::destroy() {
+  int nb_workers = util::worker::get_nb();
+  for (worker_id_t id = 0; id < nb_workers; id++)
+    channels[id].destroy();
+}
+
+void ring::flush(worker_id_t my_id, worker_id_t id_target) {
+  batch_t& pending = outboxes[my_id].batches[id_target];
+  if (pending.nb == 0)
+    return;
+  // the batch is copied out first because handling incoming
+  // messages below may send new messages to the same target
+  batch_t batch = pending;
+  pending.nb = 0;
+  while (! channels[id_target].try_push(batch))
+    receive(my_id);
+}
+
+void ring::flush_all(worker_id_t my_id) {
+  int nb_workers = util::worker::get_nb();
+  for (worker_id_t id_target = 0; id_target < nb_workers; id_target++)
+    flush(my_id, id_target);
+}
+
+void ring::receive(worker_id_t my_id) {
+  batch_t batch;
+  while (channels[my_id].try_pop(batch))
+    for (int i = 0; i < batch.nb; i++)
+      handle_message(batch.msgs[i]);
+}
+
+void ring::send(worker_id_t id_target, message_t msg) {
+  worker_id_t my_id = util::worker::get_my_id();
+  batch_t& batch = outboxes[my_id].batches[id_target];
+  batch.msgs[batch.nb++] = msg;
+  if (batch.nb == batch_capacity)
+    flush(my_id, id_target);
+  STAT_COUNT(MSG_SEND);
+}
+
+void ring::check() {
+  if (util::worker::get_nb() <= 1)
+    return;
+  worker_id_t my_id = util::worker::get_my_id();
+  flush_all(my_id);
+  receive(my_id);
+}
+
 } // end namespace
 } // end namespace
 } // end namespace
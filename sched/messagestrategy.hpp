@@ -12,6 +12,7 @@
 
 #include <algorithm>
 #include <queue>
+#include <vector>
 
 #include "worker.hpp"
 #include "classes.hpp"
@@ -155,7 +156,7 @@ private:
 
   typedef data::pcb::linked<message_t> pcb_t;
   typedef data::perworker::array<pcb_t> pcb_vector_t;
-  typedef data::perworker::array<pcb_vector_t> pcb_matrix_t;
+  typedef data::perworker::local_array<pcb_vector_t> pcb_matrix_t;
   typedef data::perworker::array<int> target_t;
   
   pcb_matrix_t channels;
@@ -170,6 +171,65 @@ public:
   void check();
 };
 
+/*---------------------------------------------------------------------*/
+
+/*! \class ring
+ *  \ingroup messagestrategy
+ *  \brief A message strategy that uses one bounded, multi-producer
+ *  ring buffer per worker to store messages.
+ *
+ * Unlike the `pcb` strategy, sending a message allocates nothing and
+ * a worker polls a single buffer, regardless of the number of workers.
+ *
+ * Messages are not pushed on the buffer of the target one at a time:
+ * each worker accumulates outgoing messages in one batch per target
+ * and pushes the batch on the buffer of the target as a single item,
+ * either when the batch is full or on the next call to `check()` by
+ * the sender. Batching amortizes the cost of the atomic operations,
+ * and of the cache misses on the buffer of the target, over up to
+ * `batch_capacity` messages.
+ *
+ * When the buffer of the target is full, the sender applies
+ * backpressure by processing its own incoming messages until the
+ * target makes room. This way, two workers that send to each other
+ * cannot deadlock.
+ *
+ */
+class ring : public messagestrategy {
+public:
+
+  static constexpr int batch_capacity = 8;
+  static constexpr int channel_capacity = 256;
+
+private:
+
+  typedef struct {
+    int nb;
+    message_t msgs[batch_capacity];
+  } batch_t;
+
+  typedef data::pcb::ring<batch_t, channel_capacity> channel_t;
+
+  class outbox_t {
+  public:
+    // one batch per target
+    std::vector<batch_t> batches;
+  };
+
+  data::perworker::local_array<channel_t> channels;
+  data::perworker::local_array<outbox_t> outboxes;
+
+  void flush(worker_id_t my_id, worker_id_t id_target);
+  void flush_all(worker_id_t my_id);
+  void receive(worker_id_t my_id);
+
+public:
+  void init();
+  void destroy();
+  void send(worker_id_t target, message_t msg);
+  void check();
+};
+
 /***********************************************************************/
 
 } // end namespace
@@ -19,6 +19,7 @@
 #include "threaddag.hpp"
 #include "control.hpp"
 #include "atomic.hpp"
+#include "reducer.hpp"
 
 #ifndef _PASL_NATIVE_H_
 #define _PASL_NATIVE_H_
@@ -118,8 +119,7 @@ public:
   }
 
   void finish(multishot_p thread) {
-    instrategy::distributed* dist = new instrategy::distributed(this);
-    threaddag::unary_fork_join(thread, this, dist);
+    threaddag::unary_fork_join(thread, this, threaddag::new_finish_instrategy(this));
     prepare_and_swap_with_scheduler();
   }
 
@@ -212,11 +212,8 @@ static inline int my_deque_size() {
 /*---------------------------------------------------------------------*/
 
 template <class Exp1, class Exp2>
-void fork2(const Exp1& exp1, const Exp2& exp2) {
-#if defined(SEQUENTIAL_ELISION)
-  exp1();
-  exp2();
-#elif defined(USE_CILK_RUNTIME)
+void fork2_without_reducers(const Exp1& exp1, const Exp2& exp2) {
+#if defined(USE_CILK_RUNTIME)
   cilk_spawn exp1();
   exp2();
   cilk_sync;
@@ -226,6 +223,43 @@ void fork2(const Exp1& exp1, const Exp2& exp2) {
 #endif
 }
 
+template <class Exp1, class Exp2>
+void fork2(const Exp1& exp1, const Exp2& exp2) {
+#if defined(SEQUENTIAL_ELISION)
+  exp1();
+  exp2();
+#else
+  hypermap* h = my_hypermap();
+  if (h == nullptr) {
+    fork2_without_reducers(exp1, exp2);
+    return;
+  }
+  // see reducer.hpp; the cells are reset at the end of each branch,
+  // as the worker may then go on with an unrelated strand
+  std::atomic<bool> left_done(false);
+  hypermap* right = nullptr;
+  fork2_without_reducers([&] {
+    exp1();
+    my_hypermap() = nullptr;
+    left_done.store(true, std::memory_order_release);
+  }, [&] {
+    if (left_done.load(std::memory_order_acquire)) {
+      my_hypermap() = h;
+    } else {
+      right = new hypermap();
+      my_hypermap() = right;
+    }
+    exp2();
+    my_hypermap() = nullptr;
+  });
+  my_hypermap() = h;
+  if (right != nullptr) {
+    h->reduce_with(*right);
+    delete right;
+  }
+#endif
+}
+
 template <class Body>
 void async(const Body& body, multishot* join) {
   multishot* thread = new_multishot_by_lambda(body);
@@ -0,0 +1,244 @@
+/* COPYRIGHT (c) 2014 Umut Acar, Arthur Chargueraud, and Michael
+ * Rainey
+ * All rights reserved.
+ *
+ * \file reducer.hpp
+ * \brief Reducers: objects that parallel branches update without
+ * synchronization, with results combined in serial order
+ *
+ */
+
+#include <assert.h>
+#include <utility>
+#include <vector>
+
+#include "workerlocal.hpp"
+
+#ifndef _PASL_SCHED_REDUCER_H_
+#define _PASL_SCHED_REDUCER_H_
+
+namespace pasl {
+namespace sched {
+namespace native {
+
+/***********************************************************************/
+
+/*---------------------------------------------------------------------*/
+/* Hypermaps
+ *
+ * A hypermap associates with each reducer in scope the view of that
+ * reducer to which the running strand writes. The hypermap of the
+ * strand that a worker runs is stored in the cell of the worker in
+ * `hypermaps<>::cells`; the cell is null when no reducer is in scope,
+ * in which case `fork2` proceeds as usual.
+ *
+ * On a `fork2` with reducers in scope, the left branch keeps the
+ * hypermap of the parent. The right branch also keeps it if it starts
+ * after the left branch has completed, as it does whenever it is not
+ * stolen; otherwise, it starts with an empty hypermap, to which views
+ * are added on first access. At the join, the views of the right
+ * branch are merged into those of the parent, in serial order.
+ */
+
+class reducer_base {
+public:
+
+  virtual ~reducer_base() { }
+
+  //! Returns a new view that holds the identity
+  virtual void* new_view() = 0;
+
+  //! Merges the view `right` into the end of the view `left`, then deletes `right`
+  virtual void reduce(void* left, void* right) = 0;
+
+};
+
+class hypermap {
+private:
+
+  // few reducers are in scope at a time, hence the linear search
+  std::vector<std::pair<reducer_base*, void*>> views;
+
+public:
+
+  bool empty() const {
+    return views.empty();
+  }
+
+  void* find(const reducer_base* r) const {
+    for (auto& p : views)
+      if (p.first == r)
+        return p.second;
+    return nullptr;
+  }
+
+  void insert(reducer_base* r, void* view) {
+    assert(find(r) == nullptr);
+    views.push_back(std::make_pair(r, view));
+  }
+
+  void erase(const reducer_base* r) {
+    for (size_t i = 0; i < views.size(); i++)
+      if (views[i].first == r) {
+        views.erase(views.begin() + i);
+        return;
+      }
+  }
+
+  //! Merges the views of `right`, which follows this hypermap in serial order; leaves `right` empty
+  void reduce_with(hypermap& right) {
+    for (auto& p : right.views) {
+      void* left_view = find(p.first);
+      if (left_view == nullptr)
+        insert(p.first, p.second);
+      else
+        p.first->reduce(left_view, p.second);
+    }
+    right.views.clear();
+  }
+
+};
+
+template <class Dummy=void>
+class hypermaps {
+public:
+  static data::perworker::array<hypermap*> cells;
+};
+
+template <class Dummy>
+data::perworker::array<hypermap*> hypermaps<Dummy>::cells;
+
+//! Hypermap of the strand run by the calling worker
+static inline hypermap*& my_hypermap() {
+  return hypermaps<>::cells.mine();
+}
+
+/*---------------------------------------------------------------------*/
+/*!
+ * \class reducer
+ * \brief Object whose updates by parallel branches are combined in
+ * the order of the serial execution
+ * \tparam Monoid provides `value_type`, whose default constructor
+ * gives the identity, and `static void reduce(value_type& left,
+ * value_type& right)`, which merges `right` into the end of `left`
+ *
+ * A strand updates the object through the reference returned by
+ * `view`. Strands that run one after the other on the same worker
+ * share their view, so that no view is created and no merge takes
+ * place as long as no branch is stolen; a stolen branch gets a view
+ * of its own on its first call to `view`, which is merged into the
+ * view of the left branch at the join of its `fork2`. No lock is
+ * taken.
+ *
+ * The reference returned by `view` is not to be kept across a
+ * `fork2`: the branches shall call `view` again. Within the scope of
+ * a reducer, parallel branches shall be created by `fork2` (or by
+ * the loops built on it). Reducers are destroyed in the reverse order
+ * of their construction, by the strand that constructed them, once
+ * all the branches that it has forked have joined.
+ *
+ * Example: collecting in order the items that satisfy a predicate
+ *
+ *     reducer<concat_monoid<pcontainer::deque<int>>> r;
+ *     parallel_for(0, n, [&] (int i) {
+ *       if (pred(i))
+ *         r.view().push_back(i);
+ *     });
+ *     pcontainer::deque<int>& result = r.get_value();
+ *
+ */
+template <class Monoid>
+class reducer : public reducer_base {
+public:
+
+  using monoid_type = Monoid;
+  using value_type = typename Monoid::value_type;
+
+private:
+
+  value_type root;
+  // whether the hypermap of the constructing strand was created by this reducer
+  bool owns_hypermap;
+
+public:
+
+  reducer() {
+    hypermap*& h = my_hypermap();
+    owns_hypermap = (h == nullptr);
+    if (owns_hypermap)
+      h = new hypermap();
+    h->insert(this, &root);
+  }
+
+  reducer(const reducer&) = delete;
+  reducer& operator=(const reducer&) = delete;
+
+  ~reducer() {
+    hypermap*& h = my_hypermap();
+    assert(h != nullptr);
+    assert(h->find(this) == &root);
+    h->erase(this);
+    if (owns_hypermap) {
+      assert(h->empty());
+      delete h;
+      h = nullptr;
+    }
+  }
+
+  void* new_view() {
+    return new value_type();
+  }
+
+  void reduce(void* left, void* right) {
+    value_type* r = (value_type*)right;
+    Monoid::reduce(*(value_type*)left, *r);
+    delete r;
+  }
+
+  //! Returns the view of the calling strand
+  value_type& view() {
+    hypermap* h = my_hypermap();
+    assert(h != nullptr);
+    void* v = h->find(this);
+    if (v == nullptr) {
+      v = new_view();
+      h->insert(this, v);
+    }
+    return *(value_type*)v;
+  }
+
+  /*! \brief Returns the combined value
+   *
+   * \pre Called by the strand that constructed the reducer, after
+   * all the branches that it has forked have joined
+   */
+  value_type& get_value() {
+    assert(my_hypermap() != nullptr && my_hypermap()->find(this) == &root);
+    return root;
+  }
+
+};
+
+/*---------------------------------------------------------------------*/
+/* Monoids */
+
+//! Sequences under concatenation (e.g., chunked sequences)
+template <class Sequence>
+class concat_monoid {
+public:
+
+  using value_type = Sequence;
+
+  static void reduce(value_type& left, value_type& right) {
+    left.concat(right);
+  }
+
+};
+
+/***********************************************************************/
+
+} // end namespace
+} // end namespace
+} // end namespace
+
+#endif //! _PASL_SCHED_REDUCER_H_
@@ -142,7 +142,7 @@ stats_private_t& stats_t::get_my_stats() {
 
 void stats_t::enter_launch() {
   launch_finished = false;
-  launch_enter_time = microtime::now();
+  launch_enter_time = ticks::now();
 }
 
 void stats_t::finished_launch() {
@@ -153,8 +153,8 @@ void stats_t::finished_launch() {
 void stats_t::exit_launch() {
   // todo: might move to finished_launch
   assert (launch_enter_time != never);
-  launch_exit_time = microtime::now();
-  launch_duration = microtime::seconds(microtime::diff(launch_enter_time, launch_exit_time));
+  launch_exit_time = ticks::now();
+  launch_duration = ticks::seconds(launch_exit_time - launch_enter_time);
   launch_enter_time = never;
 }
 
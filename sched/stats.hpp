@@ -128,8 +128,8 @@ private:
   wi_stats_t stats;
   stats_data_t total_data;
 
-  microtime_t launch_enter_time;
-  microtime_t launch_exit_time;
+  ticks_t launch_enter_time;
+  ticks_t launch_exit_time;
   double launch_duration;
 
   // computed
@@ -78,6 +78,19 @@ instrategy_p new_forkjoin_instrategy() {
   return in;
 }
 
+typedef enum { DISTRIBUTED, SNZI } finish_instrategy_class_t;
+static finish_instrategy_class_t instrategy_class_finish;
+
+instrategy_p new_finish_instrategy(thread_p cont) {
+  instrategy_p in = NULL;
+  switch (instrategy_class_finish) {
+    case DISTRIBUTED: in = new instrategy::distributed(cont); break;
+    case SNZI: in = new instrategy::snzi(); break;
+    default: util::atomic::die("bogus finish instrategy");
+  }
+  return in;
+}
+
 typedef enum { UNARY, FENCEFREE_OUTSTRATEGY } outstrategy_class_t;
 static outstrategy_class_t outstrategy_class_forkjoin;
 
@@ -150,6 +163,14 @@ static void init_scheduler() {
   util::cmdline::parse_or_default_string("scheduler", "workstealing", false);
   instrategy_class_forkjoin = FETCH_ADD;
   outstrategy_class_forkjoin = UNARY;
+  std::string finishstr =
+    util::cmdline::parse_or_default_string("finish_instrategy", "distributed", false);
+  if (finishstr.compare("distributed") == 0)
+    instrategy_class_finish = DISTRIBUTED;
+  else if (finishstr.compare("snzi") == 0)
+    instrategy_class_finish = SNZI;
+  else
+    util::atomic::die("bogus finish instrategy %s\n", finishstr.c_str());
   if (schedulerstr.compare("workstealing") == 0) {
     std::string tsetstr = util::cmdline::parse_or_default_string("threadset", "cas_ri", false);
     if (tsetstr.compare("cas_si") == 0) {
@@ -179,7 +200,14 @@ static void destroy_scheduler() {
 }
 
 static void init_messagestrategy() {
-  messagestrategy::the_messagestrategy = new messagestrategy::pcb();
+  std::string msgstr =
+    util::cmdline::parse_or_default_string("messagestrategy", "ring", false);
+  if (msgstr.compare("ring") == 0)
+    messagestrategy::the_messagestrategy = new messagestrategy::ring();
+  else if (msgstr.compare("pcb") == 0)
+    messagestrategy::the_messagestrategy = new messagestrategy::pcb();
+  else
+    util::atomic::die("bogus message strategy %s\n", msgstr.c_str());
   messagestrategy::the_messagestrategy->init();
 }
 
@@ -375,8 +403,7 @@ void finish(thread_p thread, thread_p cont, instrategy_p in) {
 }
 
 void finish(thread_p thread, thread_p cont) {
-  instrategy_p in = new instrategy::distributed(cont);
-  finish(thread, cont, in);
+  finish(thread, cont, new_finish_instrategy(cont));
 }
 
 /*---------------------------------------------------------------------*/
@@ -215,7 +215,9 @@ void delete_future(future_p future);
  * More precisely,
  * 1. instrategy of `thread` is `ready`
  * 2. outstrategy of `thread` is `unary` pointing on `cont`
- * 2. instrategy of `cont` is as specified by `in` or else `distributed`
+ * 2. instrategy of `cont` is as specified by `in` or else the one
+ *    selected by the command-line option `-finish_instrategy`, which
+ *    is either `distributed` (the default) or `snzi`
  */
 
 void async(thread_p thread, thread_p cont);
@@ -228,6 +230,7 @@ void finish(thread_p thread, thread_p cont);
 /*---------------------------------------------------------------------*/
   
 instrategy_p new_forkjoin_instrategy();
+instrategy_p new_finish_instrategy(thread_p cont);
 outstrategy_p new_forkjoin_outstrategy(branch_t branch);
   
 void change_factory(util::worker::controller_factory_t* factory);
@@ -289,6 +289,21 @@ public:
     return vec.insert(pos, val);
   }
   
+  iterator erase(iterator first, iterator last) {
+    return vec.erase(first, last);
+  }
+  
+  void split(size_type n, self_type& dst) {
+    auto it = begin() + n;
+    dst.vec.insert(dst.vec.end(), it, end());
+    vec.erase(it, end());
+  }
+  
+  void concat(self_type& dst) {
+    vec.insert(vec.end(), dst.vec.begin(), dst.vec.end());
+    dst.clear();
+  }
+  
   void transfer_to_back(self_type& dst) {
     int nb = (int)dst.size();
     for (int i = 0; i < nb; i++)
@@ -562,6 +577,12 @@ public:
     return v.insert(pos, val);
   }
   
+  iterator erase(iterator first, iterator last) {
+    size_t i = first - begin();
+    v.erase(first, last);
+    return begin() + i;
+  }
+  
   void clear() {
     v.clear();
   }
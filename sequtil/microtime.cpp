@@ -1,8 +1,7 @@
 
 
 #include "microtime.hpp"
-#include <sys/time.h>
-#include <time.h>
+#include "ticks.hpp"
 
 namespace pasl {
 namespace util {
@@ -11,9 +10,7 @@ namespace microtime {
 /***********************************************************************/
 
 microtime_t now() {
-  struct timeval tv;
-  gettimeofday(&tv, NULL);
-  return 1000000l * ((microtime_t) tv.tv_sec) + ((microtime_t) tv.tv_usec);
+  return (microtime_t) (ticks::clock_nanoseconds() / 1000l);
 }
 
 microtime_t diff(microtime_t t1, microtime_t t2) {
@@ -5,6 +5,9 @@
  * \file microtime.hpp
  * \brief Interface for system time; unit is microseconds
  *
+ * Times are read from the same monotonic clock that `ticks` uses as
+ * its reference, so they do not jump when the wall clock is adjusted.
+ *
  */
 
 #ifndef _PASL_UTIL_MICROTIME_H_
@@ -7,6 +7,10 @@
  *
  */
 
+#if defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
 #include "ticks.hpp"
 
 namespace pasl {
@@ -15,28 +19,84 @@ namespace ticks {
 
 /***********************************************************************/
 
-uint64_t to_uint64(ticks_t t) {
-  return (uint64_t) t;
+source_t source = SOURCE_CLOCK;
+
+double ticks_per_seconds = 1000000000.;
+
+/* Duration of the calibration of the TSC, in nanoseconds */
+
+static const uint64_t calibration_nsec = 20000000l;
+
+bool has_invariant_tsc() {
+#if defined(__x86_64__)
+  unsigned a, b, c, d;
+  if (__get_cpuid(0x80000000, &a, &b, &c, &d) == 0 || a < 0x80000007)
+    return false;
+  __get_cpuid(0x80000007, &a, &b, &c, &d);
+  return (d & (1u << 8)) != 0;
+#else
+  return false;
+#endif
+}
+
+#if defined(__x86_64__)
+
+/* Measures the rate of the TSC against the monotonic clock */
+
+static double calibrate_tsc() {
+  uint64_t clock_start = clock_nanoseconds();
+  uint64_t tsc_start = rdtsc_begin();
+  uint64_t clock_stop;
+  do {
+    clock_stop = clock_nanoseconds();
+  } while (clock_stop - clock_start < calibration_nsec);
+  uint64_t tsc_stop = rdtsc_end();
+  double nb_seconds = ((double) (clock_stop - clock_start)) / 1000000000.;
+  return ((double) (tsc_stop - tsc_start)) / nb_seconds;
 }
 
-ticks_t now () { 
-  return getticks();
+#endif
+
+void init() {
+#if defined(__x86_64__)
+  if (has_invariant_tsc()) {
+    ticks_per_seconds = calibrate_tsc();
+    source = SOURCE_TSC;
+    return;
+  }
+#endif
+  ticks_per_seconds = 1000000000.;
+  source = SOURCE_CLOCK;
+}
+
+source_t get_source() {
+  return source;
+}
+
+uint64_t to_uint64(ticks_t t) {
+  return (uint64_t) t;
 }
 
 double diff (ticks_t t1, ticks_t t2) {
-  return elapsed (t2, t1);
+  return (double) t2 - (double) t1;
 }
 
 double since (ticks_t t) {
   return diff (t, now ());
 }
 
-double ticks_per_seconds;
-
 void set_ticks_per_seconds(double nb) {
   ticks_per_seconds = nb;
 }
 
+double get_ticks_per_seconds() {
+  return ticks_per_seconds;
+}
+
+double get_ticks_per_microseconds() {
+  return ticks_per_seconds / 1000000.;
+}
+
 double seconds(ticks_t t) {
   return ((double) t) / ticks_per_seconds;
 }
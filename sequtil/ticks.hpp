@@ -5,14 +5,24 @@
  * \file ticks.hpp
  * \brief Collection of operations for measuring elapsed time
  *
+ * Ticks are read from the timestamp counter (TSC) when the processor
+ * provides an invariant TSC, that is, one that runs at a constant
+ * rate regardless of frequency scaling and sleep states. Otherwise,
+ * and on architectures other than x86-64, ticks are read from the
+ * monotonic system clock, with one tick per nanosecond.
+ *
+ * The number of ticks per second is calibrated by `init()` against
+ * the monotonic system clock, so that conversions of ticks to
+ * seconds are comparable across machines. Before `init()` is called,
+ * ticks are read from the monotonic system clock.
+ *
  */
 
 #ifndef _TICKS_H_
 #define _TICKS_H_
 
 #include <stdint.h>
-
-#include "cycles.hpp"
+#include <time.h>
 
 namespace pasl {
 namespace util {
@@ -20,11 +30,94 @@ namespace ticks {
   
 /***********************************************************************/
 
-typedef ticks_repr ticks_t;
+typedef uint64_t ticks_t;
+
+/* Sources of ticks */
+
+typedef enum { SOURCE_CLOCK, SOURCE_TSC } source_t;
+
+/* Calibrate the number of ticks per second and select the source
+   of ticks; needs to be called once, before any worker is created */
+
+void init();
+
+/* Source currently in use */
+
+source_t get_source();
+
+/* Returns true if the processor provides an invariant TSC */
+
+bool has_invariant_tsc();
+
+/* Raw readers; prefer now() */
+
+static inline uint64_t clock_nanoseconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return 1000000000l * ((uint64_t) ts.tv_sec) + ((uint64_t) ts.tv_nsec);
+}
+
+#if defined(__x86_64__)
+
+static inline uint64_t rdtsc() {
+  unsigned a, d;
+  asm volatile("rdtsc" : "=a" (a), "=d" (d));
+  return ((uint64_t)a) | (((uint64_t)d) << 32);
+}
+
+/* Reads the TSC after all previous instructions have completed;
+   to be used at the start of a measured region */
+
+static inline uint64_t rdtsc_begin() {
+  unsigned a, d;
+  asm volatile("lfence\n\trdtsc" : "=a" (a), "=d" (d) : : "memory");
+  return ((uint64_t)a) | (((uint64_t)d) << 32);
+}
 
-/* Get current timestamp counter */
+/* Reads the TSC before any subsequent instruction starts; to be used
+   at the end of a measured region */
 
-ticks_t now();
+static inline uint64_t rdtsc_end() {
+  unsigned a, d, c;
+  asm volatile("rdtscp\n\tlfence" : "=a" (a), "=d" (d), "=c" (c) : : "memory");
+  return ((uint64_t)a) | (((uint64_t)d) << 32);
+}
+
+#endif
+
+extern source_t source;
+
+/* Get current timestamp counter; cheap enough for hot paths */
+
+static inline ticks_t now() {
+#if defined(__x86_64__)
+  if (source == SOURCE_TSC)
+    return rdtsc();
+#endif
+  return clock_nanoseconds();
+}
+
+/* Same as now(), but serialized with respect to the instructions
+   that precede it; to be used at the start of a measured region */
+
+static inline ticks_t now_begin() {
+#if defined(__x86_64__)
+  if (source == SOURCE_TSC)
+    return rdtsc_begin();
+#endif
+  return clock_nanoseconds();
+}
+
+/* Same as now(), but serialized with respect to the instructions
+   that follow it; to be used at the end of a measured region */
+
+static inline ticks_t now_end() {
+#if defined(__x86_64__)
+  if (source == SOURCE_TSC)
+    return rdtsc_end();
+#endif
+  return clock_nanoseconds();
+}
 
 /* Convert into uint64_t */
 
@@ -39,27 +132,32 @@ double diff(ticks_t t1, ticks_t t2);
 
 double since(ticks_t t);
 
-/* Set the number of ticks per seconds (machine dependent) */
+/* Set the number of ticks per seconds (machine dependent); 
+   overrides the value calibrated by init() */
 
 void set_ticks_per_seconds(double nb);
 
-/* Convert in seconds 
-   -- requires set_ticks_per_seconds to be called */
+/* Number of ticks per second */
+
+double get_ticks_per_seconds();
+
+/* Number of ticks per microsecond */
+
+double get_ticks_per_microseconds();
+
+/* Convert in seconds */
 
 double seconds(ticks_t t);
 
-/* Convert in microseconds 
-   -- requires set_ticks_per_seconds to be called */
+/* Convert in microseconds */
 
 double microseconds(ticks_t t);
 
-/* Convert in nanoseconds 
-   -- requires set_ticks_per_seconds to be called */
+/* Convert in nanoseconds */
 
 double nanoseconds(ticks_t t);
 
-/* Compute difference directly in seconds
-    -- requires set_ticks_per_seconds to be called  */
+/* Compute difference directly in seconds */
 
 double seconds_since(ticks_t t);
 
@@ -84,7 +182,3 @@ void microseconds_sleep(double nb);
 } // namespace
 
 #endif /*! _TICKS_H_ */
-
-
-
-
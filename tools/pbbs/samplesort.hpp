@@ -102,9 +102,9 @@ void sampleSort (E* A, intT n, BinPred f) {
     //nextTime("sort and merge");
     
     // transpose from rows to columns
-    sequence::scan(segSizes, offsetA, numR*numSegs, plus<intT>(),(intT)0);
+    sequence::scan(segSizes, offsetA, numR*numSegs, std::plus<intT>(),(intT)0);
     transpose<intT,intT>(segSizes, offsetB).trans(numR, numSegs);
-    sequence::scan(offsetB, offsetB, numR*numSegs, plus<intT>(),(intT)0);
+    sequence::scan(offsetB, offsetB, numR*numSegs, std::plus<intT>(),(intT)0);
     blockTrans<E,intT>(A, B, offsetA, offsetB, segSizes).trans(numR, numSegs);
     native::parallel_for(intT(0), n, [&] (intT i) { A[i] = B[i]; });
     //nextTime("transpose");